@@ -0,0 +1,50 @@
+// Per material parameters and textures, matches MaterialBlock and MaterialSlot
+// in Source/Graphics/material.h. Bound once per material by the renderer.
+#if defined(BINDLESS_TEXTURES)
+#extension GL_ARB_bindless_texture : require
+#endif
+
+layout (std140, binding = 0) uniform MaterialBlock {
+    vec4 materialBaseColor;  // rgb and opacity
+    vec4 materialSpecular;   // rgb and shininess
+    uint materialMapMask;    // bit per slot below that has a texture
+    uvec4 materialLayers;    // page << 16 | layer per slot, 0xFFFFFFFF to read the slot's unit
+    uvec4 materialHandles[2]; // two 64-bit bindless handles each, zero to read the slot's unit
+};
+
+#define MATERIAL_DIFFUSE 0
+#define MATERIAL_SPECULAR 1
+#define MATERIAL_NORMAL 2
+#define MATERIAL_HEIGHT 3
+
+layout (binding = 0) uniform sampler2D diffuseMap;
+layout (binding = 1) uniform sampler2D specularMap;
+layout (binding = 2) uniform sampler2D normalMap;
+layout (binding = 3) uniform sampler2D heightMap;
+
+#if defined(TEXTURE_ARRAYS)
+// kTexturePageFirstUnit and kMaxTexturePages in Source/Graphics/texturepages.h
+layout (binding = 4) uniform sampler2DArray texturePages[8];
+#endif
+
+bool hasMaterialMap(int slot) {
+    return (materialMapMask & (1u << slot)) != 0u;
+}
+
+// Reads a slot from its page or handle when it has one, from its unit otherwise.
+// The page index comes from the block, so it is uniform across the draw.
+vec4 sampleMaterialMap(int slot, sampler2D unitMap, vec2 uv) {
+#if defined(BINDLESS_TEXTURES)
+    uvec4 pair = materialHandles[slot >> 1];
+    uvec2 handle = (slot & 1) == 0 ? pair.xy : pair.zw;
+    if (handle != uvec2(0u)) {
+        return texture(sampler2D(handle), uv);
+    }
+#elif defined(TEXTURE_ARRAYS)
+    uint layer = materialLayers[slot];
+    if (layer != 0xFFFFFFFFu) {
+        return texture(texturePages[layer >> 16], vec3(uv, float(layer & 0xFFFFu)));
+    }
+#endif
+    return texture(unitMap, uv);
+}
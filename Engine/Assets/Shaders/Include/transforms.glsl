@@ -0,0 +1,44 @@
+// Object to clip space. Include after vertexinput.glsl.
+//   SKINNED           blend up to BONES_PER_VERTEX bone matrices per vertex
+//   INSTANCED         per instance model matrix in locations 5-8 instead of the uniform
+uniform mat4 view;
+uniform mat4 projection;
+
+#ifdef INSTANCED
+layout (location = 5) in mat4 aModel;
+#define MODEL_MATRIX aModel
+#else
+uniform mat4 model;
+#define MODEL_MATRIX model
+#endif
+
+#ifdef SKINNED
+#ifndef BONES_PER_VERTEX
+#define BONES_PER_VERTEX 4
+#endif
+
+const int MAX_BONES = 200;
+uniform mat4 finalBonesMatrices[MAX_BONES];
+
+mat4 getSkinMatrix() {
+    mat4 skin = finalBonesMatrices[aBoneIds[0]] * aBoneWeights[0];
+#if BONES_PER_VERTEX > 1
+    skin += finalBonesMatrices[aBoneIds[1]] * aBoneWeights[1];
+#endif
+#if BONES_PER_VERTEX > 2
+    skin += finalBonesMatrices[aBoneIds[2]] * aBoneWeights[2];
+#endif
+#if BONES_PER_VERTEX > 3
+    skin += finalBonesMatrices[aBoneIds[3]] * aBoneWeights[3];
+#endif
+    return skin;
+}
+#endif
+
+vec4 getWorldPosition() {
+#ifdef SKINNED
+    return MODEL_MATRIX * getSkinMatrix() * vec4(aPosition, 1.0);
+#else
+    return MODEL_MATRIX * vec4(aPosition, 1.0);
+#endif
+}
@@ -0,0 +1,9 @@
+// Vertex layout shared by every mesh shader, matches Vertex in Source/Graphics/mesh.h
+layout (location = 0) in vec3 aPosition;
+layout (location = 1) in vec3 aColor;
+layout (location = 2) in vec2 aTexCoord;
+
+#ifdef SKINNED
+layout (location = 3) in ivec4 aBoneIds;
+layout (location = 4) in vec4 aBoneWeights;
+#endif
@@ -1,11 +1,8 @@
-#version 460 core
+#version 450 core
 
-layout (location = 0) in vec3 aPosition;
-
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+#include "Include/vertexinput.glsl"
+#include "Include/transforms.glsl"
 
 void main() {
-	gl_Position = projection * view * model * vec4(aPosition, 1.0);
-}
\ No newline at end of file
+	gl_Position = projection * view * getWorldPosition();
+}
@@ -1,15 +1,12 @@
-#version 460 core
+#version 450 core
+
+#include "Include/material.glsl"
 
 out vec4 FragColor;
 
 in vec3 ourColor;
 in vec2 texCoord;
 
-uniform sampler2D texture1;
-uniform sampler2D texture2;
-
 void main() {
-    vec4 tex1 = texture(texture1, texCoord);
-    vec4 tex2 = texture(texture2, texCoord);
-    FragColor = mix(tex1, tex2, 0.2);
+    FragColor = hasMaterialMap(MATERIAL_DIFFUSE) ? sampleMaterialMap(MATERIAL_DIFFUSE, diffuseMap, texCoord) : materialBaseColor;
 }
@@ -0,0 +1,8 @@
+// Dear ImGui and the SDL2 and OpenGL3 backends used by the performance HUD.
+// The OpenGL3 backend loads its own GL entry points, so glad stays out of this file.
+#include <imgui/imgui.cpp>
+#include <imgui/imgui_draw.cpp>
+#include <imgui/imgui_tables.cpp>
+#include <imgui/imgui_widgets.cpp>
+#include <imgui/imgui_impl_sdl2.cpp>
+#include <imgui/imgui_impl_opengl3.cpp>
@@ -1,5 +1,2 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
-
-#define STB_INCLUDE_IMPLEMENTATION
-#include <stb_include.h>
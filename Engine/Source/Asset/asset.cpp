@@ -1,5 +1,13 @@
 #include "Asset/asset.h"
+#include "Asset/asyncloader.h"
+#include "Asset/cookedanimation.h"
+#include "Asset/cookedmodel.h"
+#include "Asset/shadercache.h"
 #include "Core/file.h"
+#include "Core/memorytags.h"
+#include "Core/pack.h"
+#include "Core/profiler.h"
+#include "Core/vfs.h"
 
 #include <assimp/Logger.hpp>
 #include <assimp/DefaultLogger.hpp>
@@ -8,199 +16,473 @@
 #include <assimp/Importer.hpp>
 #include <stb_image.h>
 
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
 #include <iostream>
 #include <fstream>
 #include <sstream>
 
 Assets gAssets;
 
+namespace {
+    constexpr size_t kMegabyte = 1024 * 1024;
+
+    // Every material draws with this pair, its defines pick the permutation
+    const char* kMaterialVertexShader = "Assets/Shaders/texture.vert";
+    const char* kMaterialFragmentShader = "Assets/Shaders/texture.frag";
+
+    void destroyMaterial(Assets& assets, Material& material) {
+        for (Handle<Texture> texture : material.textures) {
+            assets.textures.release(texture);
+        }
+        assets.shaders.release(material.program);
+        assets.shaders.release(material.skinnedProgram);
+        destroyMaterialBuffer(material);
+    }
+
+    template <typename T, typename Destroy>
+    void evictOverBudget(AssetPool<T>& pool, const char* category, Destroy destroy) {
+        pool.nextFrame();
+        while (pool.isOverBudget()) {
+            Handle<T> handle = pool.findEvictionCandidate();
+            if (!handle.isValid()) {
+                break; // Everything left is referenced
+            }
+
+            spdlog::info("Evicting {} {}", category, pool.getName(handle));
+            std::unique_ptr<T> asset = pool.remove(handle);
+            destroy(*asset);
+        }
+    }
+}
+
 void loadGameAssets() {
-    auto program = loadShader(gAssets, "Assets/Shaders/skinned.vert", "Assets/Shaders/texture.frag");
-    program->use();
-    program->setUniformInt("texture1", 0);
-    program->setUniformInt("texture2", 1);
+    gAssets.textures.setBudget({ SIZE_MAX, 512 * kMegabyte });
+    gAssets.models.setBudget({ 256 * kMegabyte, 256 * kMegabyte });
+    gAssets.animations.setBudget({ 128 * kMegabyte, SIZE_MAX });
+    // Materials are cheap to rebuild and pin their textures, so they go as soon
+    // as no model uses them
+    gAssets.materials.setBudget({ 0, 0 });
+    gAssets.streaming.budget = 256 * kMegabyte;
+
+    // Decoding runs on the loader's workers, uploads trickle in from the frame loop
+    loadModelAsync(gAssets, gLoader, "Assets/Meshes/Maria J J Ong.fbx");
+
+    loadAnimationAsync(gAssets, gLoader, "Assets/Animations/Twist Dance.fbx");
+    loadAnimationAsync(gAssets, gLoader, "Assets/Animations/Dying (1).fbx");
+
+    loadTextureAsync(gAssets, gLoader, "Assets/Textures/container.jpg", "texture_diffuse");
+    loadTextureAsync(gAssets, gLoader, "Assets/Textures/awesomeface.png", "texture_diffuse");
+}
 
-    loadModel(gAssets, "Assets/Meshes/Maria J J Ong.fbx");
+bool cookGameAssets() {
+    std::vector<TextureCookReport> textureReports;
 
-    loadAnimation(gAssets, "Assets/Animations/Twist Dance.fbx");
-    loadAnimation(gAssets, "Assets/Animations/Dying (1).fbx");
+    bool success = true;
+    success &= cookModel("Assets/Meshes/Maria J J Ong.fbx", &textureReports);
+    success &= cookAnimation("Assets/Animations/Twist Dance.fbx");
+    success &= cookAnimation("Assets/Animations/Dying (1).fbx");
 
-    loadTexture(gAssets, "Assets/Textures/container.jpg", "texture_diffuse");
-    loadTexture(gAssets, "Assets/Textures/awesomeface.png", "texture_diffuse");
+    for (const char* path : { "Assets/Textures/container.jpg", "Assets/Textures/awesomeface.png" }) {
+        TextureCookReport report;
+        if (cookTexture(path, TextureUsage::Color, BlockFormat::None, &report)) {
+            textureReports.push_back(report);
+        }
+        else {
+            success = false;
+        }
+    }
+
+    writeTextureCookReport(textureReports, COOKED_DIRECTORY "texture_report.csv");
+    return success;
 }
 
-size_t generateHash(const std::string& path) {
-    std::hash<std::string> hasher;
-    return hasher(path);
+bool packGameAssets(const std::string& packPath) {
+    std::vector<std::string> files;
+    for (const char* directory : { "Assets", COOKED_DIRECTORY }) {
+        std::error_code error;
+        for (const auto& entry : std::filesystem::recursive_directory_iterator(directory, error)) {
+            std::string path = entry.path().generic_string();
+            // Program binaries only load on the driver that wrote them
+            if (entry.is_regular_file() && path.find("ShaderCache/") == std::string::npos) {
+                files.push_back(normalizePath(path));
+            }
+        }
+    }
+    std::sort(files.begin(), files.end());
+    if (!writePack(packPath, files, true)) {
+        return false;
+    }
+
+    // A deployment may ship the pack alone, so every shader has to expand
+    // with nothing but the pack mounted, includes and all
+    VirtualFileSystem packOnly;
+    if (!mountPack(packOnly, "", packPath)) {
+        return false;
+    }
+    bool shadersResolve = true;
+    for (const std::string& file : files) {
+        bool shader = file.size() >= 5 && (file.compare(file.size() - 5, 5, ".vert") == 0 || file.compare(file.size() - 5, 5, ".frag") == 0);
+        if (shader && file.rfind("Assets/Shaders/", 0) == 0) {
+            std::string source;
+            shadersResolve = preprocessShader(packOnly, file, "", source) && shadersResolve;
+        }
+    }
+    return shadersResolve;
 }
 
-size_t generateHash(const std::string& path1, const std::string& path2) {
-    auto hasher = std::hash<std::string>{};
-    auto hash1 = hasher(path1);
-    auto hash2 = hasher(path2);
-    // Simple combination technique: bit shift and exclusive OR
-    return hash1 ^ (hash2 << 1);
+void collectAssets(Assets& assets) {
+    PROFILE_ZONE("collectAssets");
+    // Models go first so the textures they release can be evicted in the same pass
+    evictOverBudget(assets.models, "model", [&](Model& model) { destroyModel(assets, model); });
+    evictOverBudget(assets.materials, "material", [&](Material& material) { destroyMaterial(assets, material); });
+    evictOverBudget(assets.animations, "animation", [](Animation&) {});
+    evictOverBudget(assets.shaders, "shader", [](ShaderProgram&) {});
+    evictOverBudget(assets.textures, "texture", [](Texture& texture) { destroyTexture(texture); });
+    updateMemoryEstimates(assets);
 }
 
-ShaderProgram* loadShader(Assets& assets, const std::string& vertexPath, const std::string& fragmentPath) {
-    Handle handle = generateHash(vertexPath, fragmentPath);
-    auto it = assets.shaders.find(handle);
-    if (it != assets.shaders.end()) {
-        return it->second.get(); 
+void updateMemoryEstimates(const Assets& assets) {
+    // The pools already know what each asset costs, including GPU copies the
+    // heap tracking never sees
+    AssetMemory models = assets.models.getMemory();
+    AssetMemory textures = assets.textures.getMemory();
+    AssetMemory animations = assets.animations.getMemory();
+    setMemoryEstimate(MemoryTag::AssetsMesh, models.cpuBytes, models.gpuBytes);
+    setMemoryEstimate(MemoryTag::AssetsTexture, textures.cpuBytes, textures.gpuBytes);
+    setMemoryEstimate(MemoryTag::Animation, animations.cpuBytes, animations.gpuBytes);
+}
+
+void logAssetStats(const Assets& assets) {
+    spdlog::info("Textures: {} resident, {} uploaded, {} duplicate uploads avoided",
+        assets.textures.size(), assets.stats.texturesUploaded, assets.stats.duplicateTexturesAvoided);
+    spdlog::info("Materials: {} resident, {} duplicates avoided", assets.materials.size(), assets.stats.duplicateMaterialsAvoided);
+    spdlog::info("Shaders: {} compiled, {} from the binary cache, {:.2f} ms on the main thread, {} still compiling",
+        assets.stats.shadersCompiled, assets.stats.shadersFromCache, assets.stats.shaderMilliseconds, assets.pendingShaders.size());
+    logTextureStreaming(assets.streaming);
+    logTexturePages();
+}
+
+Handle<ShaderProgram> loadShader(Assets& assets, const std::string& vertexPath, const std::string& fragmentPath, const ShaderDefines& defines) {
+    PROFILE_ZONE("loadShader");
+    MemoryTagScope memoryTag(MemoryTag::Render);
+    // Every permutation of a source pair is its own program
+    std::string definesText = getShaderDefinesText(defines);
+    AssetId id = hashCombine(makeAssetId(vertexPath, fragmentPath), hash64(definesText));
+    std::string name = normalizePath(vertexPath) + "|" + normalizePath(fragmentPath);
+    if (!defines.empty()) {
+        name += "|" + getShaderPermutationName(defines);
+    }
+    Handle<ShaderProgram> handle = assets.shaders.find(id, name);
+    if (handle.isValid()) {
+        return handle;
     }
 
     try {
-        // Open files and read into streams
-        std::string vertexCode = readFileToString(vertexPath);
-        std::string fragmentCode = readFileToString(fragmentPath);
+        auto start = std::chrono::steady_clock::now();
 
-        // Create and compile shaders
-        auto vertexShader = std::make_shared<Shader>(vertexCode, GL_VERTEX_SHADER);
-        auto fragmentShader = std::make_shared<Shader>(fragmentCode, GL_FRAGMENT_SHADER);
+        // Read, resolve includes and inject the permutation defines
+        std::string vertexCode;
+        std::string fragmentCode;
+        if (!preprocessShader(vertexPath, definesText, vertexCode) || !preprocessShader(fragmentPath, definesText, fragmentCode)) {
+            return {};
+        }
+        auto read = std::chrono::steady_clock::now();
 
-        // Link shaders into a program
+        // Same expanded sources on the same driver link to the same binary, skip the compile
+        uint64_t cacheKey = makeShaderCacheKey({ vertexCode, fragmentCode }, definesText);
         auto program = std::make_unique<ShaderProgram>();
-        program->attach(vertexShader);
-        program->attach(fragmentShader);
-        program->link();
-
-        assets.shaders[handle] = std::move(program);
+        if (loadCachedProgram(cacheKey, *program)) {
+            auto end = std::chrono::steady_clock::now();
+            float readMilliseconds = std::chrono::duration<float, std::milli>(read - start).count();
+            float buildMilliseconds = std::chrono::duration<float, std::milli>(end - read).count();
+            spdlog::info("Shader {} ready in {:.2f} ms (preprocess {:.2f} ms, cached binary {:.2f} ms)", name,
+                readMilliseconds + buildMilliseconds, readMilliseconds, buildMilliseconds);
+
+            assets.stats.shadersFromCache++;
+            assets.stats.shaderMilliseconds += readMilliseconds + buildMilliseconds;
+            return assets.shaders.add(id, name, std::move(program));
+        }
 
-        return assets.shaders[handle].get();
+        // Hand the sources to the driver and come back for the result later, so
+        // every permutation loaded this frame compiles at the same time
+        program = std::make_unique<ShaderProgram>();
+        program->attach(std::make_shared<Shader>(vertexCode, GL_VERTEX_SHADER));
+        program->attach(std::make_shared<Shader>(fragmentCode, GL_FRAGMENT_SHADER));
+        program->setBinaryRetrievable();
+        program->submit();
+
+        PendingShader pending;
+        pending.name = name;
+        pending.cacheKey = cacheKey;
+        pending.submitted = std::chrono::steady_clock::now();
+        pending.submitMilliseconds = std::chrono::duration<float, std::milli>(pending.submitted - start).count();
+        pending.handle = assets.shaders.add(id, name, std::move(program));
+        assets.pendingShaders.push_back(pending);
+        return pending.handle;
     }
     catch (const std::exception& e) {
         spdlog::error("ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: {}", e.what());
-        return nullptr; // Return a nullptr to indicate failure
+        return {}; // Return an invalid handle to indicate failure
     }
 }
 
-Texture* loadTexture(Assets& assets, const std::string& filePath, const std::string& type) {
+namespace {
+    void finishShader(Assets& assets, const PendingShader& pending, ShaderProgram& program) {
+        auto start = std::chrono::steady_clock::now();
+        bool linked = program.finish();
+        if (linked) {
+            storeCachedProgram(pending.cacheKey, program);
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        float finishMilliseconds = std::chrono::duration<float, std::milli>(end - start).count();
+        float totalMilliseconds = std::chrono::duration<float, std::milli>(end - pending.submitted).count() + pending.submitMilliseconds;
+        if (linked) {
+            spdlog::info("Shader {} ready in {:.2f} ms (submit {:.2f} ms, status check {:.2f} ms)", pending.name,
+                totalMilliseconds, pending.submitMilliseconds, finishMilliseconds);
+        }
+        else {
+            spdlog::error("Shader {} failed to compile or link", pending.name);
+        }
 
-    Handle handle = generateHash(filePath);
-    auto it = assets.textures.find(handle);
-    if (it != assets.textures.end()) {
-        spdlog::warn("Texture has already been loaded: {}", filePath);
-        return it->second.get();
+        assets.stats.shadersCompiled++;
+        assets.stats.shaderMilliseconds += pending.submitMilliseconds + finishMilliseconds;
     }
+}
 
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_2D, textureID);
+void updateShaders(Assets& assets) {
+    PROFILE_ZONE("updateShaders");
+    auto& pending = assets.pendingShaders;
+    for (size_t i = 0; i < pending.size();) {
+        ShaderProgram* program = assets.shaders.get(pending[i].handle);
+        if (program && !program->isComplete()) {
+            i++;
+            continue;
+        }
+        if (program) {
+            finishShader(assets, pending[i], *program);
+        }
+        pending[i] = pending.back();
+        pending.pop_back();
+    }
+}
 
-    // Texture Wrapping Parameters
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+bool waitForShader(Assets& assets, Handle<ShaderProgram> handle) {
+    ShaderProgram* program = assets.shaders.get(handle);
+    if (!program) {
+        return false;
+    }
 
-    // Texture Filtering Parameters
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    auto& pending = assets.pendingShaders;
+    auto it = std::find_if(pending.begin(), pending.end(), [&](const PendingShader& p) { return p.handle == handle; });
+    if (it != pending.end()) {
+        finishShader(assets, *it, *program);
+        pending.erase(it);
+    }
+    return program->isLinked();
+}
 
-    int width, height, nrChannels;
-    unsigned char* data = stbi_load(filePath.c_str(), &width, &height, &nrChannels, 0);
-    if (data) {
-        GLenum format = GL_RGB;
-        if (nrChannels == 1)
-            format = GL_RED;
-        else if (nrChannels == 3)
-            format = GL_RGB;
-        else if (nrChannels == 4)
-            format = GL_RGBA;
+Handle<Texture> loadTexture(Assets& assets, const std::string& filePath, const std::string& type) {
+    PROFILE_ZONE("loadTexture");
+    MemoryTagScope memoryTag(MemoryTag::AssetsTexture);
+    Handle<Texture> handle = assets.textures.find(makeAssetId(filePath), normalizePath(filePath));
+    if (handle.isValid()) {
+        assets.stats.duplicateTexturesAvoided++;
+        return handle;
+    }
 
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-        stbi_image_free(data);
+    auto cooked = std::make_shared<CookedImage>();
+    if (openCookedTexture(filePath, *cooked)) {
+        return addCookedTexture(assets, filePath, type, std::move(cooked));
     }
-    else {
+
+    Image image;
+    if (!loadImage(filePath, image)) {
         spdlog::error("Failed to load texture from path: {}", filePath);
-        stbi_image_free(data); // ensure memory is freed in case of failure
-        glDeleteTextures(1, &textureID); // Delete the texture if loading failed
-        return nullptr;
+        return {};
+    }
+    expandToRgba(image);
+
+    return addTexture(assets, filePath, type, image);
+}
+
+Handle<Texture> addCookedTexture(Assets& assets, const std::string& filePath, const std::string& type, std::shared_ptr<CookedImage> cooked) {
+    PROFILE_ZONE("addCookedTexture");
+    MemoryTagScope memoryTag(MemoryTag::AssetsTexture);
+    AssetId id = makeAssetId(filePath);
+    std::string name = normalizePath(filePath);
+    Handle<Texture> handle = assets.textures.find(id, name);
+    if (handle.isValid()) {
+        assets.stats.duplicateTexturesAvoided++;
+        return handle;
+    }
+
+    uint32_t tailMip = getStreamingTailMip(*cooked);
+    unsigned int textureID = uploadCookedTexture(*cooked, tailMip);
+    if (textureID == 0) {
+        // The source is still there; a driver that rejects the blocks gets pixels
+        spdlog::warn("Failed to upload cooked texture, decoding the source: {}", filePath);
+        Image image;
+        if (!loadImage(filePath, image)) {
+            spdlog::error("Failed to load texture from path: {}", filePath);
+            return {};
+        }
+        expandToRgba(image);
+        return addTexture(assets, filePath, type, image);
     }
 
     auto texture = std::make_unique<Texture>();
     texture->id = textureID;
     texture->type = type;
 
-    assets.textures[handle] = std::move(texture);
-
-    spdlog::info("Texture loaded");
+    spdlog::info("Cooked texture loaded {} ({}, mips {}+)", filePath, getBlockFormatName((BlockFormat)cooked->header->format), tailMip);
+    assets.stats.texturesUploaded++;
 
-    return assets.textures[handle].get();
+    AssetMemory memory;
+    memory.gpuBytes = getCookedTextureMemory(*cooked, tailMip);
+    handle = assets.textures.add(id, name, std::move(texture), memory);
+    streamTexture(assets.streaming, handle, std::move(cooked), tailMip);
+    return handle;
 }
 
-Model* loadModel(Assets& assets, const std::string& filePath) {
-    Handle handle = generateHash(filePath);
-    auto it = assets.models.find(handle);
-    if (it != assets.models.end()) {
-        spdlog::info("Model has already been loaded {}", filePath);
-        return it->second.get();
+Handle<Texture> addTexture(Assets& assets, const std::string& filePath, const std::string& type, const Image& image) {
+    PROFILE_ZONE("addTexture");
+    MemoryTagScope memoryTag(MemoryTag::AssetsTexture);
+    AssetId id = makeAssetId(filePath);
+    std::string name = normalizePath(filePath);
+    Handle<Texture> handle = assets.textures.find(id, name);
+    if (handle.isValid()) {
+        assets.stats.duplicateTexturesAvoided++;
+        return handle;
     }
 
-    Assimp::Importer importer;
-    importer.SetPropertyBool(AI_CONFIG_IMPORT_FBX_PRESERVE_PIVOTS, false);
-
-    unsigned flags = aiProcess_Triangulate | aiProcess_SortByPType | aiProcess_JoinIdenticalVertices |
-        aiProcess_FixInfacingNormals | aiProcess_GenUVCoords | aiProcess_OptimizeMeshes;
+    unsigned int textureID = uploadImage(image);
+    if (textureID == 0) {
+        spdlog::error("Failed to upload texture: {}", filePath);
+        return {};
+    }
 
-    const aiScene* scene = importer.ReadFile(filePath, flags);
+    auto texture = std::make_unique<Texture>();
+    texture->id = textureID;
+    texture->type = type;
+    texture->width = image.width;
+    texture->height = image.height;
+    texture->channels = image.channels;
 
-    if (scene == nullptr) {
-        spdlog::error("Assimp Import Error (null scene): {}", importer.GetErrorString());
-        return nullptr;
-    }
+    spdlog::info("Texture loaded");
+    assets.stats.texturesUploaded++;
 
-    if (scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE) {
-        std::string const errorString = importer.GetErrorString();
+    AssetMemory memory;
+    memory.gpuBytes = getTextureMemory(image.width, image.height, image.channels);
+    return assets.textures.add(id, name, std::move(texture), memory);
+}
 
-        if (!errorString.empty()) {
-            spdlog::error("Assimp Import Error (incomplete scene): {}", importer.GetErrorString());
-            return nullptr;
+Handle<Model> loadModel(Assets& assets, const std::string& filePath, bool retainMeshData) {
+    PROFILE_ZONE("loadModel");
+    MemoryTagScope memoryTag(MemoryTag::AssetsMesh);
+    AssetId id = makeAssetId(filePath);
+    std::string name = normalizePath(filePath);
+    Handle<Model> handle = assets.models.find(id, name);
+    if (handle.isValid()) {
+        spdlog::info("Model has already been loaded {}", filePath);
+        const Model* model = assets.models.get(handle);
+        if (retainMeshData && model && !model->retainsMeshData) {
+            spdlog::warn("Model {} was loaded without its CPU mesh data", filePath);
         }
-        spdlog::warn("Assimp flagged incomplete scene");
+        return handle;
     }
 
-    if (scene->mRootNode == nullptr) {
-        spdlog::error("No root node for model, cannot process");
-        return nullptr;
-    }
+    auto start = std::chrono::steady_clock::now();
 
     auto model = std::make_unique<Model>();
-    model->directory = filePath.substr(0, filePath.find_last_of("/\\"));
-    processNode(scene->mRootNode, scene, *model);
-
-    assets.models[handle] = std::move(model);
+    bool cooked = loadCookedModel(filePath, *model, retainMeshData);
+    if (!cooked) {
+        // Missing or stale cooked file, import the source and cook it for next time
+        ModelData data;
+        if (!importModel(filePath, data)) {
+            return {};
+        }
+        writeCookedModel(filePath, data);
+        uploadModel(data, *model, retainMeshData);
+    }
 
-    spdlog::info("Model loaded");
+    float milliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    spdlog::info("Model loaded {} ({}, {:.2f} ms)", filePath, cooked ? "cooked" : "assimp", milliseconds);
 
-    return assets.models[handle].get();
+    AssetMemory memory = getModelMemory(*model);
+    return assets.models.add(id, name, std::move(model), memory);
 }
 
-Animation* loadAnimation(Assets& assets, const std::string& filePath) {
-    Handle handle = generateHash(filePath);
-    auto it = assets.animations.find(handle);
-    if (it != assets.animations.end()) {
+Handle<Animation> loadAnimation(Assets& assets, const std::string& filePath) {
+    PROFILE_ZONE("loadAnimation");
+    MemoryTagScope memoryTag(MemoryTag::Animation);
+    AssetId id = makeAssetId(filePath);
+    std::string name = normalizePath(filePath);
+    Handle<Animation> handle = assets.animations.find(id, name);
+    if (handle.isValid()) {
         spdlog::info("Animation has already been loaded {}", filePath);
-        return it->second.get();
+        return handle;
     }
 
-    Assimp::Importer importer;
-    importer.SetPropertyBool(AI_CONFIG_IMPORT_FBX_PRESERVE_PIVOTS, false);
-    const aiScene* scene = importer.ReadFile(filePath, aiProcess_Triangulate);
-    assert(scene && scene->mRootNode);
+    auto start = std::chrono::steady_clock::now();
 
     auto animation = std::make_unique<Animation>();
-    animation->m_Duration = scene->mAnimations[0]->mDuration;
-    animation->m_TicksPerSecond = scene->mAnimations[0]->mTicksPerSecond;
-
-    aiMatrix4x4 globalTransformation = scene->mRootNode->mTransformation;
-    globalTransformation = globalTransformation.Inverse();
+    bool cooked = loadCookedAnimation(filePath, *animation);
+    if (!cooked && !importAnimation(filePath, *animation)) {
+        return {};
+    }
 
-    animation->readHierarchyData(animation->m_RootNode, scene->mRootNode);
-    animation->readMissingBones(scene->mAnimations[0]);
+    float milliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    spdlog::info("Animation loaded {} ({}, {:.2f} ms)", filePath, cooked ? "cooked" : "assimp", milliseconds);
 
-    assets.animations[handle] = std::move(animation);
+    AssetMemory memory;
+    memory.cpuBytes = animation->getDataSize();
+    return assets.animations.add(id, name, std::move(animation), memory);
+}
 
-    spdlog::info("Animation loaded");
+Handle<Material> addMaterial(Assets& assets, const MaterialDesc& desc) {
+    AssetId textureIds[kMaterialSlotCount] = {};
+    for (uint32_t slot = 0; slot < kMaterialSlotCount; slot++) {
+        textureIds[slot] = assets.textures.getId(desc.textures[slot]);
+    }
+    AssetId id = makeMaterialId(desc, textureIds);
+    std::string name = fmt::format("material#{:016x}", id);
+    Handle<Material> handle = assets.materials.find(id, name);
+    if (handle.isValid()) {
+        assets.stats.duplicateMaterialsAvoided++;
+        return handle;
+    }
 
-    return assets.animations[handle].get();
-}
\ No newline at end of file
+    auto material = std::make_unique<Material>();
+    material->defines = desc.defines;
+    material->block.params = desc.params;
+    for (uint32_t slot = 0; slot < kMaterialSlotCount; slot++) {
+        Texture* texture = assets.textures.get(desc.textures[slot]);
+        if (texture) {
+            material->textures[slot] = desc.textures[slot];
+            setMaterialTexture(*material, static_cast<MaterialSlot>(slot), *texture);
+            assets.textures.addRef(desc.textures[slot]);
+        }
+    }
+    // The mode is fixed for the run, so it stays out of the material ID
+    appendTextureBindingDefines(material->defines);
+
+    // The scene submits the default permutations up front, so these are usually
+    // already compiling or linked
+    ShaderDefines skinnedDefines = material->defines;
+    skinnedDefines.push_back({ "SKINNED", "" });
+    skinnedDefines.push_back({ "BONES_PER_VERTEX", "4" });
+    material->program = loadShader(assets, kMaterialVertexShader, kMaterialFragmentShader, material->defines);
+    material->skinnedProgram = loadShader(assets, kMaterialVertexShader, kMaterialFragmentShader, skinnedDefines);
+    assets.shaders.addRef(material->program);
+    assets.shaders.addRef(material->skinnedProgram);
+
+    uploadMaterial(*material);
+
+    AssetMemory memory;
+    memory.cpuBytes = sizeof(Material);
+    memory.gpuBytes = sizeof(MaterialBlock);
+    return assets.materials.add(id, name, std::move(material), memory);
+}
@@ -2,6 +2,11 @@
 #ifndef ASSET_MANAGER_H
 #define ASSET_MANAGER_H
 
+#include "Asset/cookedtexture.h"
+#include "Asset/handle.h"
+#include "Asset/shadersource.h"
+#include "Asset/texturestreaming.h"
+#include "Graphics/material.h"
 #include "Graphics/model.h"
 #include "Graphics/texture.h"
 #include "Graphics/shader.h"
@@ -9,28 +14,82 @@
 
 #include <spdlog/spdlog.h>
 
+#include <chrono>
 #include <functional>
 #include <map>
 #include <unordered_map>
 
-using Handle = size_t;
+struct AssetStats {
+    size_t texturesUploaded = 0;
+    size_t duplicateTexturesAvoided = 0; // requests served by an image that was already uploaded
+
+    size_t duplicateMaterialsAvoided = 0; // meshes that found an identical material already loaded
+
+    size_t shadersCompiled = 0;
+    size_t shadersFromCache = 0;
+    float shaderMilliseconds = 0.0f; // main thread time only, a background compile is not counted
+};
+
+// A program whose compile and link were submitted but not checked yet
+struct PendingShader {
+    Handle<ShaderProgram> handle;
+    std::string name;
+    uint64_t cacheKey = 0;
+    std::chrono::steady_clock::time_point submitted;
+    float submitMilliseconds = 0.0f;
+};
 
 struct Assets {
-    std::unordered_map<Handle, std::unique_ptr<Texture>> textures;
-    std::unordered_map<Handle, std::unique_ptr<Model>> models;
-    std::unordered_map<Handle, std::unique_ptr<Animation>> animations;
-    std::unordered_map<Handle, std::unique_ptr<ShaderProgram>> shaders;
+    AssetStats stats;
+    AssetPool<Texture> textures;
+    AssetPool<Model> models;
+    AssetPool<Animation> animations;
+    AssetPool<ShaderProgram> shaders;
+    AssetPool<Material> materials;
+    TextureStreaming streaming;
+    std::vector<PendingShader> pendingShaders;
 };
 
 void loadGameAssets();
 
-Handle generateHash(const std::string& path);
-Handle generateHash(const std::string& path1, const std::string& path2);
+// Offline cook of everything loadGameAssets uses, run with --cook
+bool cookGameAssets();
+// Packs Assets/ and Cooked/ into one archive, run with --pack after --cook
+bool packGameAssets(const std::string& packPath);
+
+// Evicts least recently used, unreferenced assets from every category that is
+// over its budget. Called once per frame on the GL thread.
+void collectAssets(Assets& assets);
+// Hands the pools' CPU and GPU totals to the memory tags, collectAssets does this every frame
+void updateMemoryEstimates(const Assets& assets);
+
+void logAssetStats(const Assets& assets);
+
+// Finishes the programs the driver is done with, without blocking when
+// KHR_parallel_shader_compile is available. Called once per frame on the GL thread.
+void updateShaders(Assets& assets);
+// Blocks until one program is linked, for the few that have to be usable right away
+bool waitForShader(Assets& assets, Handle<ShaderProgram> handle);
 
-ShaderProgram* loadShader(Assets& assets, const std::string& vertexPath, const std::string& fragmentPath);
-Texture* loadTexture(Assets& assets, const std::string& filePath, const std::string& type);
-Model* loadModel(Assets& assets, const std::string& filePath);
-Animation* loadAnimation(Assets& assets, const std::string& filePath);
+// Loaders return an invalid handle on failure. Loading does not add a reference;
+// whoever keeps the handle around calls addRef/release on the pool.
+// A shader that is not in the binary cache comes back still compiling, check
+// ShaderProgram::isLinked before drawing with it.
+// Meshes drop their CPU copies after upload; pass retainMeshData for models
+// that collision, picking or CPU skinning read back. It only takes effect on
+// the load that creates the model.
+Handle<ShaderProgram> loadShader(Assets& assets, const std::string& vertexPath, const std::string& fragmentPath, const ShaderDefines& defines = {});
+Handle<Texture> loadTexture(Assets& assets, const std::string& filePath, const std::string& type);
+// Registers an image that was decoded elsewhere, uploading it on the calling thread
+Handle<Texture> addTexture(Assets& assets, const std::string& filePath, const std::string& type, const Image& image);
+// Same for a block compressed texture mapped from the cook output. Only the mip
+// tail is uploaded, the rest is streamed in as the scene needs it.
+Handle<Texture> addCookedTexture(Assets& assets, const std::string& filePath, const std::string& type, std::shared_ptr<CookedImage> cooked);
+Handle<Model> loadModel(Assets& assets, const std::string& filePath, bool retainMeshData = false);
+Handle<Animation> loadAnimation(Assets& assets, const std::string& filePath);
+// Finds the material with the same content or creates it, taking references on
+// its textures and on both of its shader permutations. GL thread only.
+Handle<Material> addMaterial(Assets& assets, const MaterialDesc& desc);
 
 extern Assets gAssets;
 
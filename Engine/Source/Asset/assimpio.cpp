@@ -0,0 +1,75 @@
+#include "Asset/assimpio.h"
+
+#include <spdlog/spdlog.h>
+
+#include <cstring>
+
+MappedIOStream::MappedIOStream(MappedFile&& file) : m_File(std::move(file)) {}
+
+size_t MappedIOStream::Read(void* buffer, size_t size, size_t count) {
+    if (size == 0) {
+        return 0;
+    }
+    size_t available = (m_File.size - m_Position) / size;
+    size_t read = count < available ? count : available;
+    std::memcpy(buffer, m_File.data + m_Position, read * size);
+    m_Position += read * size;
+    return read;
+}
+
+size_t MappedIOStream::Write(const void*, size_t, size_t) {
+    return 0;
+}
+
+aiReturn MappedIOStream::Seek(size_t offset, aiOrigin origin) {
+    size_t position;
+    switch (origin) {
+    case aiOrigin_SET: position = offset; break;
+    case aiOrigin_CUR: position = m_Position + offset; break;
+    case aiOrigin_END: position = m_File.size - offset; break;
+    default: return aiReturn_FAILURE;
+    }
+    if (position > m_File.size) {
+        return aiReturn_FAILURE;
+    }
+    m_Position = position;
+    return aiReturn_SUCCESS;
+}
+
+size_t MappedIOStream::Tell() const {
+    return m_Position;
+}
+
+size_t MappedIOStream::FileSize() const {
+    return m_File.size;
+}
+
+void MappedIOStream::Flush() {}
+
+bool MappedIOSystem::Exists(const char* filePath) const {
+    return virtualFileExists(gVFS, filePath);
+}
+
+char MappedIOSystem::getOsSeparator() const {
+    return '/';
+}
+
+Assimp::IOStream* MappedIOSystem::Open(const char* filePath, const char* mode) {
+    // Importers only ever read
+    if (std::strchr(mode, 'w') || std::strchr(mode, 'a')) {
+        return nullptr;
+    }
+
+    MappedFile file;
+    FileError error = mapVirtualFile(gVFS, filePath, file);
+    if (error != FileError::None) {
+        // Importers probe for optional files, so a miss is not worth more than a debug line
+        spdlog::debug("Assimp could not open {}: {}", filePath, getFileErrorName(error));
+        return nullptr;
+    }
+    return new MappedIOStream(std::move(file));
+}
+
+void MappedIOSystem::Close(Assimp::IOStream* stream) {
+    delete stream;
+}
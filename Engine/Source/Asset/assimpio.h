@@ -0,0 +1,37 @@
+#pragma once
+#ifndef ASSIMP_IO_H
+#define ASSIMP_IO_H
+
+#include "Core/vfs.h"
+
+#include <assimp/IOStream.hpp>
+#include <assimp/IOSystem.hpp>
+
+// Read-only assimp file system over the virtual file system's mapped files, so
+// importers and the files they pull in (materials, buffers) come from packs or
+// the page cache instead of stdio. Install with importer.SetIOHandler(new MappedIOSystem).
+class MappedIOStream : public Assimp::IOStream {
+public:
+    explicit MappedIOStream(MappedFile&& file);
+
+    size_t Read(void* buffer, size_t size, size_t count) override;
+    size_t Write(const void* buffer, size_t size, size_t count) override;
+    aiReturn Seek(size_t offset, aiOrigin origin) override;
+    size_t Tell() const override;
+    size_t FileSize() const override;
+    void Flush() override;
+
+private:
+    MappedFile m_File;
+    size_t m_Position = 0;
+};
+
+class MappedIOSystem : public Assimp::IOSystem {
+public:
+    bool Exists(const char* filePath) const override;
+    char getOsSeparator() const override;
+    Assimp::IOStream* Open(const char* filePath, const char* mode = "rb") override;
+    void Close(Assimp::IOStream* stream) override;
+};
+
+#endif
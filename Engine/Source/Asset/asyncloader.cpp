@@ -0,0 +1,374 @@
+#include "Asset/asyncloader.h"
+#include "Asset/cookedanimation.h"
+#include "Asset/cookedmodel.h"
+#include "Core/memorytags.h"
+#include "Core/profiler.h"
+
+#include <glad/glad.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <vector>
+
+AsyncLoader gLoader;
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    float elapsedMilliseconds(Clock::time_point start) {
+        return std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+    }
+
+    template <typename T>
+    void publishRequest(AssetPool<T>& pool, LoadRequest<T>& request) {
+        request.asset = pool.get(request.handle);
+        if (request.asset) {
+            pool.addRef(request.handle);
+            request.pool = &pool;
+        }
+        request.state.store(request.asset ? LoadState::Ready : LoadState::Failed, std::memory_order_release);
+    }
+
+    template <typename T>
+    std::shared_ptr<LoadRequest<T>> makeReadyRequest(AssetPool<T>& pool, Handle<T> handle) {
+        auto request = std::make_shared<LoadRequest<T>>();
+        request->handle = handle;
+        publishRequest(pool, *request);
+        return request;
+    }
+
+    template <typename T>
+    void finishRequest(AsyncLoader& loader, std::unordered_map<AssetId, std::shared_ptr<LoadRequest<T>>>& requests, AssetId id, AssetPool<T>& pool, LoadRequest<T>& request) {
+        publishRequest(pool, request);
+        requests.erase(id);
+        loader.inFlight--;
+    }
+
+    // Everything a model needs from the workers before it can be uploaded
+    struct ModelPayload {
+        bool cooked = false;
+        bool imported = false;
+        CookedModel cookedModel;
+        ModelData data;
+        std::vector<TextureSource> textures;
+        std::vector<MaterialRef> materials;
+    };
+
+    struct AnimationPayload {
+        bool cooked = false;
+        bool loaded = false;
+        std::unique_ptr<Animation> animation;
+    };
+}
+
+void queueUpload(AsyncLoader& loader, size_t cost, std::function<void()> run) {
+    {
+        std::lock_guard<std::mutex> lock(loader.uploadMutex);
+        loader.uploads.push_back(UploadTask{ cost, std::move(run) });
+    }
+    loader.uploadReady.notify_one();
+}
+
+void startAsyncLoader(AsyncLoader& loader, unsigned int threadCount) {
+    loader.workers.start(threadCount);
+    spdlog::info("Async loader started with {} workers", loader.workers.getThreadCount());
+}
+
+void stopAsyncLoader(AsyncLoader& loader) {
+    loader.workers.stop();
+
+    // The context is going away, results that were never uploaded are dropped
+    std::lock_guard<std::mutex> lock(loader.uploadMutex);
+    loader.uploads.clear();
+}
+
+void processUploads(AsyncLoader& loader, size_t budget) {
+    PROFILE_ZONE("processUploads");
+    // Frees upload buffers for the workers and finishes mip chains, without waiting
+    updateTextureUploads();
+    size_t spent = 0;
+    for (;;) {
+        UploadTask task;
+        {
+            std::lock_guard<std::mutex> lock(loader.uploadMutex);
+            if (loader.uploads.empty()) {
+                return;
+            }
+            if (spent > 0 && spent + loader.uploads.front().cost > budget) {
+                return;
+            }
+            task = std::move(loader.uploads.front());
+            loader.uploads.pop_front();
+        }
+        task.run();
+        spent += task.cost;
+    }
+}
+
+void waitForLoads(AsyncLoader& loader) {
+    while (loader.inFlight > 0) {
+        {
+            std::unique_lock<std::mutex> lock(loader.uploadMutex);
+            loader.uploadReady.wait(lock, [&] { return !loader.uploads.empty(); });
+        }
+        processUploads(loader, SIZE_MAX);
+    }
+}
+
+AssetFuture<Texture> loadTextureAsync(Assets& assets, AsyncLoader& loader, const std::string& filePath, const std::string& type) {
+    AssetId id = makeAssetId(filePath);
+    Handle<Texture> handle = assets.textures.find(id, normalizePath(filePath));
+    if (handle.isValid()) {
+        assets.stats.duplicateTexturesAvoided++;
+        return AssetFuture<Texture>(makeReadyRequest(assets.textures, handle));
+    }
+
+    auto pending = loader.textureRequests.find(id);
+    if (pending != loader.textureRequests.end()) {
+        assets.stats.duplicateTexturesAvoided++;
+        return AssetFuture<Texture>(pending->second);
+    }
+
+    auto request = std::make_shared<LoadRequest<Texture>>();
+    loader.textureRequests[id] = request;
+    loader.inFlight++;
+
+    Assets* assetsPtr = &assets;
+    AsyncLoader* loaderPtr = &loader;
+    Clock::time_point start = Clock::now();
+    loader.workers.submit([=]() mutable {
+        PROFILE_ZONE("Load texture");
+        MemoryTagScope memoryTag(MemoryTag::AssetsTexture);
+        // Prefer the cooked, block compressed texture; decode the source otherwise
+        auto cooked = std::make_shared<CookedImage>();
+        auto image = std::make_shared<Image>();
+        bool isCooked = openCookedTexture(filePath, *cooked);
+        bool decoded = !isCooked && loadImage(filePath, *image);
+        // Straight into an upload buffer when one is free, the GL thread then only
+        // issues the transfer
+        if (decoded && !stageImage(*image)) {
+            expandToRgba(*image);
+        }
+        size_t cost = isCooked ? getCookedTextureMemory(*cooked, getStreamingTailMip(*cooked)) : decoded ? size_t(image->width) * image->height * image->channels : 0;
+
+        queueUpload(*loaderPtr, cost, [=, request = std::move(request)]() {
+            PROFILE_ZONE("Upload texture");
+            if (isCooked) {
+                request->handle = addCookedTexture(*assetsPtr, filePath, type, cooked);
+            }
+            else if (decoded) {
+                request->handle = addTexture(*assetsPtr, filePath, type, *image);
+            }
+            else {
+                spdlog::error("Failed to load texture from path: {}", filePath);
+            }
+            spdlog::info("Texture {} finished in {:.2f} ms", filePath, elapsedMilliseconds(start));
+            finishRequest(*loaderPtr, loaderPtr->textureRequests, id, assetsPtr->textures, *request);
+        });
+    });
+
+    return AssetFuture<Texture>(request);
+}
+
+void benchmarkTextureLoading(AsyncLoader& loader, const std::string& directory) {
+    std::vector<std::string> files;
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+        if (entry.is_regular_file()) {
+            files.push_back(entry.path().generic_string());
+        }
+    }
+    std::sort(files.begin(), files.end());
+    if (files.empty()) {
+        spdlog::warn("No textures to benchmark in {}", directory);
+        return;
+    }
+
+    // Source images only, nothing goes through the asset pool or the cook output
+    auto textures = std::make_shared<std::vector<unsigned int>>();
+    auto deleteTextures = [&]() {
+        glDeleteTextures((GLsizei)textures->size(), textures->data());
+        textures->clear();
+    };
+
+    // Baseline: decode and upload on the GL thread, driver converts RGB
+    shutdownTextureUploads();
+    Clock::time_point start = Clock::now();
+    for (const std::string& file : files) {
+        Image image;
+        if (loadImage(file, image)) {
+            textures->push_back(uploadImage(image));
+        }
+    }
+    glFinish();
+    float serialMilliseconds = elapsedMilliseconds(start);
+    deleteTextures();
+
+    // Workers decode and expand to RGBA straight into the PBO ring, the GL thread
+    // only issues the transfers
+    initTextureUploads();
+    auto glThreadMilliseconds = std::make_shared<float>(0.0f);
+    AsyncLoader* loaderPtr = &loader;
+    start = Clock::now();
+    for (const std::string& file : files) {
+        loader.inFlight++;
+        loader.workers.submit([=]() {
+            auto image = std::make_shared<Image>();
+            if (loadImage(file, *image) && !stageImage(*image)) {
+                expandToRgba(*image);
+            }
+
+            size_t cost = size_t(image->width) * image->height * image->channels;
+            queueUpload(*loaderPtr, cost, [=]() {
+                Clock::time_point uploadStart = Clock::now();
+                if (image->pixels) {
+                    textures->push_back(uploadImage(*image));
+                }
+                *glThreadMilliseconds += elapsedMilliseconds(uploadStart);
+                loaderPtr->inFlight--;
+            });
+        });
+    }
+    waitForLoads(loader);
+    finishTextureUploads();
+    glFinish();
+    float threadedMilliseconds = elapsedMilliseconds(start);
+    size_t uploaded = textures->size();
+    deleteTextures();
+
+    spdlog::info("Texture benchmark, {} files in {}: serial {:.2f} ms, threaded decode + PBO {:.2f} ms ({:.2f} ms on the GL thread, {} uploaded)",
+        files.size(), directory, serialMilliseconds, threadedMilliseconds, *glThreadMilliseconds, uploaded);
+}
+
+AssetFuture<Model> loadModelAsync(Assets& assets, AsyncLoader& loader, const std::string& filePath, bool retainMeshData) {
+    AssetId id = makeAssetId(filePath);
+    std::string name = normalizePath(filePath);
+    Handle<Model> handle = assets.models.find(id, name);
+    if (handle.isValid()) {
+        return AssetFuture<Model>(makeReadyRequest(assets.models, handle));
+    }
+
+    auto pending = loader.modelRequests.find(id);
+    if (pending != loader.modelRequests.end()) {
+        return AssetFuture<Model>(pending->second);
+    }
+
+    auto request = std::make_shared<LoadRequest<Model>>();
+    loader.modelRequests[id] = request;
+    loader.inFlight++;
+
+    Assets* assetsPtr = &assets;
+    AsyncLoader* loaderPtr = &loader;
+    Clock::time_point start = Clock::now();
+    loader.workers.submit([=]() mutable {
+        PROFILE_ZONE("Load model");
+        MemoryTagScope memoryTag(MemoryTag::AssetsMesh);
+        auto payload = std::make_shared<ModelPayload>();
+        size_t cost = 0;
+
+        payload->cooked = openCookedModel(filePath, payload->cookedModel);
+        if (payload->cooked) {
+            payload->textures = getTextureSources(payload->cookedModel);
+            payload->materials = getMaterialRefs(payload->cookedModel);
+            for (uint32_t i = 0; i < payload->cookedModel.header->meshCount; i++) {
+                const CookedMesh& mesh = payload->cookedModel.meshes[i];
+                cost += mesh.vertexCount * sizeof(Vertex) + mesh.indexCount * sizeof(unsigned int);
+            }
+        }
+        else if (importModel(filePath, payload->data)) {
+            payload->imported = true;
+            writeCookedModel(filePath, payload->data);
+            payload->textures = getTextureSources(payload->data);
+            payload->materials = payload->data.materials;
+            for (const MeshData& mesh : payload->data.meshes) {
+                cost += mesh.vertices.size() * sizeof(Vertex) + mesh.indices.size() * sizeof(unsigned int);
+            }
+        }
+
+        decodeTextureSources(payload->textures);
+        for (const TextureSource& source : payload->textures) {
+            cost += size_t(source.image.width) * source.image.height * source.image.channels;
+            if (source.cooked) {
+                cost += getCookedTextureMemory(*source.cooked, getStreamingTailMip(*source.cooked));
+            }
+        }
+
+        queueUpload(*loaderPtr, cost, [=, request = std::move(request)]() {
+            PROFILE_ZONE("Upload model");
+            // A synchronous load of the same path may have won the race
+            Handle<Model> existing = assetsPtr->models.find(id, name);
+            if (existing.isValid()) {
+                request->handle = existing;
+            }
+            else if (payload->cooked || payload->imported) {
+                MemoryTagScope memoryTag(MemoryTag::AssetsMesh);
+                auto model = std::make_unique<Model>();
+                if (payload->cooked) {
+                    model->path = filePath;
+                    model->directory = filePath.substr(0, filePath.find_last_of("/\\"));
+                    uploadCookedModel(payload->cookedModel, *model, retainMeshData);
+                }
+                else {
+                    uploadMeshes(payload->data, *model, retainMeshData);
+                }
+                uploadModelMaterials(payload->textures, payload->materials, *model);
+
+                AssetMemory memory = getModelMemory(*model);
+                request->handle = assetsPtr->models.add(id, name, std::move(model), memory);
+            }
+            spdlog::info("Model {} finished in {:.2f} ms ({})", filePath, elapsedMilliseconds(start), payload->cooked ? "cooked" : "assimp");
+            finishRequest(*loaderPtr, loaderPtr->modelRequests, id, assetsPtr->models, *request);
+        });
+    });
+
+    return AssetFuture<Model>(request);
+}
+
+AssetFuture<Animation> loadAnimationAsync(Assets& assets, AsyncLoader& loader, const std::string& filePath) {
+    AssetId id = makeAssetId(filePath);
+    std::string name = normalizePath(filePath);
+    Handle<Animation> handle = assets.animations.find(id, name);
+    if (handle.isValid()) {
+        return AssetFuture<Animation>(makeReadyRequest(assets.animations, handle));
+    }
+
+    auto pending = loader.animationRequests.find(id);
+    if (pending != loader.animationRequests.end()) {
+        return AssetFuture<Animation>(pending->second);
+    }
+
+    auto request = std::make_shared<LoadRequest<Animation>>();
+    loader.animationRequests[id] = request;
+    loader.inFlight++;
+
+    Assets* assetsPtr = &assets;
+    AsyncLoader* loaderPtr = &loader;
+    Clock::time_point start = Clock::now();
+    loader.workers.submit([=]() mutable {
+        PROFILE_ZONE("Load animation");
+        // Animations need no GL, only publishing the result happens on the main thread
+        MemoryTagScope memoryTag(MemoryTag::Animation);
+        auto payload = std::make_shared<AnimationPayload>();
+        payload->animation = std::make_unique<Animation>();
+        payload->cooked = loadCookedAnimation(filePath, *payload->animation);
+        payload->loaded = payload->cooked || importAnimation(filePath, *payload->animation);
+
+        queueUpload(*loaderPtr, 0, [=, request = std::move(request)]() {
+            Handle<Animation> existing = assetsPtr->animations.find(id, name);
+            if (existing.isValid()) {
+                request->handle = existing;
+            }
+            else if (payload->loaded) {
+                AssetMemory memory;
+                memory.cpuBytes = payload->animation->getDataSize();
+                request->handle = assetsPtr->animations.add(id, name, std::move(payload->animation), memory);
+            }
+            spdlog::info("Animation {} finished in {:.2f} ms ({})", filePath, elapsedMilliseconds(start), payload->cooked ? "cooked" : "assimp");
+            finishRequest(*loaderPtr, loaderPtr->animationRequests, id, assetsPtr->animations, *request);
+        });
+    });
+
+    return AssetFuture<Animation>(request);
+}
@@ -0,0 +1,108 @@
+#pragma once
+#ifndef ASYNC_LOADER_H
+#define ASYNC_LOADER_H
+
+#include "Asset/asset.h"
+#include "Core/threadpool.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+enum class LoadState { Pending, Ready, Failed };
+
+// Once finished, a request holds a reference on its asset until the last future to
+// it is gone, so nothing is evicted between finishing and being picked up. Worker
+// closures hand their copy over to the upload task, which keeps every release on
+// the main thread.
+template <typename T>
+struct LoadRequest {
+    std::atomic<LoadState> state{ LoadState::Pending };
+    Handle<T> handle;
+    T* asset = nullptr;
+    AssetPool<T>* pool = nullptr;
+
+    LoadRequest() = default;
+    LoadRequest(const LoadRequest&) = delete;
+    LoadRequest& operator=(const LoadRequest&) = delete;
+
+    ~LoadRequest() {
+        if (pool) {
+            pool->release(handle);
+        }
+    }
+};
+
+// Future-like handle to an asset that is still loading. The asset pointer is only
+// published once its GL upload has run on the context thread.
+template <typename T>
+class AssetFuture {
+public:
+    AssetFuture() = default;
+    explicit AssetFuture(std::shared_ptr<LoadRequest<T>> request) : m_Request(std::move(request)) {}
+
+    bool valid() const { return m_Request != nullptr; }
+    LoadState getState() const { return m_Request ? m_Request->state.load(std::memory_order_acquire) : LoadState::Failed; }
+    bool isPending() const { return getState() == LoadState::Pending; }
+    bool isReady() const { return getState() == LoadState::Ready; }
+    bool isFailed() const { return getState() == LoadState::Failed; }
+
+    // nullptr / invalid handle until the load is ready
+    T* get() const { return isReady() ? m_Request->asset : nullptr; }
+    Handle<T> getHandle() const { return isReady() ? m_Request->handle : Handle<T>{}; }
+private:
+    std::shared_ptr<LoadRequest<T>> m_Request;
+};
+
+// Work that must run on the GL context thread, costed in bytes uploaded
+struct UploadTask {
+    size_t cost;
+    std::function<void()> run;
+};
+
+// File I/O, decoding and vertex processing run on worker threads. Results are
+// queued as upload tasks that the main thread drains under a per-frame budget.
+struct AsyncLoader {
+    ThreadPool workers;
+
+    std::mutex uploadMutex;
+    std::condition_variable uploadReady;
+    std::deque<UploadTask> uploads;
+
+    size_t uploadBudget = 16 * 1024 * 1024;
+    int inFlight = 0; // main thread only
+
+    // Requests still in flight, so loading the same path twice shares one request
+    std::unordered_map<AssetId, std::shared_ptr<LoadRequest<Texture>>> textureRequests;
+    std::unordered_map<AssetId, std::shared_ptr<LoadRequest<Model>>> modelRequests;
+    std::unordered_map<AssetId, std::shared_ptr<LoadRequest<Animation>>> animationRequests;
+};
+
+extern AsyncLoader gLoader;
+
+void startAsyncLoader(AsyncLoader& loader, unsigned int threadCount = 0);
+// Hands work to the main thread. Called from worker threads.
+void queueUpload(AsyncLoader& loader, size_t cost, std::function<void()> run);
+void stopAsyncLoader(AsyncLoader& loader);
+
+// Runs queued uploads on the calling thread until budget bytes have been uploaded.
+// At least one task runs per call so large assets cannot stall forever.
+void processUploads(AsyncLoader& loader, size_t budget);
+
+// Blocks until every request has finished, uploading results as they arrive
+void waitForLoads(AsyncLoader& loader);
+
+// Loads every image in directory twice, serially on the calling thread and through
+// the workers and pixel upload ring, and logs both timings. Needs the GL context.
+void benchmarkTextureLoading(AsyncLoader& loader, const std::string& directory);
+
+AssetFuture<Texture> loadTextureAsync(Assets& assets, AsyncLoader& loader, const std::string& filePath, const std::string& type);
+AssetFuture<Model> loadModelAsync(Assets& assets, AsyncLoader& loader, const std::string& filePath, bool retainMeshData = false);
+AssetFuture<Animation> loadAnimationAsync(Assets& assets, AsyncLoader& loader, const std::string& filePath);
+
+#endif
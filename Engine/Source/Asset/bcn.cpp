@@ -0,0 +1,650 @@
+#include "Asset/bcn.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+
+#if !defined(BCN_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define BCN_USE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+    constexpr int kBC7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+    constexpr float kBC7Fractions[16] = {
+        0 / 64.0f, 4 / 64.0f, 9 / 64.0f, 13 / 64.0f, 17 / 64.0f, 21 / 64.0f, 26 / 64.0f, 30 / 64.0f,
+        34 / 64.0f, 38 / 64.0f, 43 / 64.0f, 47 / 64.0f, 51 / 64.0f, 55 / 64.0f, 60 / 64.0f, 64 / 64.0f,
+    };
+
+    inline int clampInt(int value, int low, int high) {
+        return std::min(std::max(value, low), high);
+    }
+
+    // Least significant bit first, the order every BCn format uses
+    struct BitWriter {
+        uint8_t* bytes;
+        int position = 0;
+
+        void write(uint32_t value, int bits) {
+            for (int i = 0; i < bits; i++, position++) {
+                if (value & (1u << i)) {
+                    bytes[position >> 3] |= uint8_t(1u << (position & 7));
+                }
+            }
+        }
+    };
+
+    struct BitReader {
+        const uint8_t* bytes;
+        int position = 0;
+
+        uint32_t read(int bits) {
+            uint32_t value = 0;
+            for (int i = 0; i < bits; i++, position++) {
+                value |= uint32_t((bytes[position >> 3] >> (position & 7)) & 1) << i;
+            }
+            return value;
+        }
+    };
+
+    //-----------------------------------------------------------------------------
+    // Endpoint fitting shared by every encoder
+    //-----------------------------------------------------------------------------
+    // Fits a line through the block's colors: the mean plus the principal axis of
+    // their covariance, found with a few rounds of power iteration.
+    void fitLine(const float* points, int channels, float mean[4], float axis[4]) {
+        for (int c = 0; c < 4; c++) {
+            mean[c] = 0.0f;
+            axis[c] = 0.0f;
+        }
+        for (int i = 0; i < 16; i++) {
+            for (int c = 0; c < channels; c++) {
+                mean[c] += points[i * channels + c] / 16.0f;
+            }
+        }
+
+        float covariance[4][4] = {};
+        for (int i = 0; i < 16; i++) {
+            float delta[4] = {};
+            for (int c = 0; c < channels; c++) {
+                delta[c] = points[i * channels + c] - mean[c];
+            }
+            for (int a = 0; a < channels; a++) {
+                for (int b = 0; b < channels; b++) {
+                    covariance[a][b] += delta[a] * delta[b];
+                }
+            }
+        }
+
+        float vector[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+        for (int iteration = 0; iteration < 8; iteration++) {
+            float next[4] = {};
+            float length = 0.0f;
+            for (int a = 0; a < channels; a++) {
+                for (int b = 0; b < channels; b++) {
+                    next[a] += covariance[a][b] * vector[b];
+                }
+                length = std::max(length, std::fabs(next[a]));
+            }
+            if (length <= 1e-6f) {
+                break; // Flat block, any axis will do
+            }
+            for (int c = 0; c < channels; c++) {
+                vector[c] = next[c] / length;
+            }
+        }
+
+        float length = 0.0f;
+        for (int c = 0; c < channels; c++) {
+            length += vector[c] * vector[c];
+        }
+        length = std::sqrt(length);
+        for (int c = 0; c < channels; c++) {
+            axis[c] = length > 0.0f ? vector[c] / length : 0.0f;
+        }
+    }
+
+    // Endpoints at the extent of the block along the fitted line
+    void fitEndpoints(const float* points, int channels, float start[4], float end[4]) {
+        float mean[4];
+        float axis[4];
+        fitLine(points, channels, mean, axis);
+
+        float low = 0.0f;
+        float high = 0.0f;
+        for (int i = 0; i < 16; i++) {
+            float t = 0.0f;
+            for (int c = 0; c < channels; c++) {
+                t += (points[i * channels + c] - mean[c]) * axis[c];
+            }
+            low = std::min(low, t);
+            high = std::max(high, t);
+        }
+
+        for (int c = 0; c < 4; c++) {
+            start[c] = c < channels ? mean[c] + axis[c] * high : 255.0f;
+            end[c] = c < channels ? mean[c] + axis[c] * low : 255.0f;
+        }
+    }
+
+    // Least squares endpoints for fixed indices, where weights[i] is how far index i
+    // sits from start towards end. Returns false if the system is degenerate.
+    bool refineEndpoints(const float* points, int channels, const uint8_t indices[16], const float* weights, float start[4], float end[4]) {
+        float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+        float ax[4] = {};
+        float bx[4] = {};
+        for (int i = 0; i < 16; i++) {
+            float b = weights[indices[i]];
+            float a = 1.0f - b;
+            aa += a * a;
+            ab += a * b;
+            bb += b * b;
+            for (int c = 0; c < channels; c++) {
+                ax[c] += a * points[i * channels + c];
+                bx[c] += b * points[i * channels + c];
+            }
+        }
+
+        float determinant = aa * bb - ab * ab;
+        if (std::fabs(determinant) < 1e-6f) {
+            return false;
+        }
+        for (int c = 0; c < channels; c++) {
+            start[c] = std::min(std::max((bb * ax[c] - ab * bx[c]) / determinant, 0.0f), 255.0f);
+            end[c] = std::min(std::max((aa * bx[c] - ab * ax[c]) / determinant, 0.0f), 255.0f);
+        }
+        return true;
+    }
+
+    //-----------------------------------------------------------------------------
+    // BC1 colour block
+    //-----------------------------------------------------------------------------
+    uint16_t packColor565(const float color[4]) {
+        int r = clampInt(int(color[0] * 31.0f / 255.0f + 0.5f), 0, 31);
+        int g = clampInt(int(color[1] * 63.0f / 255.0f + 0.5f), 0, 63);
+        int b = clampInt(int(color[2] * 31.0f / 255.0f + 0.5f), 0, 31);
+        return uint16_t((r << 11) | (g << 5) | b);
+    }
+
+    void unpackColor565(uint16_t packed, uint8_t color[4]) {
+        int r = (packed >> 11) & 31;
+        int g = (packed >> 5) & 63;
+        int b = packed & 31;
+        color[0] = uint8_t((r << 3) | (r >> 2));
+        color[1] = uint8_t((g << 2) | (g >> 4));
+        color[2] = uint8_t((b << 3) | (b >> 2));
+        color[3] = 255;
+    }
+
+    // Four colour mode palette; BC2/3 colour blocks always decode this way
+    void buildColorPalette(uint16_t color0, uint16_t color1, bool fourColor, uint8_t palette[4][4]) {
+        unpackColor565(color0, palette[0]);
+        unpackColor565(color1, palette[1]);
+        for (int c = 0; c < 3; c++) {
+            if (fourColor) {
+                palette[2][c] = uint8_t((2 * palette[0][c] + palette[1][c] + 1) / 3);
+                palette[3][c] = uint8_t((palette[0][c] + 2 * palette[1][c] + 1) / 3);
+            }
+            else {
+                palette[2][c] = uint8_t((palette[0][c] + palette[1][c]) / 2);
+                palette[3][c] = 0;
+            }
+        }
+        palette[2][3] = 255;
+        palette[3][3] = fourColor ? 255 : 0;
+    }
+
+    // Nearest palette entry by RGB distance for every pixel, returns the summed error.
+    // This runs for every candidate endpoint pair, so it is the hot loop of the cooker.
+    uint32_t selectColorIndices(const uint8_t pixels[64], const uint8_t palette[4][4], uint8_t indices[16]) {
+#if BCN_USE_SSE2
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i rgbMask = _mm_set1_epi32(0x00FFFFFF);
+
+        __m128i colors[4];
+        for (int p = 0; p < 4; p++) {
+            int packed = palette[p][0] | (palette[p][1] << 8) | (palette[p][2] << 16);
+            colors[p] = _mm_unpacklo_epi8(_mm_set1_epi32(packed), zero);
+        }
+
+        uint32_t total = 0;
+        for (int group = 0; group < 4; group++) {
+            __m128i row = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + group * 16)), rgbMask);
+            __m128i low = _mm_unpacklo_epi8(row, zero);
+            __m128i high = _mm_unpackhi_epi8(row, zero);
+
+            __m128i best = _mm_set1_epi32(INT_MAX);
+            __m128i bestIndex = zero;
+            for (int p = 0; p < 4; p++) {
+                __m128i lowDelta = _mm_sub_epi16(low, colors[p]);
+                __m128i highDelta = _mm_sub_epi16(high, colors[p]);
+                lowDelta = _mm_madd_epi16(lowDelta, lowDelta);
+                highDelta = _mm_madd_epi16(highDelta, highDelta);
+                lowDelta = _mm_add_epi32(lowDelta, _mm_shuffle_epi32(lowDelta, _MM_SHUFFLE(2, 3, 0, 1)));
+                highDelta = _mm_add_epi32(highDelta, _mm_shuffle_epi32(highDelta, _MM_SHUFFLE(2, 3, 0, 1)));
+                __m128i distance = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(lowDelta), _mm_castsi128_ps(highDelta), _MM_SHUFFLE(2, 0, 2, 0)));
+
+                __m128i closer = _mm_cmplt_epi32(distance, best);
+                best = _mm_or_si128(_mm_and_si128(closer, distance), _mm_andnot_si128(closer, best));
+                bestIndex = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32(p)), _mm_andnot_si128(closer, bestIndex));
+            }
+
+            alignas(16) int32_t distances[4];
+            alignas(16) int32_t groupIndices[4];
+            _mm_store_si128(reinterpret_cast<__m128i*>(distances), best);
+            _mm_store_si128(reinterpret_cast<__m128i*>(groupIndices), bestIndex);
+            for (int i = 0; i < 4; i++) {
+                indices[group * 4 + i] = uint8_t(groupIndices[i]);
+                total += uint32_t(distances[i]);
+            }
+        }
+        return total;
+#else
+        uint32_t total = 0;
+        for (int i = 0; i < 16; i++) {
+            int best = INT_MAX;
+            for (int p = 0; p < 4; p++) {
+                int distance = 0;
+                for (int c = 0; c < 3; c++) {
+                    int delta = int(pixels[i * 4 + c]) - palette[p][c];
+                    distance += delta * delta;
+                }
+                if (distance < best) {
+                    best = distance;
+                    indices[i] = uint8_t(p);
+                }
+            }
+            total += uint32_t(best);
+        }
+        return total;
+#endif
+    }
+
+    void encodeColorBlock(const uint8_t pixels[64], uint8_t* block) {
+        static const float kWeights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+        float points[16 * 3];
+        for (int i = 0; i < 16; i++) {
+            for (int c = 0; c < 3; c++) {
+                points[i * 3 + c] = pixels[i * 4 + c];
+            }
+        }
+
+        float start[4];
+        float end[4];
+        fitEndpoints(points, 3, start, end);
+
+        uint16_t bestColor0 = 0;
+        uint16_t bestColor1 = 0;
+        uint8_t bestIndices[16] = {};
+        uint32_t bestError = UINT32_MAX;
+
+        for (int iteration = 0; iteration < 2; iteration++) {
+            uint16_t color0 = packColor565(start);
+            uint16_t color1 = packColor565(end);
+            if (color0 < color1) {
+                std::swap(color0, color1);
+            }
+
+            uint8_t palette[4][4];
+            buildColorPalette(color0, color1, true, palette);
+
+            uint8_t indices[16] = {};
+            uint32_t error = 0;
+            if (color0 == color1) {
+                // Single colour; index 0 decodes the same in either palette mode
+                for (int i = 0; i < 16; i++) {
+                    for (int c = 0; c < 3; c++) {
+                        int delta = int(pixels[i * 4 + c]) - palette[0][c];
+                        error += uint32_t(delta * delta);
+                    }
+                }
+            }
+            else {
+                error = selectColorIndices(pixels, palette, indices);
+            }
+
+            if (error < bestError) {
+                bestError = error;
+                bestColor0 = color0;
+                bestColor1 = color1;
+                std::memcpy(bestIndices, indices, 16);
+            }
+            if (bestError == 0 || color0 == color1) {
+                break;
+            }
+
+            // Refit against the current assignment, the endpoints are in palette order now
+            unpackColor565(color0, palette[0]);
+            unpackColor565(color1, palette[1]);
+            for (int c = 0; c < 3; c++) {
+                start[c] = palette[0][c];
+                end[c] = palette[1][c];
+            }
+            if (!refineEndpoints(points, 3, indices, kWeights, start, end)) {
+                break;
+            }
+        }
+
+        block[0] = uint8_t(bestColor0);
+        block[1] = uint8_t(bestColor0 >> 8);
+        block[2] = uint8_t(bestColor1);
+        block[3] = uint8_t(bestColor1 >> 8);
+        uint32_t bits = 0;
+        for (int i = 0; i < 16; i++) {
+            bits |= uint32_t(bestIndices[i]) << (i * 2);
+        }
+        std::memcpy(block + 4, &bits, 4);
+    }
+
+    void decodeColorBlock(const uint8_t* block, bool alwaysFourColor, uint8_t pixels[64]) {
+        uint16_t color0 = uint16_t(block[0] | (block[1] << 8));
+        uint16_t color1 = uint16_t(block[2] | (block[3] << 8));
+        uint32_t bits;
+        std::memcpy(&bits, block + 4, 4);
+
+        uint8_t palette[4][4];
+        buildColorPalette(color0, color1, alwaysFourColor || color0 > color1, palette);
+        for (int i = 0; i < 16; i++) {
+            std::memcpy(pixels + i * 4, palette[(bits >> (i * 2)) & 3], 4);
+        }
+    }
+
+    //-----------------------------------------------------------------------------
+    // BC4 single channel block, used for BC3 alpha and both BC5 channels
+    //-----------------------------------------------------------------------------
+    void buildChannelPalette(uint8_t value0, uint8_t value1, uint8_t palette[8]) {
+        palette[0] = value0;
+        palette[1] = value1;
+        if (value0 > value1) {
+            for (int i = 2; i < 8; i++) {
+                palette[i] = uint8_t(((8 - i) * value0 + (i - 1) * value1 + 3) / 7);
+            }
+        }
+        else {
+            for (int i = 2; i < 6; i++) {
+                palette[i] = uint8_t(((6 - i) * value0 + (i - 1) * value1 + 2) / 5);
+            }
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+    }
+
+    void encodeChannelBlock(const uint8_t pixels[64], int channel, uint8_t* block) {
+        uint8_t low = 255;
+        uint8_t high = 0;
+        for (int i = 0; i < 16; i++) {
+            low = std::min(low, pixels[i * 4 + channel]);
+            high = std::max(high, pixels[i * 4 + channel]);
+        }
+
+        uint8_t palette[8];
+        buildChannelPalette(high, low, palette);
+
+        uint64_t bits = 0;
+        if (high != low) {
+            for (int i = 0; i < 16; i++) {
+                int value = pixels[i * 4 + channel];
+                int best = INT_MAX;
+                int bestIndex = 0;
+                for (int p = 0; p < 8; p++) {
+                    int distance = std::abs(value - palette[p]);
+                    if (distance < best) {
+                        best = distance;
+                        bestIndex = p;
+                    }
+                }
+                bits |= uint64_t(bestIndex) << (i * 3);
+            }
+        }
+
+        block[0] = high;
+        block[1] = low;
+        for (int i = 0; i < 6; i++) {
+            block[2 + i] = uint8_t(bits >> (i * 8));
+        }
+    }
+
+    void decodeChannelBlock(const uint8_t* block, int channel, uint8_t pixels[64]) {
+        uint8_t palette[8];
+        buildChannelPalette(block[0], block[1], palette);
+
+        uint64_t bits = 0;
+        for (int i = 0; i < 6; i++) {
+            bits |= uint64_t(block[2 + i]) << (i * 8);
+        }
+        for (int i = 0; i < 16; i++) {
+            pixels[i * 4 + channel] = palette[(bits >> (i * 3)) & 7];
+        }
+    }
+
+    //-----------------------------------------------------------------------------
+    // BC7, mode 6 only: one subset, 7.7.7.7 endpoints with a p-bit each and 4-bit
+    // indices. It covers RGB and RGBA in a single mode and is far simpler than a
+    // full partition search, at a small quality cost on blocks with two clusters.
+    //-----------------------------------------------------------------------------
+    void quantizeBC7Endpoint(const float endpoint[4], uint8_t quantized[4], uint8_t& pBit) {
+        float bestError = 1e30f;
+        for (int p = 0; p < 2; p++) {
+            uint8_t candidate[4];
+            float error = 0.0f;
+            for (int c = 0; c < 4; c++) {
+                candidate[c] = uint8_t(clampInt(int((endpoint[c] - p) / 2.0f + 0.5f), 0, 127));
+                float delta = float((candidate[c] << 1) | p) - endpoint[c];
+                // Opaque blocks must stay exactly opaque, so alpha error weighs more
+                error += delta * delta * (c == 3 ? 8.0f : 1.0f);
+            }
+            if (error < bestError) {
+                bestError = error;
+                pBit = uint8_t(p);
+                std::memcpy(quantized, candidate, 4);
+            }
+        }
+    }
+
+    uint32_t selectBC7Indices(const uint8_t pixels[64], const uint8_t endpoint0[4], const uint8_t endpoint1[4], uint8_t indices[16]) {
+        uint8_t palette[16][4];
+        for (int i = 0; i < 16; i++) {
+            for (int c = 0; c < 4; c++) {
+                palette[i][c] = uint8_t(((64 - kBC7Weights[i]) * endpoint0[c] + kBC7Weights[i] * endpoint1[c] + 32) >> 6);
+            }
+        }
+
+        uint32_t total = 0;
+        for (int i = 0; i < 16; i++) {
+            int best = INT_MAX;
+            for (int p = 0; p < 16; p++) {
+                int distance = 0;
+                for (int c = 0; c < 4; c++) {
+                    int delta = int(pixels[i * 4 + c]) - palette[p][c];
+                    distance += delta * delta;
+                }
+                if (distance < best) {
+                    best = distance;
+                    indices[i] = uint8_t(p);
+                }
+            }
+            total += uint32_t(best);
+        }
+        return total;
+    }
+
+    void encodeBC7Block(const uint8_t pixels[64], uint8_t* block) {
+        float points[16 * 4];
+        for (int i = 0; i < 64; i++) {
+            points[i] = pixels[i];
+        }
+
+        float start[4];
+        float end[4];
+        fitEndpoints(points, 4, start, end);
+
+        uint8_t best0[4] = {};
+        uint8_t best1[4] = {};
+        uint8_t bestP0 = 0;
+        uint8_t bestP1 = 0;
+        uint8_t bestIndices[16] = {};
+        uint32_t bestError = UINT32_MAX;
+
+        for (int iteration = 0; iteration < 2; iteration++) {
+            uint8_t quantized0[4];
+            uint8_t quantized1[4];
+            uint8_t p0;
+            uint8_t p1;
+            quantizeBC7Endpoint(start, quantized0, p0);
+            quantizeBC7Endpoint(end, quantized1, p1);
+
+            uint8_t endpoint0[4];
+            uint8_t endpoint1[4];
+            for (int c = 0; c < 4; c++) {
+                endpoint0[c] = uint8_t((quantized0[c] << 1) | p0);
+                endpoint1[c] = uint8_t((quantized1[c] << 1) | p1);
+            }
+
+            uint8_t indices[16];
+            uint32_t error = selectBC7Indices(pixels, endpoint0, endpoint1, indices);
+            if (error < bestError) {
+                bestError = error;
+                std::memcpy(best0, quantized0, 4);
+                std::memcpy(best1, quantized1, 4);
+                bestP0 = p0;
+                bestP1 = p1;
+                std::memcpy(bestIndices, indices, 16);
+            }
+            if (bestError == 0 || !refineEndpoints(points, 4, indices, kBC7Fractions, start, end)) {
+                break;
+            }
+        }
+
+        // The first index is stored with its top bit implied to be 0
+        if (bestIndices[0] >= 8) {
+            std::swap(best0, best1);
+            std::swap(bestP0, bestP1);
+            for (int i = 0; i < 16; i++) {
+                bestIndices[i] = uint8_t(15 - bestIndices[i]);
+            }
+        }
+
+        std::memset(block, 0, 16);
+        BitWriter writer{ block };
+        writer.write(1u << 6, 7);
+        for (int c = 0; c < 4; c++) {
+            writer.write(best0[c], 7);
+            writer.write(best1[c], 7);
+        }
+        writer.write(bestP0, 1);
+        writer.write(bestP1, 1);
+        for (int i = 0; i < 16; i++) {
+            writer.write(bestIndices[i], i == 0 ? 3 : 4);
+        }
+    }
+
+    void decodeBC7Block(const uint8_t* block, uint8_t pixels[64]) {
+        if ((block[0] & 0x7F) != (1u << 6)) {
+            // Only mode 6 is ever written; flag anything else loudly
+            for (int i = 0; i < 16; i++) {
+                pixels[i * 4 + 0] = 255;
+                pixels[i * 4 + 1] = 0;
+                pixels[i * 4 + 2] = 255;
+                pixels[i * 4 + 3] = 255;
+            }
+            return;
+        }
+
+        BitReader reader{ block };
+        reader.read(7);
+        uint8_t endpoint0[4];
+        uint8_t endpoint1[4];
+        for (int c = 0; c < 4; c++) {
+            endpoint0[c] = uint8_t(reader.read(7) << 1);
+            endpoint1[c] = uint8_t(reader.read(7) << 1);
+        }
+        uint8_t p0 = uint8_t(reader.read(1));
+        uint8_t p1 = uint8_t(reader.read(1));
+        for (int c = 0; c < 4; c++) {
+            endpoint0[c] |= p0;
+            endpoint1[c] |= p1;
+        }
+
+        for (int i = 0; i < 16; i++) {
+            int weight = kBC7Weights[reader.read(i == 0 ? 3 : 4)];
+            for (int c = 0; c < 4; c++) {
+                pixels[i * 4 + c] = uint8_t(((64 - weight) * endpoint0[c] + weight * endpoint1[c] + 32) >> 6);
+            }
+        }
+    }
+}
+
+const char* getBlockFormatName(BlockFormat format) {
+    switch (format) {
+    case BlockFormat::BC1: return "BC1";
+    case BlockFormat::BC3: return "BC3";
+    case BlockFormat::BC5: return "BC5";
+    case BlockFormat::BC7: return "BC7";
+    default: return "None";
+    }
+}
+
+size_t getBlockSize(BlockFormat format) {
+    switch (format) {
+    case BlockFormat::BC1: return 8;
+    case BlockFormat::BC3:
+    case BlockFormat::BC5:
+    case BlockFormat::BC7: return 16;
+    default: return 0;
+    }
+}
+
+size_t getCompressedSize(BlockFormat format, uint32_t width, uint32_t height) {
+    size_t blocksWide = (width + 3) / 4;
+    size_t blocksHigh = (height + 3) / 4;
+    return blocksWide * blocksHigh * getBlockSize(format);
+}
+
+void encodeBlock(BlockFormat format, const uint8_t pixels[64], uint8_t* block) {
+    switch (format) {
+    case BlockFormat::BC1:
+        encodeColorBlock(pixels, block);
+        break;
+    case BlockFormat::BC3:
+        encodeChannelBlock(pixels, 3, block);
+        encodeColorBlock(pixels, block + 8);
+        break;
+    case BlockFormat::BC5:
+        encodeChannelBlock(pixels, 0, block);
+        encodeChannelBlock(pixels, 1, block + 8);
+        break;
+    case BlockFormat::BC7:
+        encodeBC7Block(pixels, block);
+        break;
+    default:
+        break;
+    }
+}
+
+void decodeBlock(BlockFormat format, const uint8_t* block, uint8_t pixels[64]) {
+    switch (format) {
+    case BlockFormat::BC1:
+        decodeColorBlock(block, false, pixels);
+        break;
+    case BlockFormat::BC3:
+        decodeColorBlock(block + 8, true, pixels);
+        decodeChannelBlock(block, 3, pixels);
+        break;
+    case BlockFormat::BC5:
+        for (int i = 0; i < 16; i++) {
+            pixels[i * 4 + 2] = 0;
+            pixels[i * 4 + 3] = 255;
+        }
+        decodeChannelBlock(block, 0, pixels);
+        decodeChannelBlock(block + 8, 1, pixels);
+        break;
+    case BlockFormat::BC7:
+        decodeBC7Block(block, pixels);
+        break;
+    default:
+        std::memset(pixels, 0, 64);
+        break;
+    }
+}
@@ -0,0 +1,30 @@
+#pragma once
+#ifndef BCN_H
+#define BCN_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Block compressed formats the texture cooker emits. Values are stored in cooked files.
+enum class BlockFormat : uint32_t {
+	None = 0,
+	BC1 = 1, // RGB, 4 bpp
+	BC3 = 3, // RGBA, 8 bpp
+	BC5 = 5, // Two channel (normal map XY), 8 bpp
+	BC7 = 7, // RGBA, 8 bpp, highest quality
+};
+
+const char* getBlockFormatName(BlockFormat format);
+
+// Bytes per 4x4 block, 0 for None
+size_t getBlockSize(BlockFormat format);
+
+// Bytes of one mip level, partial blocks at the edges are padded to a full block
+size_t getCompressedSize(BlockFormat format, uint32_t width, uint32_t height);
+
+// Encodes / decodes one 4x4 block of RGBA8 pixels stored row by row. CPU only,
+// safe to call from any thread.
+void encodeBlock(BlockFormat format, const uint8_t pixels[64], uint8_t* block);
+void decodeBlock(BlockFormat format, const uint8_t* block, uint8_t pixels[64]);
+
+#endif
@@ -0,0 +1,47 @@
+#include "Asset/cook.h"
+#include "Core/vfs.h"
+
+#include <spdlog/spdlog.h>
+
+std::string getCookedPath(const std::string& sourcePath, const char* extension) {
+    return COOKED_DIRECTORY + sourcePath + extension;
+}
+
+void initCookHeader(CookHeader& header, uint32_t magic, uint32_t version, const FileStamp& sourceStamp) {
+    header.magic = magic;
+    header.version = version;
+    header.fileSize = 0;
+    header.sourceSize = sourceStamp.size;
+    header.sourceWriteTime = sourceStamp.writeTime;
+}
+
+bool mapCookedFile(const std::string& sourcePath, const char* extension, uint32_t magic, uint32_t version, MappedFile& file) {
+    std::string cookedPath = getCookedPath(sourcePath, extension);
+    if (mapVirtualFile(gVFS, cookedPath, file) != FileError::None) {
+        return false;
+    }
+
+    if (file.size < sizeof(CookHeader)) {
+        spdlog::warn("Cooked file is truncated: {}", cookedPath);
+        unmapFile(file);
+        return false;
+    }
+
+    const CookHeader* header = reinterpret_cast<const CookHeader*>(file.data);
+    if (header->magic != magic || header->version != version || header->fileSize != file.size) {
+        spdlog::info("Cooked file has an old format, re-cooking: {}", cookedPath);
+        unmapFile(file);
+        return false;
+    }
+
+    // A missing source is fine: ship cooked data without the originals
+    FileStamp sourceStamp;
+    if (getVirtualFileStamp(gVFS, sourcePath, sourceStamp) &&
+        (sourceStamp.size != header->sourceSize || sourceStamp.writeTime != header->sourceWriteTime)) {
+        spdlog::info("Cooked file is stale, re-cooking: {}", cookedPath);
+        unmapFile(file);
+        return false;
+    }
+
+    return true;
+}
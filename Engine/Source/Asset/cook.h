@@ -0,0 +1,77 @@
+#pragma once
+#ifndef COOK_H
+#define COOK_H
+
+#include "Core/file.h"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Cooked assets live under this directory, mirroring the source path
+#define COOKED_DIRECTORY "Cooked/"
+
+constexpr uint32_t makeFourCC(char a, char b, char c, char d) {
+	return uint32_t(uint8_t(a)) | (uint32_t(uint8_t(b)) << 8) | (uint32_t(uint8_t(c)) << 16) | (uint32_t(uint8_t(d)) << 24);
+}
+
+// Common prefix of every cooked file. The source stamp is compared against the
+// source asset on load; any mismatch means the cooked file is stale.
+struct CookHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint64_t fileSize;
+	uint64_t sourceSize;
+	int64_t sourceWriteTime;
+};
+
+// Growable byte buffer used to lay out a cooked file before writing it
+struct BlobWriter {
+	std::vector<unsigned char> bytes;
+
+	size_t size() const { return bytes.size(); }
+
+	void align(size_t alignment) {
+		size_t padded = (bytes.size() + alignment - 1) & ~(alignment - 1);
+		bytes.resize(padded, 0);
+	}
+
+	size_t write(const void* data, size_t size) {
+		size_t offset = bytes.size();
+		bytes.resize(offset + size);
+		if (size > 0) {
+			std::memcpy(bytes.data() + offset, data, size);
+		}
+		return offset;
+	}
+
+	template <typename T>
+	size_t write(const T& value) {
+		return write(&value, sizeof(T));
+	}
+
+	template <typename T>
+	T* at(size_t offset) {
+		return reinterpret_cast<T*>(bytes.data() + offset);
+	}
+};
+
+std::string getCookedPath(const std::string& sourcePath, const char* extension);
+
+void initCookHeader(CookHeader& header, uint32_t magic, uint32_t version, const FileStamp& sourceStamp);
+
+// Maps a cooked file and validates its header against the current source file.
+// Returns false when the cooked file is missing, stale or malformed.
+bool mapCookedFile(const std::string& sourcePath, const char* extension, uint32_t magic, uint32_t version, MappedFile& file);
+
+// Pointer into a mapped cooked file, or nullptr when the range falls outside it
+template <typename T>
+const T* cookedRange(const MappedFile& file, uint64_t offset, uint64_t count) {
+	if (offset > file.size || count > (file.size - offset) / sizeof(T)) {
+		return nullptr;
+	}
+	return reinterpret_cast<const T*>(file.data + offset);
+}
+
+#endif
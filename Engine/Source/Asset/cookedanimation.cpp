@@ -0,0 +1,270 @@
+#include "Asset/cookedanimation.h"
+#include "Asset/assimpio.h"
+#include "Graphics/animation.h"
+#include "util.h"
+
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+#include <assimp/Importer.hpp>
+#include <spdlog/spdlog.h>
+
+#include <unordered_map>
+
+static_assert(sizeof(KeyPosition) == 16 && sizeof(KeyRotation) == 20 && sizeof(KeyScale) == 16,
+    "Key layout changed, bump kCookedAnimationVersion");
+static_assert(sizeof(AnimationNode) == 88 && sizeof(AnimationChannel) == 40,
+    "Node layout changed, bump kCookedAnimationVersion");
+
+namespace {
+    template <typename T>
+    const T* clipRange(const unsigned char* data, size_t size, uint64_t offset, uint64_t count) {
+        if (offset > size || count > (size - offset) / sizeof(T)) {
+            return nullptr;
+        }
+        return reinterpret_cast<const T*>(data + offset);
+    }
+
+    // Depth first, parent before children
+    void flattenHierarchy(const aiNode* node, int parent, std::vector<const aiNode*>& nodes, std::vector<int>& parents) {
+        int index = (int)nodes.size();
+        nodes.push_back(node);
+        parents.push_back(parent);
+        for (unsigned int i = 0; i < node->mNumChildren; i++) {
+            flattenHierarchy(node->mChildren[i], index, nodes, parents);
+        }
+    }
+
+    // Points the animation at clip bytes in the cooked layout, validating every range
+    bool bindAnimation(Animation& animation, const unsigned char* data, size_t size) {
+        const CookedAnimationHeader* header = clipRange<CookedAnimationHeader>(data, size, 0, 1);
+        if (!header) {
+            return false;
+        }
+
+        const AnimationNode* nodes = clipRange<AnimationNode>(data, size, header->nodesOffset, header->nodeCount);
+        const AnimationChannel* channels = clipRange<AnimationChannel>(data, size, header->channelsOffset, header->channelCount);
+        const KeyPosition* positions = clipRange<KeyPosition>(data, size, header->positionsOffset, header->positionCount);
+        const KeyRotation* rotations = clipRange<KeyRotation>(data, size, header->rotationsOffset, header->rotationCount);
+        const KeyScale* scales = clipRange<KeyScale>(data, size, header->scalesOffset, header->scaleCount);
+        if (!nodes || !channels || !positions || !rotations || !scales) {
+            return false;
+        }
+
+        for (uint32_t i = 0; i < header->nodeCount; i++) {
+            const AnimationNode& node = nodes[i];
+            if (node.parent >= (int32_t)i || node.channel >= (int32_t)header->channelCount ||
+                !clipRange<char>(data, size, node.nameOffset, node.nameLength)) {
+                return false;
+            }
+        }
+
+        animation.m_Bones.clear();
+        animation.m_Bones.reserve(header->channelCount);
+        for (uint32_t i = 0; i < header->channelCount; i++) {
+            const AnimationChannel& channel = channels[i];
+            if ((uint64_t)channel.positionFirst + channel.positionCount > header->positionCount ||
+                (uint64_t)channel.rotationFirst + channel.rotationCount > header->rotationCount ||
+                (uint64_t)channel.scaleFirst + channel.scaleCount > header->scaleCount ||
+                !clipRange<char>(data, size, channel.nameOffset, channel.nameLength)) {
+                animation.m_Bones.clear();
+                return false;
+            }
+
+            std::string_view name(reinterpret_cast<const char*>(data + channel.nameOffset), channel.nameLength);
+            animation.m_Bones.emplace_back(name, (int)i,
+                positions + channel.positionFirst, (int)channel.positionCount,
+                rotations + channel.rotationFirst, (int)channel.rotationCount,
+                scales + channel.scaleFirst, (int)channel.scaleCount);
+        }
+
+        animation.m_Duration = header->duration;
+        animation.m_TicksPerSecond = header->ticksPerSecond;
+        animation.m_Data = data;
+        animation.m_Nodes = nodes;
+        animation.m_NodeCount = header->nodeCount;
+        return true;
+    }
+
+    bool importClip(const std::string& sourcePath, BlobWriter& blob) {
+        FileStamp sourceStamp;
+        if (!getFileStamp(sourcePath, sourceStamp)) {
+            spdlog::error("Animation source is missing: {}", sourcePath);
+            return false;
+        }
+
+        Assimp::Importer importer;
+        importer.SetIOHandler(new MappedIOSystem);
+        importer.SetPropertyBool(AI_CONFIG_IMPORT_FBX_PRESERVE_PIVOTS, false);
+        const aiScene* scene = importer.ReadFile(sourcePath, aiProcess_Triangulate);
+        if (!buildCookedAnimation(scene, sourceStamp, blob)) {
+            spdlog::error("Assimp Import Error (no animation): {} {}", sourcePath, importer.GetErrorString());
+            return false;
+        }
+
+        std::string cookedPath = getCookedPath(sourcePath, COOKED_ANIMATION_EXTENSION);
+        if (!writeFile(cookedPath, blob.bytes.data(), blob.size())) {
+            spdlog::warn("Failed to write cooked animation: {}", cookedPath);
+        }
+        return true;
+    }
+}
+
+bool buildCookedAnimation(const aiScene* scene, const FileStamp& sourceStamp, BlobWriter& blob) {
+    if (!scene || !scene->mRootNode || scene->mNumAnimations == 0) {
+        return false;
+    }
+    const aiAnimation* clip = scene->mAnimations[0];
+
+    std::vector<const aiNode*> sceneNodes;
+    std::vector<int> parents;
+    flattenHierarchy(scene->mRootNode, -1, sceneNodes, parents);
+
+    std::unordered_map<std::string, int> channelByName;
+    uint32_t positionCount = 0, rotationCount = 0, scaleCount = 0;
+    for (unsigned int i = 0; i < clip->mNumChannels; i++) {
+        const aiNodeAnim* channel = clip->mChannels[i];
+        channelByName.emplace(channel->mNodeName.C_Str(), (int)i);
+        positionCount += channel->mNumPositionKeys;
+        rotationCount += channel->mNumRotationKeys;
+        scaleCount += channel->mNumScalingKeys;
+    }
+
+    CookedAnimationHeader header{};
+    initCookHeader(header.cook, kCookedAnimationMagic, kCookedAnimationVersion, sourceStamp);
+    header.duration = (float)clip->mDuration;
+    header.ticksPerSecond = (int32_t)clip->mTicksPerSecond;
+    header.nodeCount = (uint32_t)sceneNodes.size();
+    header.channelCount = clip->mNumChannels;
+    header.positionCount = positionCount;
+    header.rotationCount = rotationCount;
+    header.scaleCount = scaleCount;
+    blob.write(header);
+
+    blob.align(16);
+    size_t nodesOffset = blob.size();
+    for (size_t i = 0; i < sceneNodes.size(); i++) {
+        blob.write(AnimationNode{});
+    }
+
+    size_t channelsOffset = blob.size();
+    for (unsigned int i = 0; i < clip->mNumChannels; i++) {
+        blob.write(AnimationChannel{});
+    }
+
+    // Key streams, each channel owns a contiguous range
+    blob.align(16);
+    size_t positionsOffset = blob.size();
+    for (unsigned int i = 0; i < clip->mNumChannels; i++) {
+        const aiNodeAnim* channel = clip->mChannels[i];
+        for (unsigned int k = 0; k < channel->mNumPositionKeys; k++) {
+            KeyPosition key;
+            key.position = getGLMVec(channel->mPositionKeys[k].mValue);
+            key.timeStamp = (float)channel->mPositionKeys[k].mTime;
+            blob.write(key);
+        }
+    }
+
+    blob.align(16);
+    size_t rotationsOffset = blob.size();
+    for (unsigned int i = 0; i < clip->mNumChannels; i++) {
+        const aiNodeAnim* channel = clip->mChannels[i];
+        for (unsigned int k = 0; k < channel->mNumRotationKeys; k++) {
+            KeyRotation key;
+            key.orientation = getGLMQuat(channel->mRotationKeys[k].mValue);
+            key.timeStamp = (float)channel->mRotationKeys[k].mTime;
+            blob.write(key);
+        }
+    }
+
+    blob.align(16);
+    size_t scalesOffset = blob.size();
+    for (unsigned int i = 0; i < clip->mNumChannels; i++) {
+        const aiNodeAnim* channel = clip->mChannels[i];
+        for (unsigned int k = 0; k < channel->mNumScalingKeys; k++) {
+            KeyScale key;
+            key.scale = getGLMVec(channel->mScalingKeys[k].mValue);
+            key.timeStamp = (float)channel->mScalingKeys[k].mTime;
+            blob.write(key);
+        }
+    }
+
+    // Channel table and names
+    uint32_t positionFirst = 0, rotationFirst = 0, scaleFirst = 0;
+    for (unsigned int i = 0; i < clip->mNumChannels; i++) {
+        const aiNodeAnim* channel = clip->mChannels[i];
+        size_t nameOffset = blob.write(channel->mNodeName.C_Str(), channel->mNodeName.length);
+
+        AnimationChannel* cookedChannel = blob.at<AnimationChannel>(channelsOffset + i * sizeof(AnimationChannel));
+        cookedChannel->nameOffset = nameOffset;
+        cookedChannel->nameLength = channel->mNodeName.length;
+        cookedChannel->positionFirst = positionFirst;
+        cookedChannel->positionCount = channel->mNumPositionKeys;
+        cookedChannel->rotationFirst = rotationFirst;
+        cookedChannel->rotationCount = channel->mNumRotationKeys;
+        cookedChannel->scaleFirst = scaleFirst;
+        cookedChannel->scaleCount = channel->mNumScalingKeys;
+
+        positionFirst += channel->mNumPositionKeys;
+        rotationFirst += channel->mNumRotationKeys;
+        scaleFirst += channel->mNumScalingKeys;
+    }
+
+    // Node table with the channel-to-node map resolved at cook time
+    for (size_t i = 0; i < sceneNodes.size(); i++) {
+        const aiNode* node = sceneNodes[i];
+        size_t nameOffset = blob.write(node->mName.C_Str(), node->mName.length);
+
+        auto channel = channelByName.find(node->mName.C_Str());
+
+        AnimationNode* cookedNode = blob.at<AnimationNode>(nodesOffset + i * sizeof(AnimationNode));
+        cookedNode->transformation = convertMatrixToGLMFormat(node->mTransformation);
+        cookedNode->nameOffset = nameOffset;
+        cookedNode->nameLength = node->mName.length;
+        cookedNode->parent = parents[i];
+        cookedNode->channel = channel != channelByName.end() ? channel->second : -1;
+    }
+
+    CookedAnimationHeader* cookedHeader = blob.at<CookedAnimationHeader>(0);
+    cookedHeader->nodesOffset = nodesOffset;
+    cookedHeader->channelsOffset = channelsOffset;
+    cookedHeader->positionsOffset = positionsOffset;
+    cookedHeader->rotationsOffset = rotationsOffset;
+    cookedHeader->scalesOffset = scalesOffset;
+    cookedHeader->cook.fileSize = blob.size();
+    return true;
+}
+
+bool cookAnimation(const std::string& sourcePath) {
+    BlobWriter blob;
+    if (!importClip(sourcePath, blob)) {
+        return false;
+    }
+    spdlog::info("Cooked animation {} ({} bytes)", sourcePath, blob.size());
+    return true;
+}
+
+bool loadCookedAnimation(const std::string& sourcePath, Animation& animation) {
+    MappedFile file;
+    if (!mapCookedFile(sourcePath, COOKED_ANIMATION_EXTENSION, kCookedAnimationMagic, kCookedAnimationVersion, file)) {
+        return false;
+    }
+
+    if (!bindAnimation(animation, file.data, file.size)) {
+        spdlog::warn("Cooked animation is malformed: {}", sourcePath);
+        return false;
+    }
+
+    // Bones and nodes point into the mapping, which the animation now owns
+    animation.m_File = std::move(file);
+    return true;
+}
+
+bool importAnimation(const std::string& sourcePath, Animation& animation) {
+    BlobWriter blob;
+    if (!importClip(sourcePath, blob)) {
+        return false;
+    }
+
+    animation.m_Blob = std::move(blob.bytes);
+    return bindAnimation(animation, animation.m_Blob.data(), animation.m_Blob.size());
+}
@@ -0,0 +1,51 @@
+#pragma once
+#ifndef COOKED_ANIMATION_H
+#define COOKED_ANIMATION_H
+
+#include "Asset/cook.h"
+
+#include <cstdint>
+#include <string>
+
+class Animation;
+struct aiScene;
+
+#define COOKED_ANIMATION_EXTENSION ".anim"
+
+constexpr uint32_t kCookedAnimationMagic = makeFourCC('E', 'A', 'N', 'M');
+constexpr uint32_t kCookedAnimationVersion = 1;
+
+// Layout of a cooked animation clip. Every offset is from the start of the file.
+// The node table (AnimationNode), channel table (AnimationChannel) and the key
+// streams (KeyPosition, KeyRotation, KeyScale) are sampled directly from the
+// mapped bytes, so loading a clip does no parsing beyond validating ranges.
+struct CookedAnimationHeader {
+	CookHeader cook;
+	float duration;
+	int32_t ticksPerSecond;
+	uint32_t nodeCount;
+	uint32_t channelCount;
+	uint32_t positionCount;
+	uint32_t rotationCount;
+	uint32_t scaleCount;
+	uint32_t padding;
+	uint64_t nodesOffset;
+	uint64_t channelsOffset;
+	uint64_t positionsOffset;
+	uint64_t rotationsOffset;
+	uint64_t scalesOffset;
+};
+
+// Lays out the first animation of the scene in the cooked format
+bool buildCookedAnimation(const aiScene* scene, const FileStamp& sourceStamp, BlobWriter& blob);
+
+// Offline cook step: imports the source with Assimp and writes the cooked clip
+bool cookAnimation(const std::string& sourcePath);
+
+// Maps the cooked clip for sourcePath. Returns false when it is missing or stale.
+bool loadCookedAnimation(const std::string& sourcePath, Animation& animation);
+
+// Imports the source with Assimp, writes the cooked clip and binds the animation to it
+bool importAnimation(const std::string& sourcePath, Animation& animation);
+
+#endif
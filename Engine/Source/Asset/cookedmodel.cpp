@@ -0,0 +1,315 @@
+#include "Asset/cookedmodel.h"
+#include "Asset/asset.h"
+#include "Asset/cookedtexture.h"
+#include "Core/profiler.h"
+#include "Graphics/model.h"
+
+#include <spdlog/spdlog.h>
+
+#include <unordered_map>
+#include <unordered_set>
+
+static_assert(sizeof(Vertex) == 64, "Vertex layout changed, bump kCookedModelVersion");
+
+namespace {
+    size_t writeString(BlobWriter& blob, const std::string& value) {
+        return blob.write(value.data(), value.size());
+    }
+
+    bool readString(const MappedFile& file, uint64_t offset, uint32_t length, std::string& value) {
+        const char* chars = cookedRange<char>(file, offset, length);
+        if (!chars) {
+            return false;
+        }
+        value.assign(chars, length);
+        return true;
+    }
+}
+
+bool writeCookedModel(const std::string& sourcePath, const ModelData& model) {
+    FileStamp sourceStamp;
+    if (!getFileStamp(sourcePath, sourceStamp)) {
+        spdlog::error("Cannot cook model, source is missing: {}", sourcePath);
+        return false;
+    }
+
+    BlobWriter blob;
+
+    CookedModelHeader header{};
+    initCookHeader(header.cook, kCookedModelMagic, kCookedModelVersion, sourceStamp);
+    header.vertexSize = sizeof(Vertex);
+    header.meshCount = (uint32_t)model.meshes.size();
+    header.boneCount = (uint32_t)model.m_BoneInfoMap.size();
+    header.textureCount = (uint32_t)model.textures.size();
+    header.boneCounter = model.m_BoneCounter;
+    header.materialCount = (uint32_t)model.materials.size();
+    blob.write(header);
+
+    // Tables first, their offsets get patched once the payload is laid out
+    blob.align(16);
+    size_t meshesOffset = blob.size();
+    for (size_t i = 0; i < model.meshes.size(); i++) {
+        blob.write(CookedMesh{});
+    }
+
+    size_t bonesOffset = blob.size();
+    for (size_t i = 0; i < model.m_BoneInfoMap.size(); i++) {
+        blob.write(CookedBone{});
+    }
+
+    size_t texturesOffset = blob.size();
+    for (size_t i = 0; i < model.textures.size(); i++) {
+        blob.write(CookedTexture{});
+    }
+
+    size_t materialsOffset = blob.size();
+    for (const MaterialRef& material : model.materials) {
+        CookedMaterial cookedMaterial{};
+        cookedMaterial.params = material.params;
+        cookedMaterial.firstTexture = material.firstTexture;
+        cookedMaterial.textureCount = material.textureCount;
+        blob.write(cookedMaterial);
+    }
+
+    // Vertex and index streams
+    for (size_t i = 0; i < model.meshes.size(); i++) {
+        const MeshData& mesh = model.meshes[i];
+
+        blob.align(16);
+        size_t vertexOffset = blob.write(mesh.vertices.data(), mesh.vertices.size() * sizeof(Vertex));
+        size_t indexOffset = blob.write(mesh.indices.data(), mesh.indices.size() * sizeof(unsigned int));
+
+        CookedMesh* cookedMesh = blob.at<CookedMesh>(meshesOffset + i * sizeof(CookedMesh));
+        cookedMesh->vertexOffset = vertexOffset;
+        cookedMesh->indexOffset = indexOffset;
+        cookedMesh->vertexCount = (uint32_t)mesh.vertices.size();
+        cookedMesh->indexCount = (uint32_t)mesh.indices.size();
+        cookedMesh->material = mesh.material;
+    }
+
+    // Skeleton
+    size_t boneIndex = 0;
+    for (const auto& [name, info] : model.m_BoneInfoMap) {
+        size_t nameOffset = writeString(blob, name);
+
+        CookedBone* cookedBone = blob.at<CookedBone>(bonesOffset + boneIndex * sizeof(CookedBone));
+        cookedBone->offset = info.offset;
+        cookedBone->id = info.id;
+        cookedBone->nameOffset = nameOffset;
+        cookedBone->nameLength = (uint32_t)name.size();
+        boneIndex++;
+    }
+
+    // Material references
+    std::unordered_map<AssetId, std::pair<size_t, size_t>> embeddedBlobs;
+    for (size_t i = 0; i < model.textures.size(); i++) {
+        const TextureRef& ref = model.textures[i];
+
+        size_t typeOffset = writeString(blob, ref.type);
+        size_t pathOffset = writeString(blob, ref.path);
+
+        size_t dataOffset = 0;
+        size_t dataSize = 0;
+        if (!ref.embedded.empty()) {
+            blob.align(4);
+            dataOffset = blob.write(ref.embedded.data(), ref.embedded.size());
+            dataSize = ref.embedded.size();
+            embeddedBlobs[ref.id] = { dataOffset, dataSize };
+        }
+        else if (ref.path.empty()) {
+            auto it = embeddedBlobs.find(ref.id);
+            if (it != embeddedBlobs.end()) {
+                dataOffset = it->second.first;
+                dataSize = it->second.second;
+            }
+        }
+
+        CookedTexture* cookedTexture = blob.at<CookedTexture>(texturesOffset + i * sizeof(CookedTexture));
+        cookedTexture->assetId = ref.id;
+        cookedTexture->typeOffset = typeOffset;
+        cookedTexture->typeLength = (uint32_t)ref.type.size();
+        cookedTexture->pathOffset = pathOffset;
+        cookedTexture->pathLength = (uint32_t)ref.path.size();
+        cookedTexture->dataOffset = dataOffset;
+        cookedTexture->dataSize = dataSize;
+        cookedTexture->width = ref.width;
+        cookedTexture->height = ref.height;
+    }
+
+    CookedModelHeader* cookedHeader = blob.at<CookedModelHeader>(0);
+    cookedHeader->meshesOffset = meshesOffset;
+    cookedHeader->bonesOffset = bonesOffset;
+    cookedHeader->texturesOffset = texturesOffset;
+    cookedHeader->materialsOffset = materialsOffset;
+    cookedHeader->cook.fileSize = blob.size();
+
+    std::string cookedPath = getCookedPath(sourcePath, COOKED_MODEL_EXTENSION);
+    if (!writeFile(cookedPath, blob.bytes.data(), blob.size())) {
+        spdlog::error("Failed to write cooked model: {}", cookedPath);
+        return false;
+    }
+
+    spdlog::info("Cooked model {} ({} bytes)", cookedPath, blob.size());
+    return true;
+}
+
+bool cookModel(const std::string& sourcePath, std::vector<TextureCookReport>* textureReports) {
+    ModelData model;
+    if (!importModel(sourcePath, model)) {
+        return false;
+    }
+    bool success = writeCookedModel(sourcePath, model);
+
+    std::unordered_set<AssetId> cooked;
+    for (const TextureRef& ref : model.textures) {
+        if (ref.path.empty() || !cooked.insert(ref.id).second) {
+            continue;
+        }
+
+        TextureUsage usage = ref.type == "texture_normal" ? TextureUsage::Normal : TextureUsage::Color;
+        TextureCookReport report;
+        if (cookTexture(ref.path, usage, BlockFormat::None, &report)) {
+            if (textureReports) {
+                textureReports->push_back(report);
+            }
+        }
+        else {
+            success = false;
+        }
+    }
+    return success;
+}
+
+bool openCookedModel(const std::string& sourcePath, CookedModel& cooked) {
+    PROFILE_ZONE("openCookedModel");
+    MappedFile file;
+    if (!mapCookedFile(sourcePath, COOKED_MODEL_EXTENSION, kCookedModelMagic, kCookedModelVersion, file)) {
+        return false;
+    }
+
+    const CookedModelHeader* header = cookedRange<CookedModelHeader>(file, 0, 1);
+    if (!header || header->vertexSize != sizeof(Vertex)) {
+        spdlog::warn("Cooked model has a different vertex layout: {}", sourcePath);
+        return false;
+    }
+
+    const CookedMesh* meshes = cookedRange<CookedMesh>(file, header->meshesOffset, header->meshCount);
+    const CookedBone* bones = cookedRange<CookedBone>(file, header->bonesOffset, header->boneCount);
+    const CookedTexture* textures = cookedRange<CookedTexture>(file, header->texturesOffset, header->textureCount);
+    const CookedMaterial* materials = cookedRange<CookedMaterial>(file, header->materialsOffset, header->materialCount);
+    if (!meshes || !bones || !textures || !materials) {
+        spdlog::warn("Cooked model is malformed: {}", sourcePath);
+        return false;
+    }
+
+    // Validate everything up front so a bad file falls back cleanly before touching GL
+    for (uint32_t i = 0; i < header->meshCount; i++) {
+        if (!cookedRange<Vertex>(file, meshes[i].vertexOffset, meshes[i].vertexCount) ||
+            !cookedRange<unsigned int>(file, meshes[i].indexOffset, meshes[i].indexCount) ||
+            (header->materialCount > 0 && meshes[i].material >= header->materialCount)) {
+            spdlog::warn("Cooked model has an invalid mesh range: {}", sourcePath);
+            return false;
+        }
+    }
+
+    for (uint32_t i = 0; i < header->boneCount; i++) {
+        if (!cookedRange<char>(file, bones[i].nameOffset, bones[i].nameLength)) {
+            spdlog::warn("Cooked model has an invalid bone name: {}", sourcePath);
+            return false;
+        }
+    }
+
+    for (uint32_t i = 0; i < header->textureCount; i++) {
+        if (!cookedRange<char>(file, textures[i].typeOffset, textures[i].typeLength) ||
+            !cookedRange<char>(file, textures[i].pathOffset, textures[i].pathLength) ||
+            !cookedRange<unsigned char>(file, textures[i].dataOffset, textures[i].dataSize)) {
+            spdlog::warn("Cooked model has an invalid texture range: {}", sourcePath);
+            return false;
+        }
+    }
+
+    for (uint32_t i = 0; i < header->materialCount; i++) {
+        if (materials[i].firstTexture > header->textureCount || materials[i].textureCount > header->textureCount - materials[i].firstTexture) {
+            spdlog::warn("Cooked model has an invalid material: {}", sourcePath);
+            return false;
+        }
+    }
+
+    cooked.file = std::move(file);
+    cooked.header = header;
+    cooked.meshes = meshes;
+    cooked.bones = bones;
+    cooked.textures = textures;
+    cooked.materials = materials;
+    return true;
+}
+
+void uploadCookedModel(const CookedModel& cooked, Model& model, bool retainMeshData) {
+    const MappedFile& file = cooked.file;
+    const CookedModelHeader* header = cooked.header;
+
+    model.m_BoneCounter = header->boneCounter;
+    for (uint32_t i = 0; i < header->boneCount; i++) {
+        std::string name;
+        readString(file, cooked.bones[i].nameOffset, cooked.bones[i].nameLength, name);
+
+        BoneInfo info;
+        info.id = cooked.bones[i].id;
+        info.offset = cooked.bones[i].offset;
+        model.m_BoneInfoMap.emplace(std::move(name), info);
+    }
+
+    model.retainsMeshData = retainMeshData;
+    model.meshes.reserve(header->meshCount);
+    for (uint32_t i = 0; i < header->meshCount; i++) {
+        const CookedMesh& mesh = cooked.meshes[i];
+        model.meshes.push_back(setupMesh(
+            cookedRange<Vertex>(file, mesh.vertexOffset, mesh.vertexCount), mesh.vertexCount,
+            cookedRange<unsigned int>(file, mesh.indexOffset, mesh.indexCount), mesh.indexCount, retainMeshData));
+        model.meshes.back().materialIndex = mesh.material;
+    }
+    updateModelBounds(model);
+}
+
+std::vector<TextureSource> getTextureSources(const CookedModel& cooked) {
+    const MappedFile& file = cooked.file;
+
+    std::vector<TextureSource> sources(cooked.header->textureCount);
+    for (uint32_t i = 0; i < cooked.header->textureCount; i++) {
+        const CookedTexture& cookedTexture = cooked.textures[i];
+        readString(file, cookedTexture.typeOffset, cookedTexture.typeLength, sources[i].type);
+        readString(file, cookedTexture.pathOffset, cookedTexture.pathLength, sources[i].path);
+        sources[i].id = cookedTexture.assetId;
+        sources[i].data = cookedRange<unsigned char>(file, cookedTexture.dataOffset, cookedTexture.dataSize);
+        sources[i].size = cookedTexture.dataSize;
+        sources[i].width = cookedTexture.width;
+        sources[i].height = cookedTexture.height;
+    }
+    return sources;
+}
+
+std::vector<MaterialRef> getMaterialRefs(const CookedModel& cooked) {
+    std::vector<MaterialRef> materials(cooked.header->materialCount);
+    for (uint32_t i = 0; i < cooked.header->materialCount; i++) {
+        materials[i].params = cooked.materials[i].params;
+        materials[i].firstTexture = cooked.materials[i].firstTexture;
+        materials[i].textureCount = cooked.materials[i].textureCount;
+    }
+    return materials;
+}
+
+bool loadCookedModel(const std::string& sourcePath, Model& model, bool retainMeshData) {
+    PROFILE_ZONE("loadCookedModel");
+    CookedModel cooked;
+    if (!openCookedModel(sourcePath, cooked)) {
+        return false;
+    }
+
+    model.path = sourcePath;
+    model.directory = sourcePath.substr(0, sourcePath.find_last_of("/\\"));
+    uploadCookedModel(cooked, model, retainMeshData);
+
+    std::vector<TextureSource> sources = getTextureSources(cooked);
+    uploadModelMaterials(sources, getMaterialRefs(cooked), model);
+    return true;
+}
@@ -0,0 +1,112 @@
+#pragma once
+#ifndef COOKED_MODEL_H
+#define COOKED_MODEL_H
+
+#include "Asset/cook.h"
+#include "Graphics/material.h"
+#include "Graphics/mesh.h"
+
+#include <glm/mat4x4.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct Model;
+struct ModelData;
+struct MaterialRef;
+struct TextureSource;
+struct TextureCookReport;
+
+#define COOKED_MODEL_EXTENSION ".mdl"
+
+constexpr uint32_t kCookedModelMagic = makeFourCC('E', 'M', 'D', 'L');
+constexpr uint32_t kCookedModelVersion = 5;
+
+// Layout of a cooked model file. Every offset is from the start of the file.
+// Vertex and index streams are stored in their final GPU layout and are uploaded
+// straight from the mapped file.
+struct CookedModelHeader {
+	CookHeader cook;
+	uint32_t vertexSize;
+	uint32_t meshCount;
+	uint32_t boneCount;
+	uint32_t textureCount;
+	int32_t boneCounter;
+	uint32_t materialCount;
+	uint64_t meshesOffset;
+	uint64_t bonesOffset;
+	uint64_t texturesOffset;
+	uint64_t materialsOffset;
+};
+
+struct CookedMesh {
+	uint64_t vertexOffset;
+	uint64_t indexOffset;
+	uint32_t vertexCount;
+	uint32_t indexCount;
+	uint32_t material;
+	uint32_t padding;
+};
+
+// Parameters plus a range of the texture table
+struct CookedMaterial {
+	MaterialParams params;
+	uint32_t firstTexture;
+	uint32_t textureCount;
+	uint64_t reserved;
+};
+
+struct CookedBone {
+	glm::mat4 offset;
+	int32_t id;
+	uint32_t nameLength;
+	uint64_t nameOffset;
+};
+
+// Material texture reference: an external path, or embedded image bytes when dataSize is not 0.
+// The asset ID is the path ID for external textures and the content ID for embedded ones,
+// so loaded textures are found without rehashing. Repeated embedded images share one blob.
+struct CookedTexture {
+	uint64_t assetId;
+	uint64_t typeOffset;
+	uint64_t pathOffset;
+	uint64_t dataOffset;
+	uint64_t dataSize;
+	uint32_t typeLength;
+	uint32_t pathLength;
+	uint32_t width;
+	uint32_t height;
+};
+
+// Validated view of a mapped cooked model
+struct CookedModel {
+	MappedFile file;
+	const CookedModelHeader* header = nullptr;
+	const CookedMesh* meshes = nullptr;
+	const CookedBone* bones = nullptr;
+	const CookedTexture* textures = nullptr;
+	const CookedMaterial* materials = nullptr;
+};
+
+bool writeCookedModel(const std::string& sourcePath, const ModelData& model);
+
+// Offline cook step: imports the source with Assimp and writes the cooked file, then
+// cooks every external texture it references. No GL required.
+bool cookModel(const std::string& sourcePath, std::vector<TextureCookReport>* textureReports = nullptr);
+
+// Maps and validates the cooked file for sourcePath. CPU only, safe on any thread.
+bool openCookedModel(const std::string& sourcePath, CookedModel& cooked);
+
+// Uploads meshes straight from the mapping and copies the skeleton. The mapping
+// is the only CPU copy of the meshes unless retainMeshData is set.
+void uploadCookedModel(const CookedModel& cooked, Model& model, bool retainMeshData = false);
+
+std::vector<TextureSource> getTextureSources(const CookedModel& cooked);
+std::vector<MaterialRef> getMaterialRefs(const CookedModel& cooked);
+
+// Maps the cooked file for sourcePath and uploads it. Returns false when the cooked
+// file is missing or stale, in which case the caller should fall back to Assimp.
+bool loadCookedModel(const std::string& sourcePath, Model& model, bool retainMeshData = false);
+
+#endif
@@ -0,0 +1,398 @@
+#include "Asset/cookedtexture.h"
+#include "Core/jobs.h"
+#include "Graphics/glext.h"
+#include "Graphics/texture.h"
+
+#include <glad/glad.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <sstream>
+
+// glad is generated for the 3.3 core profile, which has RGTC but not these
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+#define GL_COMPRESSED_RGBA_BPTC_UNORM 0x8E8C
+#endif
+
+namespace {
+    struct MipImage {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        std::vector<uint8_t> pixels; // RGBA8
+    };
+
+    const std::array<float, 256>& getSrgbToLinearTable() {
+        static const std::array<float, 256> table = [] {
+            std::array<float, 256> values{};
+            for (int i = 0; i < 256; i++) {
+                float c = i / 255.0f;
+                values[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+            }
+            return values;
+        }();
+        return table;
+    }
+
+    uint8_t linearToSrgb(float value) {
+        value = std::min(std::max(value, 0.0f), 1.0f);
+        float c = value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+        return uint8_t(c * 255.0f + 0.5f);
+    }
+
+    // 2x2 box filter. Colour is averaged in linear light so mips keep the
+    // brightness of the top level instead of darkening.
+    MipImage downsample(const MipImage& source, TextureUsage usage) {
+        const std::array<float, 256>& toLinear = getSrgbToLinearTable();
+
+        MipImage mip;
+        mip.width = std::max(1u, source.width / 2);
+        mip.height = std::max(1u, source.height / 2);
+        mip.pixels.resize(size_t(mip.width) * mip.height * 4);
+
+        for (uint32_t y = 0; y < mip.height; y++) {
+            for (uint32_t x = 0; x < mip.width; x++) {
+                float sum[4] = {};
+                for (uint32_t dy = 0; dy < 2; dy++) {
+                    for (uint32_t dx = 0; dx < 2; dx++) {
+                        uint32_t sx = std::min(x * 2 + dx, source.width - 1);
+                        uint32_t sy = std::min(y * 2 + dy, source.height - 1);
+                        const uint8_t* texel = &source.pixels[(size_t(sy) * source.width + sx) * 4];
+                        for (int c = 0; c < 4; c++) {
+                            bool srgb = usage == TextureUsage::Color && c < 3;
+                            sum[c] += srgb ? toLinear[texel[c]] : texel[c] / 255.0f;
+                        }
+                    }
+                }
+
+                uint8_t* out = &mip.pixels[(size_t(y) * mip.width + x) * 4];
+                if (usage == TextureUsage::Normal) {
+                    float n[3];
+                    float length = 0.0f;
+                    for (int c = 0; c < 3; c++) {
+                        n[c] = sum[c] / 4.0f * 2.0f - 1.0f;
+                        length += n[c] * n[c];
+                    }
+                    length = length > 0.0f ? std::sqrt(length) : 1.0f;
+                    for (int c = 0; c < 3; c++) {
+                        out[c] = uint8_t((n[c] / length * 0.5f + 0.5f) * 255.0f + 0.5f);
+                    }
+                }
+                else {
+                    for (int c = 0; c < 3; c++) {
+                        out[c] = linearToSrgb(sum[c] / 4.0f);
+                    }
+                }
+                out[3] = uint8_t(sum[3] / 4.0f * 255.0f + 0.5f);
+            }
+        }
+        return mip;
+    }
+
+    void readBlock(const MipImage& image, uint32_t blockX, uint32_t blockY, uint8_t pixels[64]) {
+        // Edge blocks repeat the last row/column, which keeps their endpoints tight
+        for (uint32_t y = 0; y < 4; y++) {
+            for (uint32_t x = 0; x < 4; x++) {
+                uint32_t sx = std::min(blockX * 4 + x, image.width - 1);
+                uint32_t sy = std::min(blockY * 4 + y, image.height - 1);
+                std::memcpy(&pixels[(y * 4 + x) * 4], &image.pixels[(size_t(sy) * image.width + sx) * 4], 4);
+            }
+        }
+    }
+
+    std::vector<uint8_t> compressLevel(const MipImage& image, BlockFormat format) {
+        uint32_t blocksWide = (image.width + 3) / 4;
+        uint32_t blocksHigh = (image.height + 3) / 4;
+        size_t blockSize = getBlockSize(format);
+
+        std::vector<uint8_t> blocks(size_t(blocksWide) * blocksHigh * blockSize);
+        parallelFor(gJobs, blocksHigh, [&](size_t firstRow, size_t endRow) {
+            uint8_t pixels[64];
+            for (size_t blockY = firstRow; blockY < endRow; blockY++) {
+                for (uint32_t blockX = 0; blockX < blocksWide; blockX++) {
+                    readBlock(image, blockX, (uint32_t)blockY, pixels);
+                    encodeBlock(format, pixels, &blocks[(blockY * blocksWide + blockX) * blockSize]);
+                }
+            }
+        });
+        return blocks;
+    }
+
+    int getKeptChannels(BlockFormat format) {
+        switch (format) {
+        case BlockFormat::BC1: return 3;
+        case BlockFormat::BC5: return 2;
+        default: return 4;
+        }
+    }
+
+    float measurePsnr(const MipImage& image, const std::vector<uint8_t>& blocks, BlockFormat format) {
+        uint32_t blocksWide = (image.width + 3) / 4;
+        size_t blockSize = getBlockSize(format);
+        int channels = getKeptChannels(format);
+
+        double squaredError = 0.0;
+        for (uint32_t y = 0; y < image.height; y += 4) {
+            for (uint32_t x = 0; x < image.width; x += 4) {
+                uint8_t decoded[64];
+                decodeBlock(format, &blocks[(size_t(y / 4) * blocksWide + x / 4) * blockSize], decoded);
+                for (uint32_t by = 0; by < 4 && y + by < image.height; by++) {
+                    for (uint32_t bx = 0; bx < 4 && x + bx < image.width; bx++) {
+                        const uint8_t* original = &image.pixels[(size_t(y + by) * image.width + x + bx) * 4];
+                        for (int c = 0; c < channels; c++) {
+                            double delta = double(original[c]) - decoded[(by * 4 + bx) * 4 + c];
+                            squaredError += delta * delta;
+                        }
+                    }
+                }
+            }
+        }
+
+        double meanError = squaredError / (double(image.width) * image.height * channels);
+        if (meanError <= 0.0) {
+            return 99.0f; // Lossless
+        }
+        return float(10.0 * std::log10(255.0 * 255.0 / meanError));
+    }
+
+    unsigned int getGLFormat(BlockFormat format) {
+        switch (format) {
+        case BlockFormat::BC1: return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+        case BlockFormat::BC3: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        case BlockFormat::BC5: return GL_COMPRESSED_RG_RGTC2;
+        case BlockFormat::BC7: return GL_COMPRESSED_RGBA_BPTC_UNORM;
+        default: return 0;
+        }
+    }
+}
+
+BlockFormat chooseBlockFormat(TextureUsage usage, const unsigned char* rgba, size_t pixelCount) {
+    if (usage == TextureUsage::Normal) {
+        return BlockFormat::BC5;
+    }
+    for (size_t i = 0; i < pixelCount; i++) {
+        if (rgba[i * 4 + 3] != 255) {
+            return BlockFormat::BC7;
+        }
+    }
+    return BlockFormat::BC1;
+}
+
+bool cookTexture(const std::string& sourcePath, TextureUsage usage, BlockFormat format, TextureCookReport* report) {
+    auto start = std::chrono::steady_clock::now();
+
+    FileStamp sourceStamp;
+    Image image;
+    if (!getFileStamp(sourcePath, sourceStamp) || !loadImage(sourcePath, image, 4)) {
+        spdlog::error("Cannot cook texture, failed to decode source: {}", sourcePath);
+        return false;
+    }
+
+    // Decoded with the same stb flip setting the runtime uses, so cooked and
+    // uncooked textures come out the same way up
+    std::vector<MipImage> mips(1);
+    mips[0].width = (uint32_t)image.width;
+    mips[0].height = (uint32_t)image.height;
+    mips[0].pixels.assign(image.pixels, image.pixels + size_t(image.width) * image.height * 4);
+    while (mips.back().width > 1 || mips.back().height > 1) {
+        mips.push_back(downsample(mips.back(), usage));
+    }
+
+    if (format == BlockFormat::None) {
+        format = chooseBlockFormat(usage, mips[0].pixels.data(), size_t(mips[0].width) * mips[0].height);
+    }
+
+    std::vector<std::vector<uint8_t>> levels(mips.size());
+    for (size_t level = 0; level < mips.size(); level++) {
+        levels[level] = compressLevel(mips[level], format);
+    }
+
+    BlobWriter blob;
+
+    CookedTextureHeader header{};
+    initCookHeader(header.cook, kCookedTextureMagic, kCookedTextureVersion, sourceStamp);
+    header.format = (uint32_t)format;
+    header.usage = (uint32_t)usage;
+    header.width = mips[0].width;
+    header.height = mips[0].height;
+    header.mipCount = (uint32_t)mips.size();
+    blob.write(header);
+
+    size_t levelsOffset = blob.size();
+    for (size_t level = 0; level < mips.size(); level++) {
+        blob.write(CookedMipLevel{});
+    }
+
+    // Smallest mip first
+    for (size_t i = mips.size(); i-- > 0;) {
+        blob.align(16);
+        size_t offset = blob.write(levels[i].data(), levels[i].size());
+
+        CookedMipLevel* level = blob.at<CookedMipLevel>(levelsOffset + i * sizeof(CookedMipLevel));
+        level->offset = offset;
+        level->size = levels[i].size();
+        level->width = mips[i].width;
+        level->height = mips[i].height;
+    }
+
+    CookedTextureHeader* cookedHeader = blob.at<CookedTextureHeader>(0);
+    cookedHeader->levelsOffset = levelsOffset;
+    cookedHeader->cook.fileSize = blob.size();
+
+    std::string cookedPath = getCookedPath(sourcePath, COOKED_TEXTURE_EXTENSION);
+    if (!writeFile(cookedPath, blob.bytes.data(), blob.size())) {
+        spdlog::error("Failed to write cooked texture: {}", cookedPath);
+        return false;
+    }
+
+    float milliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    spdlog::info("Cooked texture {} ({}, {} mips, {} bytes, {:.2f} ms)", cookedPath, getBlockFormatName(format), mips.size(), blob.size(), milliseconds);
+
+    if (report) {
+        report->path = sourcePath;
+        report->format = format;
+        report->width = mips[0].width;
+        report->height = mips[0].height;
+        report->mipCount = (uint32_t)mips.size();
+        report->sourceBytes = 0;
+        report->cookedBytes = 0;
+        for (size_t level = 0; level < mips.size(); level++) {
+            report->sourceBytes += mips[level].pixels.size();
+            report->cookedBytes += levels[level].size();
+        }
+        report->psnr = measurePsnr(mips[0], levels[0], format);
+        report->milliseconds = milliseconds;
+    }
+    return true;
+}
+
+void writeTextureCookReport(const std::vector<TextureCookReport>& reports, const std::string& filePath) {
+    std::ostringstream csv;
+    csv << "path,format,width,height,mips,rgba_bytes,cooked_bytes,ratio,psnr_db,milliseconds\n";
+
+    size_t totalSource = 0;
+    size_t totalCooked = 0;
+    for (const TextureCookReport& report : reports) {
+        float ratio = report.cookedBytes ? float(report.sourceBytes) / report.cookedBytes : 0.0f;
+        spdlog::info("{:<48} {:>4} {:>5}x{:<5} {:>2} mips {:>10} -> {:>9} bytes ({:.1f}:1) {:.2f} dB",
+            report.path, getBlockFormatName(report.format), report.width, report.height, report.mipCount,
+            report.sourceBytes, report.cookedBytes, ratio, report.psnr);
+
+        csv << '"' << report.path << "\"," << getBlockFormatName(report.format) << ',' << report.width << ',' << report.height << ','
+            << report.mipCount << ',' << report.sourceBytes << ',' << report.cookedBytes << ',' << ratio << ','
+            << report.psnr << ',' << report.milliseconds << '\n';
+
+        totalSource += report.sourceBytes;
+        totalCooked += report.cookedBytes;
+    }
+    spdlog::info("{} textures, {} -> {} bytes", reports.size(), totalSource, totalCooked);
+
+    std::string contents = csv.str();
+    if (!writeFile(filePath, contents.data(), contents.size())) {
+        spdlog::error("Failed to write texture report: {}", filePath);
+    }
+}
+
+bool isBlockFormatSupported(BlockFormat format) {
+    switch (format) {
+    case BlockFormat::BC1:
+    case BlockFormat::BC3:
+        return gGLExt.textureCompressionS3tc;
+    case BlockFormat::BC5:
+        return true;
+    case BlockFormat::BC7:
+        return gGLExt.textureCompressionBptc;
+    default:
+        return false;
+    }
+}
+
+bool openCookedTexture(const std::string& sourcePath, CookedImage& cooked) {
+    MappedFile file;
+    if (!mapCookedFile(sourcePath, COOKED_TEXTURE_EXTENSION, kCookedTextureMagic, kCookedTextureVersion, file)) {
+        return false;
+    }
+
+    const CookedTextureHeader* header = cookedRange<CookedTextureHeader>(file, 0, 1);
+    if (!header || getBlockSize((BlockFormat)header->format) == 0 || header->mipCount == 0) {
+        spdlog::warn("Cooked texture has an invalid header: {}", sourcePath);
+        return false;
+    }
+
+    if (!isBlockFormatSupported((BlockFormat)header->format)) {
+        // Once per run, every texture of the format would say the same
+        static std::atomic<bool> warned{ false };
+        if (!warned.exchange(true)) {
+            spdlog::warn("{} textures cannot be uploaded on this driver, decoding their sources instead", getBlockFormatName((BlockFormat)header->format));
+        }
+        return false;
+    }
+
+    const CookedMipLevel* levels = cookedRange<CookedMipLevel>(file, header->levelsOffset, header->mipCount);
+    if (!levels) {
+        spdlog::warn("Cooked texture has an invalid level table: {}", sourcePath);
+        return false;
+    }
+    for (uint32_t i = 0; i < header->mipCount; i++) {
+        if (!cookedRange<unsigned char>(file, levels[i].offset, levels[i].size) ||
+            levels[i].size != getCompressedSize((BlockFormat)header->format, levels[i].width, levels[i].height)) {
+            spdlog::warn("Cooked texture has an invalid mip level: {}", sourcePath);
+            return false;
+        }
+    }
+
+    cooked.file = std::move(file);
+    cooked.header = header;
+    cooked.levels = levels;
+    return true;
+}
+
+uint32_t getStreamingTailMip(const CookedImage& cooked) {
+    uint32_t mip = 0;
+    while (mip + 1 < cooked.header->mipCount && std::max(cooked.levels[mip].width, cooked.levels[mip].height) > kStreamingTailSize) {
+        mip++;
+    }
+    return mip;
+}
+
+unsigned int uploadCookedTexture(const CookedImage& cooked, uint32_t firstMip) {
+    std::vector<CompressedLevel> levels(cooked.header->mipCount);
+    for (uint32_t i = firstMip; i < cooked.header->mipCount; i++) {
+        levels[i].data = cooked.file.data + cooked.levels[i].offset;
+        levels[i].size = cooked.levels[i].size;
+        levels[i].width = (int)cooked.levels[i].width;
+        levels[i].height = (int)cooked.levels[i].height;
+    }
+    return uploadCompressedTexture2D(getGLFormat((BlockFormat)cooked.header->format), levels.data(), (int)levels.size(), (int)firstMip);
+}
+
+bool uploadCookedMip(unsigned int textureID, const CookedImage& cooked, uint32_t mip, const unsigned char* data) {
+    CompressedLevel level;
+    level.data = data;
+    level.size = cooked.levels[mip].size;
+    level.width = (int)cooked.levels[mip].width;
+    level.height = (int)cooked.levels[mip].height;
+    return uploadCompressedLevel(textureID, getGLFormat((BlockFormat)cooked.header->format), (int)mip, level);
+}
+
+void releaseCookedMip(unsigned int textureID, const CookedImage& cooked, uint32_t mip) {
+    releaseCompressedLevel(textureID, getGLFormat((BlockFormat)cooked.header->format), (int)mip);
+}
+
+size_t getCookedTextureMemory(const CookedImage& cooked, uint32_t firstMip) {
+    size_t bytes = 0;
+    for (uint32_t i = firstMip; i < cooked.header->mipCount; i++) {
+        bytes += cooked.levels[i].size;
+    }
+    return bytes;
+}
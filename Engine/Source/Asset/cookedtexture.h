@@ -0,0 +1,98 @@
+#pragma once
+#ifndef COOKED_TEXTURE_H
+#define COOKED_TEXTURE_H
+
+#include "Asset/bcn.h"
+#include "Asset/cook.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define COOKED_TEXTURE_EXTENSION ".tex"
+
+constexpr uint32_t kCookedTextureMagic = makeFourCC('E', 'T', 'E', 'X');
+constexpr uint32_t kCookedTextureVersion = 1;
+
+// Colour textures get sRGB-correct mip filtering, normal maps are filtered
+// linearly and renormalized
+enum class TextureUsage : uint32_t {
+	Color = 0,
+	Normal = 1,
+};
+
+// Mip addressable texture container modelled on KTX2: a level table indexed by
+// mip level, with level data laid out smallest mip first so the low mips of a
+// file sit together at the front. Every level is already block compressed.
+struct CookedTextureHeader {
+	CookHeader cook;
+	uint32_t format; // BlockFormat
+	uint32_t usage;  // TextureUsage
+	uint32_t width;
+	uint32_t height;
+	uint32_t mipCount;
+	uint32_t padding;
+	uint64_t levelsOffset;
+};
+
+struct CookedMipLevel {
+	uint64_t offset;
+	uint64_t size;
+	uint32_t width;
+	uint32_t height;
+};
+
+// Validated view of a mapped cooked texture
+struct CookedImage {
+	MappedFile file;
+	const CookedTextureHeader* header = nullptr;
+	const CookedMipLevel* levels = nullptr;
+};
+
+struct TextureCookReport {
+	std::string path;
+	BlockFormat format = BlockFormat::None;
+	uint32_t width = 0;
+	uint32_t height = 0;
+	uint32_t mipCount = 0;
+	size_t sourceBytes = 0; // RGBA8 with the same mip chain
+	size_t cookedBytes = 0;
+	float psnr = 0.0f;      // of the top level, over the channels the format keeps
+	float milliseconds = 0.0f;
+};
+
+// Picks BC5 for normal maps, BC7 for colour with alpha and BC1 otherwise
+BlockFormat chooseBlockFormat(TextureUsage usage, const unsigned char* rgba, size_t pixelCount);
+
+// Offline cook step: decodes the source, builds the mip chain and block compresses
+// every level on all cores. No GL required. format None picks one automatically.
+bool cookTexture(const std::string& sourcePath, TextureUsage usage, BlockFormat format = BlockFormat::None, TextureCookReport* report = nullptr);
+
+// Logs the reports as a table and writes them to a CSV file
+void writeTextureCookReport(const std::vector<TextureCookReport>& reports, const std::string& filePath);
+
+// Whether the context can upload the format, after loadGLExtensions
+bool isBlockFormatSupported(BlockFormat format);
+
+// Maps and validates the cooked texture for sourcePath. CPU only, safe on any
+// thread. Also false for a format the context cannot upload, callers then
+// decode the source image instead.
+bool openCookedTexture(const std::string& sourcePath, CookedImage& cooked);
+
+// Smallest mips up to this size are uploaded with the texture, larger ones are streamed
+constexpr uint32_t kStreamingTailSize = 64;
+
+// Finest level that is at most kStreamingTailSize on either side
+uint32_t getStreamingTailMip(const CookedImage& cooked);
+
+// Uploads firstMip and every smaller level with glCompressedTexImage2D. Returns 0 on failure.
+unsigned int uploadCookedTexture(const CookedImage& cooked, uint32_t firstMip = 0);
+// Residency changes for streamed textures. data holds the level's blocks, read
+// off the mapping on a worker so the GL thread never faults in file pages.
+bool uploadCookedMip(unsigned int textureID, const CookedImage& cooked, uint32_t mip, const unsigned char* data);
+void releaseCookedMip(unsigned int textureID, const CookedImage& cooked, uint32_t mip);
+
+// Bytes of firstMip and every smaller level
+size_t getCookedTextureMemory(const CookedImage& cooked, uint32_t firstMip = 0);
+
+#endif
@@ -0,0 +1,225 @@
+#pragma once
+#ifndef ASSET_HANDLE_H
+#define ASSET_HANDLE_H
+
+#include "Core/file.h"
+#include "Core/hash.h"
+
+#include <spdlog/spdlog.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Stable 64-bit asset ID: the hash of the normalized source path. Identical on
+// every platform and run, so cooked files may store it.
+using AssetId = uint64_t;
+
+inline AssetId makeAssetId(const std::string& filePath) {
+    return hash64(normalizePath(filePath));
+}
+
+// Assets built from two sources, e.g. a vertex/fragment shader pair
+inline AssetId makeAssetId(const std::string& firstPath, const std::string& secondPath) {
+    return hashCombine(makeAssetId(firstPath), makeAssetId(secondPath));
+}
+
+// Resident bytes of an asset, or the budget for a whole category
+struct AssetMemory {
+    size_t cpuBytes = 0;
+    size_t gpuBytes = 0;
+};
+
+// Index into an AssetPool slot plus the generation the slot had when the handle
+// was issued. Once the slot is freed and reused the handle no longer resolves.
+template <typename T>
+struct Handle {
+    uint32_t index = 0;
+    uint32_t generation = 0; // Never issued, a default handle is invalid
+
+    bool isValid() const { return generation != 0; }
+    bool operator==(const Handle& other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const Handle& other) const { return !(*this == other); }
+};
+
+// Dense slot array of owned assets. Handles resolve with a single index and
+// generation compare; the ID map is only consulted when loading by path.
+//
+// Owners hold a reference on the assets they use. Unreferenced assets stay
+// cached until the pool goes over its budget, then the least recently used
+// ones are evicted and get reloaded the next time something asks for them.
+template <typename T>
+class AssetPool {
+public:
+    // Invalid handle if nothing with this ID is loaded. The name is compared
+    // against the one the asset was added with to catch hash collisions.
+    Handle<T> find(AssetId id, const std::string& name) const {
+        auto it = m_Lookup.find(id);
+        if (it == m_Lookup.end()) {
+            return {};
+        }
+
+        const Slot& slot = m_Slots[it->second];
+        if (slot.name != name) {
+            spdlog::error("Asset ID collision between {} and {}", slot.name, name);
+            return {};
+        }
+        return Handle<T>{ it->second, slot.generation };
+    }
+
+    // Lookup by ID alone, for IDs read from cooked data
+    Handle<T> find(AssetId id) const {
+        auto it = m_Lookup.find(id);
+        if (it == m_Lookup.end()) {
+            return {};
+        }
+        return Handle<T>{ it->second, m_Slots[it->second].generation };
+    }
+
+    Handle<T> add(AssetId id, const std::string& name, std::unique_ptr<T> asset, AssetMemory memory = {}) {
+        uint32_t index;
+        if (!m_FreeSlots.empty()) {
+            index = m_FreeSlots.back();
+            m_FreeSlots.pop_back();
+        }
+        else {
+            index = (uint32_t)m_Slots.size();
+            m_Slots.emplace_back();
+        }
+
+        Slot& slot = m_Slots[index];
+        slot.asset = std::move(asset);
+        slot.id = id;
+        slot.name = name;
+        slot.memory = memory;
+        slot.refCount = 0;
+        slot.lastUsed = m_Frame;
+        m_Lookup[id] = index;
+        m_Memory.cpuBytes += memory.cpuBytes;
+        m_Memory.gpuBytes += memory.gpuBytes;
+        return Handle<T>{ index, slot.generation };
+    }
+
+    // nullptr for invalid or stale handles. Counts as a use for eviction.
+    T* get(Handle<T> handle) const {
+        if (handle.index >= m_Slots.size() || m_Slots[handle.index].generation != handle.generation) {
+            return nullptr;
+        }
+        const Slot& slot = m_Slots[handle.index];
+        slot.lastUsed = m_Frame;
+        return slot.asset.get();
+    }
+
+    bool contains(Handle<T> handle) const {
+        return handle.index < m_Slots.size() && m_Slots[handle.index].generation == handle.generation && m_Slots[handle.index].asset;
+    }
+
+    void addRef(Handle<T> handle) {
+        if (contains(handle)) {
+            m_Slots[handle.index].refCount++;
+        }
+    }
+
+    void release(Handle<T> handle) {
+        if (contains(handle) && m_Slots[handle.index].refCount > 0) {
+            m_Slots[handle.index].refCount--;
+        }
+    }
+
+    uint32_t getRefCount(Handle<T> handle) const {
+        return contains(handle) ? m_Slots[handle.index].refCount : 0;
+    }
+
+    // Frees the slot and hands the asset back so the caller can release its GL resources
+    std::unique_ptr<T> remove(Handle<T> handle) {
+        if (!contains(handle)) {
+            return nullptr;
+        }
+
+        Slot& slot = m_Slots[handle.index];
+        std::unique_ptr<T> asset = std::move(slot.asset);
+        m_Lookup.erase(slot.id);
+        m_Memory.cpuBytes -= slot.memory.cpuBytes;
+        m_Memory.gpuBytes -= slot.memory.gpuBytes;
+        slot.memory = {};
+        slot.refCount = 0;
+        slot.name.clear();
+        // Skip 0 on wrap so a reused slot can never look like a default handle
+        if (++slot.generation == 0) {
+            slot.generation = 1;
+        }
+        m_FreeSlots.push_back(handle.index);
+        return asset;
+    }
+
+    // For assets whose residency changes after loading, e.g. streamed texture mips
+    void setMemory(Handle<T> handle, AssetMemory memory) {
+        if (!contains(handle)) {
+            return;
+        }
+        Slot& slot = m_Slots[handle.index];
+        m_Memory.cpuBytes += memory.cpuBytes - slot.memory.cpuBytes;
+        m_Memory.gpuBytes += memory.gpuBytes - slot.memory.gpuBytes;
+        slot.memory = memory;
+    }
+
+    // Advances the clock that get() stamps assets with, once per frame
+    void nextFrame() { m_Frame++; }
+
+    void setBudget(AssetMemory budget) { m_Budget = budget; }
+    AssetMemory getBudget() const { return m_Budget; }
+    AssetMemory getMemory() const { return m_Memory; }
+
+    bool isOverBudget() const {
+        return m_Memory.cpuBytes > m_Budget.cpuBytes || m_Memory.gpuBytes > m_Budget.gpuBytes;
+    }
+
+    // Least recently used asset nobody holds a reference on, invalid if there is none
+    Handle<T> findEvictionCandidate() const {
+        Handle<T> candidate;
+        uint64_t oldest = UINT64_MAX;
+        for (uint32_t i = 0; i < (uint32_t)m_Slots.size(); i++) {
+            const Slot& slot = m_Slots[i];
+            if (slot.asset && slot.refCount == 0 && slot.lastUsed < oldest) {
+                candidate = Handle<T>{ i, slot.generation };
+                oldest = slot.lastUsed;
+            }
+        }
+        return candidate;
+    }
+
+    AssetId getId(Handle<T> handle) const {
+        return contains(handle) ? m_Slots[handle.index].id : 0;
+    }
+
+    const std::string& getName(Handle<T> handle) const {
+        static const std::string empty;
+        return contains(handle) ? m_Slots[handle.index].name : empty;
+    }
+
+    size_t size() const { return m_Lookup.size(); }
+
+private:
+    struct Slot {
+        std::unique_ptr<T> asset;
+        AssetId id = 0;
+        uint32_t generation = 1;
+        uint32_t refCount = 0;
+        mutable uint64_t lastUsed = 0;
+        AssetMemory memory;
+        std::string name;
+    };
+
+    std::vector<Slot> m_Slots;
+    std::vector<uint32_t> m_FreeSlots;
+    std::unordered_map<AssetId, uint32_t> m_Lookup;
+
+    uint64_t m_Frame = 0;
+    AssetMemory m_Memory;
+    AssetMemory m_Budget{ SIZE_MAX, SIZE_MAX };
+};
+
+#endif
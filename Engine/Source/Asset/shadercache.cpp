@@ -0,0 +1,81 @@
+#include "Asset/shadercache.h"
+#include "Core/hash.h"
+#include "Graphics/shader.h"
+
+#include <spdlog/spdlog.h>
+
+namespace {
+    std::string getCachePath(uint64_t key) {
+        return fmt::format(SHADER_CACHE_DIRECTORY "{:016x}" SHADER_CACHE_EXTENSION, key);
+    }
+
+    uint64_t getDriverHash() {
+        static const uint64_t hash = [] {
+            uint64_t value = 0;
+            for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION }) {
+                const char* text = reinterpret_cast<const char*>(glGetString(name));
+                value = hash64(text ? std::string_view(text) : std::string_view(), value);
+            }
+            return value;
+        }();
+        return hash;
+    }
+}
+
+uint64_t makeShaderCacheKey(const std::vector<std::string_view>& sources, std::string_view defines) {
+    uint64_t key = hash64(defines, getDriverHash());
+    for (std::string_view source : sources) {
+        // Hashed separately so moving text from one stage to the next changes the key
+        key = hashCombine(key, hash64(source));
+    }
+    return key;
+}
+
+bool loadCachedProgram(uint64_t key, ShaderProgram& program) {
+    MappedFile file;
+    if (!mapFile(getCachePath(key), file)) {
+        return false;
+    }
+
+    const ShaderCacheHeader* header = cookedRange<ShaderCacheHeader>(file, 0, 1);
+    if (!header || header->magic != kShaderCacheMagic || header->version != kShaderCacheVersion || header->key != key) {
+        return false;
+    }
+
+    const unsigned char* binary = cookedRange<unsigned char>(file, sizeof(ShaderCacheHeader), header->binarySize);
+    if (!binary) {
+        return false;
+    }
+
+    if (!program.loadBinary(header->binaryFormat, binary, header->binarySize)) {
+        spdlog::warn("Cached shader binary {:016x} was rejected by the driver", key);
+        return false;
+    }
+    return true;
+}
+
+bool storeCachedProgram(uint64_t key, const ShaderProgram& program) {
+    unsigned int format = 0;
+    std::vector<unsigned char> binary;
+    if (!program.getBinary(format, binary)) {
+        return false;
+    }
+
+    ShaderCacheHeader header{};
+    header.magic = kShaderCacheMagic;
+    header.version = kShaderCacheVersion;
+    header.key = key;
+    header.binaryFormat = format;
+    header.binarySize = binary.size();
+
+    BlobWriter blob;
+    blob.write(header);
+    blob.write(binary.data(), binary.size());
+
+    std::string path = getCachePath(key);
+    if (!writeFile(path, blob.bytes.data(), blob.size())) {
+        spdlog::warn("Failed to write shader cache {}", path);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#ifndef SHADER_CACHE_H
+#define SHADER_CACHE_H
+
+#include "Asset/cook.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct ShaderProgram;
+
+// Linked program binaries, one file per key. Unlike cooked assets these are only
+// valid for the driver that produced them, which is part of the key.
+#define SHADER_CACHE_DIRECTORY COOKED_DIRECTORY "ShaderCache/"
+#define SHADER_CACHE_EXTENSION ".bin"
+
+constexpr uint32_t kShaderCacheMagic = makeFourCC('E', 'S', 'P', 'B');
+constexpr uint32_t kShaderCacheVersion = 1;
+
+struct ShaderCacheHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint64_t key;
+	uint32_t binaryFormat;
+	uint32_t padding;
+	uint64_t binarySize;
+};
+
+// Hash of the program's source text, its defines and the GL vendor, renderer
+// and version strings. Needs the GL context.
+uint64_t makeShaderCacheKey(const std::vector<std::string_view>& sources, std::string_view defines = {});
+
+// Restores the program from the cache. False on a miss or when the driver
+// rejects the stored binary.
+bool loadCachedProgram(uint64_t key, ShaderProgram& program);
+
+// Stores a program linked after setBinaryRetrievable()
+bool storeCachedProgram(uint64_t key, const ShaderProgram& program);
+
+#endif
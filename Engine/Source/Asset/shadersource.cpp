@@ -0,0 +1,167 @@
+#include "Asset/shadersource.h"
+#include "Core/vfs.h"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+
+namespace {
+    // Includes may include others; deeper than this is taken for a cycle
+    constexpr int kMaxIncludeDepth = 16;
+
+    // Filename of an #include "name" line, the same lines stb_include used to take
+    bool parseInclude(const std::string& text, size_t begin, size_t end, std::string& name) {
+        size_t i = begin;
+        auto skipBlanks = [&]() {
+            while (i < end && (text[i] == ' ' || text[i] == '\t')) {
+                i++;
+            }
+        };
+        skipBlanks();
+        if (i >= end || text[i] != '#') {
+            return false;
+        }
+        i++;
+        skipBlanks();
+        if (text.compare(i, 7, "include") != 0 || i + 7 >= end || (text[i + 7] != ' ' && text[i + 7] != '\t')) {
+            return false;
+        }
+        i += 7;
+        skipBlanks();
+        if (i >= end || text[i] != '"') {
+            return false;
+        }
+        size_t close = text.find('"', i + 1);
+        if (close == std::string::npos || close >= end) {
+            return false;
+        }
+        name = text.substr(i + 1, close - i - 1);
+        return true;
+    }
+
+    // Every include resolves against the root shader's directory. GLSL #line
+    // takes source string numbers instead of file names: an include is counted
+    // from 1 within its parent, 0 is back in the parent.
+    bool expandIncludes(const VirtualFileSystem& vfs, const std::string& text, const std::string& directory, int depth, std::string& out, std::string& error) {
+        int lineNumber = 1;
+        int includeCount = 0;
+        size_t lineStart = 0;
+        while (lineStart < text.size()) {
+            size_t lineEnd = text.find('\n', lineStart);
+            if (lineEnd == std::string::npos) {
+                lineEnd = text.size();
+            }
+
+            std::string name;
+            if (parseInclude(text, lineStart, lineEnd, name)) {
+                if (depth >= kMaxIncludeDepth) {
+                    error = "includes nested too deep at " + name;
+                    return false;
+                }
+                std::string includePath = directory + "/" + name;
+                std::string included;
+                FileError readError = readVirtualFile(vfs, includePath, included);
+                if (readError != FileError::None) {
+                    error = "cannot read " + includePath + ": " + getFileErrorName(readError);
+                    return false;
+                }
+
+                includeCount++;
+                // #version has to stay first, nothing goes above a leading include
+                if (!out.empty()) {
+                    out += "#line 1 " + std::to_string(includeCount) + "\n";
+                }
+                if (!expandIncludes(vfs, included, directory, depth + 1, out, error)) {
+                    return false;
+                }
+                if (!out.empty() && out.back() != '\n') {
+                    out += '\n';
+                }
+                out += "#line " + std::to_string(lineNumber + 1) + " 0\n";
+            }
+            else {
+                out.append(text, lineStart, lineEnd - lineStart);
+                if (lineEnd < text.size()) {
+                    out += '\n';
+                }
+            }
+            lineStart = lineEnd + 1;
+            lineNumber++;
+        }
+        return true;
+    }
+}
+
+std::string getShaderDefinesText(const ShaderDefines& defines) {
+    ShaderDefines sorted = defines;
+    std::sort(sorted.begin(), sorted.end());
+
+    std::string text;
+    for (const auto& [name, value] : sorted) {
+        text += "#define " + name;
+        if (!value.empty()) {
+            text += " " + value;
+        }
+        text += "\n";
+    }
+    return text;
+}
+
+std::string getShaderPermutationName(const ShaderDefines& defines) {
+    ShaderDefines sorted = defines;
+    std::sort(sorted.begin(), sorted.end());
+
+    std::string name;
+    for (const auto& [key, value] : sorted) {
+        if (!name.empty()) {
+            name += " ";
+        }
+        name += value.empty() ? key : key + "=" + value;
+    }
+    return name;
+}
+
+bool preprocessShader(const std::string& filePath, const std::string& definesText, std::string& source) {
+    return preprocessShader(gVFS, filePath, definesText, source);
+}
+
+bool preprocessShader(const VirtualFileSystem& vfs, const std::string& filePath, const std::string& definesText, std::string& source) {
+    size_t slash = filePath.find_last_of("/\\");
+    std::string directory = slash == std::string::npos ? "." : filePath.substr(0, slash);
+
+    std::string text;
+    FileError readError = readVirtualFile(vfs, filePath, text);
+    if (readError != FileError::None) {
+        spdlog::error("Failed to read shader {}: {}", filePath, getFileErrorName(readError));
+        return false;
+    }
+
+    // Expanded here rather than by the driver, so the cache key covers the includes
+    std::string error;
+    source.clear();
+    if (!expandIncludes(vfs, text, directory, 0, source, error)) {
+        spdlog::error("Failed to preprocess shader {}: {}", filePath, error);
+        return false;
+    }
+
+    if (definesText.empty()) {
+        return true;
+    }
+
+    // #version has to stay first, the defines go right after it
+    size_t version = source.rfind("#version", 0) == 0 ? 0 : source.find("\n#version");
+    if (version == std::string::npos) {
+        source.insert(0, definesText);
+        return true;
+    }
+    if (version != 0) {
+        version++;
+    }
+
+    size_t lineEnd = source.find('\n', version);
+    size_t insertAt = lineEnd == std::string::npos ? source.size() : lineEnd + 1;
+    size_t versionLine = std::count(source.begin(), source.begin() + version, '\n') + 1;
+    std::string injected = (lineEnd == std::string::npos ? "\n" : "") + definesText + "#line " + std::to_string(versionLine + 1) + " 0\n";
+    source.insert(insertAt, injected);
+    return true;
+}
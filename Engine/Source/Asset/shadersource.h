@@ -0,0 +1,28 @@
+#pragma once
+#ifndef SHADER_SOURCE_H
+#define SHADER_SOURCE_H
+
+#include <string>
+#include <utility>
+#include <vector>
+
+struct VirtualFileSystem;
+
+// Permutation keys such as SKINNED, INSTANCED, BONES_PER_VERTEX or LOD, injected
+// as #defines. An empty value defines the key without one.
+using ShaderDefines = std::vector<std::pair<std::string, std::string>>;
+
+// One #define per line, sorted by name so every spelling of a permutation
+// expands and hashes the same
+std::string getShaderDefinesText(const ShaderDefines& defines);
+
+// "SKINNED BONES_PER_VERTEX=4", for asset names and logs
+std::string getShaderPermutationName(const ShaderDefines& defines);
+
+// Reads a GLSL file, resolves #include "..." relative to its directory and
+// inserts definesText right after #version. The file and its includes are read
+// through the VFS, so a pack alone is enough. Errors are logged.
+bool preprocessShader(const VirtualFileSystem& vfs, const std::string& filePath, const std::string& definesText, std::string& source);
+bool preprocessShader(const std::string& filePath, const std::string& definesText, std::string& source);
+
+#endif
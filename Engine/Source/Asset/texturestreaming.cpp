@@ -0,0 +1,230 @@
+#include "Asset/texturestreaming.h"
+#include "Asset/asset.h"
+#include "Asset/asyncloader.h"
+#include "Core/arena.h"
+#include "Core/profiler.h"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace {
+    constexpr float kMegabyte = 1024.0f * 1024.0f;
+
+    size_t getStreamedBytes(const StreamedTexture& texture) {
+        size_t bytes = 0;
+        for (uint32_t mip = texture.residentMip; mip < texture.tailMip; mip++) {
+            bytes += texture.image->levels[mip].size;
+        }
+        return bytes;
+    }
+
+    // Finest level anything asked for this frame, just the tail if nothing did
+    uint32_t getTargetMip(const TextureStreaming& streaming, const StreamedTexture& texture) {
+        return texture.wantedFrame == streaming.frame ? texture.wantedMip : texture.tailMip;
+    }
+
+    void updatePoolMemory(Assets& assets, const StreamedTexture& texture) {
+        AssetMemory memory;
+        memory.gpuBytes = getCookedTextureMemory(*texture.image, texture.residentMip);
+        assets.textures.setMemory(texture.handle, memory);
+    }
+
+    void releaseMip(Assets& assets, TextureStreaming& streaming, StreamedTexture& texture) {
+        Texture* gpuTexture = assets.textures.get(texture.handle);
+        if (!gpuTexture) {
+            return;
+        }
+
+        releaseCookedMip(gpuTexture->id, *texture.image, texture.residentMip);
+        streaming.residentBytes -= texture.image->levels[texture.residentMip].size;
+        texture.residentMip++;
+        updatePoolMemory(assets, texture);
+    }
+
+    // Makes room for level mip of another texture. Levels nobody needs go first,
+    // then the largest level finer than the one being loaded, so the budget ends
+    // up spread evenly instead of one texture holding on to all of it.
+    bool releaseForLoad(Assets& assets, TextureStreaming& streaming, uint32_t mip, const StreamedTexture& loading) {
+        StreamedTexture* victim = nullptr;
+        bool victimUnneeded = false;
+        for (auto& [index, texture] : streaming.textures) {
+            if (&texture == &loading || texture.loading || texture.residentMip >= texture.tailMip) {
+                continue;
+            }
+
+            bool unneeded = texture.residentMip < getTargetMip(streaming, texture);
+            if (!unneeded && texture.residentMip >= mip) {
+                continue;
+            }
+            if (!victim || unneeded > victimUnneeded || (unneeded == victimUnneeded && texture.residentMip < victim->residentMip)) {
+                victim = &texture;
+                victimUnneeded = unneeded;
+            }
+        }
+
+        if (!victim) {
+            return false;
+        }
+        releaseMip(assets, streaming, *victim);
+        return true;
+    }
+
+    void loadMip(Assets& assets, AsyncLoader& loader, TextureStreaming& streaming, StreamedTexture& texture) {
+        uint32_t mip = texture.residentMip - 1;
+        size_t size = texture.image->levels[mip].size;
+        texture.loading = true;
+        streaming.loads++;
+        streaming.loadingBytes += size;
+
+        Handle<Texture> handle = texture.handle;
+        std::shared_ptr<CookedImage> image = texture.image;
+        Assets* assetsPtr = &assets;
+        AsyncLoader* loaderPtr = &loader;
+        loader.workers.submit([=]() {
+            // Copying out of the mapping faults its pages in here rather than on the GL thread
+            const unsigned char* blocks = image->file.data + image->levels[mip].offset;
+            auto data = std::make_shared<std::vector<unsigned char>>(blocks, blocks + size);
+
+            queueUpload(*loaderPtr, size, [=]() {
+                TextureStreaming& streaming = assetsPtr->streaming;
+                streaming.loads--;
+                streaming.loadingBytes -= size;
+
+                auto it = streaming.textures.find(handle.index);
+                if (it == streaming.textures.end() || it->second.handle != handle) {
+                    return; // Evicted while loading
+                }
+
+                StreamedTexture& texture = it->second;
+                texture.loading = false;
+                Texture* gpuTexture = assetsPtr->textures.get(handle);
+                if (!gpuTexture || texture.residentMip != mip + 1) {
+                    return;
+                }
+                if (!uploadCookedMip(gpuTexture->id, *image, mip, data->data())) {
+                    spdlog::error("Failed to stream mip {} of {}", mip, assetsPtr->textures.getName(handle));
+                    return;
+                }
+
+                texture.residentMip = mip;
+                streaming.residentBytes += size;
+                updatePoolMemory(*assetsPtr, texture);
+            });
+        });
+    }
+}
+
+void streamTexture(TextureStreaming& streaming, Handle<Texture> handle, std::shared_ptr<CookedImage> image, uint32_t tailMip) {
+    if (tailMip == 0) {
+        return; // Small enough to be all tail, nothing to stream
+    }
+
+    StreamedTexture& texture = streaming.textures[handle.index];
+    if (texture.image) {
+        // The slot was freed and reused before the last update noticed
+        streaming.residentBytes -= getStreamedBytes(texture);
+    }
+
+    texture = StreamedTexture{};
+    texture.handle = handle;
+    texture.image = std::move(image);
+    texture.tailMip = tailMip;
+    texture.residentMip = tailMip;
+    texture.wantedMip = tailMip;
+    texture.lastNeededFrame = streaming.frame;
+}
+
+void requestTextureMip(TextureStreaming& streaming, Handle<Texture> handle, float screenPixelsPerUv) {
+    auto it = streaming.textures.find(handle.index);
+    if (it == streaming.textures.end() || it->second.handle != handle || screenPixelsPerUv <= 0.0f) {
+        return;
+    }
+
+    // Texels per unit of UV halve with every level. Trilinear filtering blends
+    // floor(lod) with the next smaller level, so floor(lod) has to be resident.
+    StreamedTexture& texture = it->second;
+    const CookedTextureHeader* header = texture.image->header;
+    float texelsPerUv = std::sqrt(float(header->width) * float(header->height));
+    float lod = std::log2(texelsPerUv / screenPixelsPerUv) + streaming.mipBias;
+    uint32_t mip = (uint32_t)std::clamp(std::floor(lod), 0.0f, float(texture.tailMip));
+
+    if (texture.wantedFrame != streaming.frame) {
+        texture.wantedFrame = streaming.frame;
+        texture.wantedMip = mip;
+    }
+    else {
+        texture.wantedMip = std::min(texture.wantedMip, mip);
+    }
+}
+
+void updateTextureStreaming(Assets& assets, AsyncLoader& loader) {
+    PROFILE_ZONE("updateTextureStreaming");
+    TextureStreaming& streaming = assets.streaming;
+
+    ArenaVector<StreamedTexture*> wanting{ ArenaAllocator<StreamedTexture*>(getFrameArena()) };
+    for (auto it = streaming.textures.begin(); it != streaming.textures.end();) {
+        StreamedTexture& texture = it->second;
+        if (!assets.textures.contains(texture.handle)) {
+            streaming.residentBytes -= getStreamedBytes(texture);
+            it = streaming.textures.erase(it);
+            continue;
+        }
+
+        uint32_t target = getTargetMip(streaming, texture);
+        if (target <= texture.residentMip) {
+            texture.lastNeededFrame = streaming.frame;
+        }
+        else if (!texture.loading && streaming.frame - texture.lastNeededFrame > streaming.releaseDelay) {
+            // Unneeded for a while, give back one level per frame
+            releaseMip(assets, streaming, texture);
+        }
+
+        if (target < texture.residentMip && !texture.loading) {
+            wanting.push_back(&texture);
+        }
+        ++it;
+    }
+
+    // Furthest from what they need first, then the coarsest, where a level costs least
+    std::sort(wanting.begin(), wanting.end(), [&](const StreamedTexture* a, const StreamedTexture* b) {
+        uint32_t missingA = a->residentMip - getTargetMip(streaming, *a);
+        uint32_t missingB = b->residentMip - getTargetMip(streaming, *b);
+        if (missingA != missingB) {
+            return missingA > missingB;
+        }
+        return a->residentMip > b->residentMip;
+    });
+
+    for (StreamedTexture* texture : wanting) {
+        if (streaming.loads >= streaming.maxLoads) {
+            break;
+        }
+
+        uint32_t mip = texture->residentMip - 1;
+        size_t size = texture->image->levels[mip].size;
+        if (size > streaming.budget) {
+            continue;
+        }
+
+        bool fits = true;
+        while (streaming.residentBytes + streaming.loadingBytes + size > streaming.budget) {
+            if (!releaseForLoad(assets, streaming, mip, *texture)) {
+                fits = false;
+                break;
+            }
+        }
+        if (fits) {
+            loadMip(assets, loader, streaming, *texture);
+        }
+    }
+
+    streaming.frame++;
+}
+
+void logTextureStreaming(const TextureStreaming& streaming) {
+    spdlog::info("Texture streaming: {} textures, {:.1f} of {:.1f} MB streamed in",
+        streaming.textures.size(), streaming.residentBytes / kMegabyte, streaming.budget / kMegabyte);
+}
@@ -0,0 +1,59 @@
+#pragma once
+#ifndef TEXTURE_STREAMING_H
+#define TEXTURE_STREAMING_H
+
+#include "Asset/cookedtexture.h"
+#include "Asset/handle.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+
+struct Texture;
+struct Assets;
+struct AsyncLoader;
+
+// Mip residency of one cooked texture. Level 0 is full resolution; residentMip
+// and every smaller level are on the GPU. The tail is uploaded with the texture
+// and stays resident for as long as it lives.
+struct StreamedTexture {
+	Handle<Texture> handle;
+	std::shared_ptr<CookedImage> image;
+	uint32_t tailMip = 0;
+	uint32_t residentMip = 0;
+	uint32_t wantedMip = 0;      // finest level asked for during wantedFrame
+	uint64_t wantedFrame = 0;
+	uint64_t lastNeededFrame = 0; // last frame the finest resident level was wanted
+	bool loading = false;
+};
+
+// Textures start with only their smallest mips. Every frame, visible objects ask
+// for the level their projected size needs, larger levels are read on the
+// loader's workers and uploaded under its budget, and levels nobody needs are
+// dropped again when the streamed bytes go over budget or after a grace period.
+struct TextureStreaming {
+	std::unordered_map<uint32_t, StreamedTexture> textures; // keyed by pool slot
+	size_t budget = 256 * 1024 * 1024; // bytes of streamed levels, tails excluded
+	size_t residentBytes = 0;
+	size_t loadingBytes = 0;
+	uint32_t maxLoads = 8; // levels being read at once
+	uint32_t loads = 0;
+	uint64_t releaseDelay = 120; // frames an unneeded level is kept around
+	float mipBias = 0.0f; // positive values trade sharpness for memory
+	uint64_t frame = 1;
+};
+
+// Takes over the mip residency of a texture created by uploadCookedTexture(image, tailMip)
+void streamTexture(TextureStreaming& streaming, Handle<Texture> handle, std::shared_ptr<CookedImage> image, uint32_t tailMip);
+
+// Asks for enough resolution to cover screenPixelsPerUv screen pixels per unit of
+// texture coordinate. Textures that are not streamed are ignored.
+void requestTextureMip(TextureStreaming& streaming, Handle<Texture> handle, float screenPixelsPerUv);
+
+// Releases and schedules levels for this frame's requests. Main thread, once per frame.
+void updateTextureStreaming(Assets& assets, AsyncLoader& loader);
+
+void logTextureStreaming(const TextureStreaming& streaming);
+
+#endif
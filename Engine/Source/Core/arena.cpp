@@ -0,0 +1,79 @@
+#include "arena.h"
+
+FrameArenas gFrameArenas;
+
+LinearArena::LinearArena(size_t capacity, MemoryTag tag) : m_Capacity(capacity), m_Tag(tag) {
+	if (capacity > 0) {
+		MemoryTagScope scope(m_Tag);
+		m_Memory = static_cast<unsigned char*>(::operator new(capacity, std::align_val_t(64)));
+	}
+}
+
+LinearArena::~LinearArena() {
+	rewind(0);
+	if (m_Memory) {
+		::operator delete(m_Memory, std::align_val_t(64));
+	}
+}
+
+void* LinearArena::allocate(size_t size, size_t alignment) {
+	if (m_Used < m_Capacity) {
+		uintptr_t base = reinterpret_cast<uintptr_t>(m_Memory);
+		uintptr_t aligned = (base + m_Used + alignment - 1) & ~uintptr_t(alignment - 1);
+		size_t end = size_t(aligned - base) + size;
+		if (end <= m_Capacity) {
+			m_Used = end;
+			m_Peak = m_Used > m_Peak ? m_Used : m_Peak;
+			return reinterpret_cast<void*>(aligned);
+		}
+	}
+
+	// Out of room: spill into its own block. Past the capacity m_Used only
+	// counts, so the next reset knows how big the main block has to be.
+	size_t alignedSize = (size + alignment - 1) & ~(alignment - 1);
+	size_t spillAlignment = alignment > 64 ? alignment : 64;
+	size_t marker = m_Used > m_Capacity ? m_Used : m_Capacity;
+	MemoryTagScope scope(m_Tag);
+	void* memory = ::operator new(alignedSize, std::align_val_t(spillAlignment));
+	m_Spills.push_back({ memory, spillAlignment, marker });
+	m_Used = marker + alignedSize;
+	m_Peak = m_Used > m_Peak ? m_Used : m_Peak;
+	return memory;
+}
+
+void LinearArena::rewind(size_t marker) {
+	while (!m_Spills.empty() && m_Spills.back().marker >= marker) {
+		::operator delete(m_Spills.back().memory, std::align_val_t(m_Spills.back().alignment));
+		m_Spills.pop_back();
+	}
+	if (marker < m_Used) {
+		m_Used = marker;
+	}
+}
+
+void LinearArena::reset() {
+	bool spilled = m_Peak > m_Capacity;
+	rewind(0);
+
+	if (spilled) {
+		// Grow once to the high water mark plus headroom
+		size_t capacity = m_Peak + m_Peak / 4;
+		MemoryTagScope scope(m_Tag);
+		if (m_Memory) {
+			::operator delete(m_Memory, std::align_val_t(64));
+		}
+		m_Memory = static_cast<unsigned char*>(::operator new(capacity, std::align_val_t(64)));
+		m_Capacity = capacity;
+	}
+	m_Peak = 0;
+}
+
+void beginFrameArena() {
+	gFrameArenas.current ^= 1;
+	gFrameArenas.arenas[gFrameArenas.current].reset();
+}
+
+LinearArena& getScratchArena() {
+	thread_local LinearArena scratch(256 * 1024, MemoryTag::Frame);
+	return scratch;
+}
@@ -0,0 +1,122 @@
+#pragma once
+#ifndef ARENA_H
+#define ARENA_H
+
+#include "memorytags.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+// Bump allocator. Nothing is freed individually; reset() or rewinding to a
+// marker releases everything allocated after it. Running past the capacity
+// spills into extra blocks, and the next full reset grows the main block to
+// the peak, so a steady workload settles into zero heap allocations.
+class LinearArena {
+public:
+	explicit LinearArena(size_t capacity = 0, MemoryTag tag = MemoryTag::Untagged);
+	~LinearArena();
+
+	LinearArena(const LinearArena&) = delete;
+	LinearArena& operator=(const LinearArena&) = delete;
+
+	void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+	template <typename T>
+	T* allocateArray(size_t count) {
+		return static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+	}
+
+	// Frees everything; resizes the main block if the last cycle spilled
+	void reset();
+
+	// For nested scopes: everything allocated after getMarker() goes on rewind()
+	size_t getMarker() const { return m_Used; }
+	void rewind(size_t marker);
+
+	size_t getUsed() const { return m_Used; }
+	size_t getCapacity() const { return m_Capacity; }
+	size_t getPeak() const { return m_Peak; }
+private:
+	unsigned char* m_Memory = nullptr;
+	size_t m_Capacity = 0;
+	size_t m_Used = 0;  // includes spilled bytes, so markers stay ordered
+	size_t m_Peak = 0;
+
+	struct Spill {
+		void* memory;
+		size_t alignment;
+		size_t marker; // m_Used when the spill was made
+	};
+	std::vector<Spill> m_Spills;
+	MemoryTag m_Tag; // the blocks are charged to it, not what is allocated from them
+};
+
+// Two arenas used alternately: what is written during frame N stays valid
+// through frame N + 1, long enough for a render thread to consume it
+struct FrameArenas {
+	LinearArena arenas[2] = { LinearArena(4 * 1024 * 1024, MemoryTag::Frame), LinearArena(4 * 1024 * 1024, MemoryTag::Frame) };
+	uint32_t current = 0;
+};
+
+extern FrameArenas gFrameArenas;
+
+inline LinearArena& getFrameArena() {
+	return gFrameArenas.arenas[gFrameArenas.current];
+}
+
+// Flips to the other arena and clears it. Called once at the top of every frame.
+void beginFrameArena();
+
+// Per thread scratch memory for temporaries inside one function
+LinearArena& getScratchArena();
+
+// Releases the scratch allocated during its lifetime. The outermost scope
+// resets the arena, so a thread that spilled grows its main block to the peak
+// instead of spilling again every time.
+class ScratchScope {
+public:
+	ScratchScope() : m_Arena(getScratchArena()), m_Marker(m_Arena.getMarker()) {}
+	~ScratchScope() {
+		if (m_Marker == 0) {
+			m_Arena.reset();
+		}
+		else {
+			m_Arena.rewind(m_Marker);
+		}
+	}
+
+	ScratchScope(const ScratchScope&) = delete;
+	ScratchScope& operator=(const ScratchScope&) = delete;
+
+	LinearArena& arena() { return m_Arena; }
+private:
+	LinearArena& m_Arena;
+	size_t m_Marker;
+};
+
+// STL allocator over an arena; deallocate is a no-op
+template <typename T>
+struct ArenaAllocator {
+	using value_type = T;
+
+	LinearArena* arena;
+
+	ArenaAllocator(LinearArena& arena) : arena(&arena) {}
+	template <typename U>
+	ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+
+	T* allocate(size_t count) { return arena->allocateArray<T>(count); }
+	void deallocate(T*, size_t) {}
+
+	template <typename U>
+	bool operator==(const ArenaAllocator<U>& other) const { return arena == other.arena; }
+	template <typename U>
+	bool operator!=(const ArenaAllocator<U>& other) const { return arena != other.arena; }
+};
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+#endif
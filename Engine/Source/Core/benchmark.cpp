@@ -0,0 +1,64 @@
+#include "benchmark.h"
+#include "json.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <numeric>
+
+float getSortedPercentile(const std::vector<float>& sorted, float percentile) {
+	if (sorted.empty()) {
+		return 0.0f;
+	}
+	size_t rank = (size_t)std::ceil(percentile / 100.0f * sorted.size());
+	return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+
+std::string getBenchmarkReportJson(const BenchmarkReport& report) {
+	std::vector<float> sorted = report.frameMilliseconds;
+	std::sort(sorted.begin(), sorted.end());
+	float total = std::accumulate(sorted.begin(), sorted.end(), 0.0f);
+	float mean = sorted.empty() ? 0.0f : total / sorted.size();
+
+	char line[512];
+	std::string json = "{\n";
+	json += "  \"backend\": ";
+	appendJsonString(json, report.backend);
+	json += ",\n";
+	std::snprintf(line, sizeof(line), "  \"width\": %d,\n  \"height\": %d,\n  \"frames\": %zu,\n  \"startupMs\": %.3f,\n",
+		report.width, report.height, sorted.size(), report.startupMilliseconds);
+	json += line;
+	std::snprintf(line, sizeof(line),
+		"  \"frameMs\": { \"mean\": %.4f, \"min\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f, \"total\": %.3f },\n",
+		mean, sorted.empty() ? 0.0f : sorted.front(), getSortedPercentile(sorted, 50.0f), getSortedPercentile(sorted, 95.0f),
+		getSortedPercentile(sorted, 99.0f), sorted.empty() ? 0.0f : sorted.back(), total);
+	json += line;
+
+	// In frame order, so spikes can be lined up with what happened
+	json += "  \"frameTimesMs\": [";
+	for (size_t i = 0; i < report.frameMilliseconds.size(); i++) {
+		std::snprintf(line, sizeof(line), "%s%.4f", i > 0 ? ", " : "", report.frameMilliseconds[i]);
+		json += line;
+	}
+	json += "],\n";
+
+	json += "  \"counters\": {";
+	for (size_t i = 0; i < report.counters.size(); i++) {
+		json += i > 0 ? ",\n    " : "\n    ";
+		appendJsonString(json, report.counters[i].first);
+		std::snprintf(line, sizeof(line), ": %llu", (unsigned long long)report.counters[i].second);
+		json += line;
+	}
+	json += report.counters.empty() ? "}\n}\n" : "\n  }\n}\n";
+	return json;
+}
+
+bool writeBenchmarkReport(const std::string& path, const BenchmarkReport& report) {
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file) {
+		return false;
+	}
+	file << getBenchmarkReportJson(report);
+	return bool(file);
+}
@@ -0,0 +1,28 @@
+#pragma once
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Result of a fixed length run (--frames), written as JSON so CI can compare
+// runs. Frame times are wall clock from the start of a frame to its present.
+struct BenchmarkReport {
+	std::string backend;
+	int width = 0;
+	int height = 0;
+	float startupMilliseconds = 0.0f;
+	std::vector<float> frameMilliseconds;
+	// Anything else worth tracking, e.g. GL calls by entry point
+	std::vector<std::pair<std::string, uint64_t>> counters;
+};
+
+// Nearest rank percentile (0-100) of an ascending range, 0 when it is empty
+float getSortedPercentile(const std::vector<float>& sorted, float percentile);
+
+std::string getBenchmarkReportJson(const BenchmarkReport& report);
+bool writeBenchmarkReport(const std::string& path, const BenchmarkReport& report);
+
+#endif
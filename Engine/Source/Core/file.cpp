@@ -1,19 +1,336 @@
 #include "file.h"
 
+#include <atomic>
+#include <cerrno>
+#include <filesystem>
 #include <fstream>
-#include <sstream>
 #include <iostream>
+#include <vector>
 
-std::string readFileToString(const std::string& filePath) {
-	std::ifstream fileStream = std::ifstream(filePath);
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+	FileError getOpenError(const std::string& filePath) {
+		std::error_code error;
+		return std::filesystem::exists(filePath, error) ? FileError::AccessDenied : FileError::NotFound;
+	}
+
+	// Clamps a requested range to the file, size 0 meaning "to the end"
+	FileError getRange(uint64_t fileSize, uint64_t offset, uint64_t& size) {
+		if (offset > fileSize || size > fileSize - offset) {
+			return FileError::OutOfRange;
+		}
+		if (size == 0) {
+			size = fileSize - offset;
+		}
+		return FileError::None;
+	}
+
+	// Unique per writer: the process id keeps processes apart, the counter threads
+	std::string getTempPath(const std::string& filePath) {
+		static std::atomic<uint32_t> counter{ 0 };
+#ifdef _WIN32
+		unsigned long processId = GetCurrentProcessId();
+#else
+		unsigned long processId = (unsigned long)getpid();
+#endif
+		return filePath + ".tmp." + std::to_string(processId) + "." + std::to_string(counter.fetch_add(1, std::memory_order_relaxed));
+	}
+}
+
+const char* getFileErrorName(FileError error) {
+	switch (error) {
+	case FileError::None: return "no error";
+	case FileError::NotFound: return "not found";
+	case FileError::AccessDenied: return "access denied";
+	case FileError::Empty: return "empty file";
+	case FileError::OutOfRange: return "range outside the file";
+	case FileError::ReadFailed: return "read failed";
+	case FileError::MapFailed: return "mapping failed";
+	}
+	return "unknown";
+}
+
+FileError readFile(const std::string& filePath, std::string& contents, uint64_t offset, uint64_t size) {
+	std::ifstream fileStream(filePath, std::ios::binary | std::ios::ate);
+	if (!fileStream) {
+		return getOpenError(filePath);
+	}
+
+	FileError error = getRange(static_cast<uint64_t>(fileStream.tellg()), offset, size);
+	if (error != FileError::None) {
+		return error;
+	}
+
+	// Sized once and read straight into, no intermediate stream buffer
+	contents.resize(static_cast<size_t>(size));
+	fileStream.seekg(static_cast<std::streamoff>(offset));
+	fileStream.read(contents.data(), static_cast<std::streamsize>(size));
 	if (!fileStream) {
-		std::cerr << "Error opening file:" << filePath << std::endl;
-		return "";
+		contents.clear();
+		return FileError::ReadFailed;
+	}
+	return FileError::None;
+}
+
+std::string readFileToString(const std::string& filePath) {
+	std::string contents;
+	FileError error = readFile(filePath, contents);
+	if (error != FileError::None) {
+		std::cerr << "Error reading file:" << filePath << " " << getFileErrorName(error) << std::endl;
+	}
+	return contents;
+}
+
+std::string normalizePath(const std::string& filePath) {
+	std::vector<std::string> segments;
+	bool absolute = !filePath.empty() && (filePath[0] == '/' || filePath[0] == '\\');
+
+	size_t start = 0;
+	while (start <= filePath.size()) {
+		size_t end = filePath.find_first_of("/\\", start);
+		if (end == std::string::npos) {
+			end = filePath.size();
+		}
+
+		std::string segment = filePath.substr(start, end - start);
+		if (segment == "..") {
+			if (!segments.empty() && segments.back() != "..") {
+				segments.pop_back();
+			}
+			else if (!absolute) {
+				segments.push_back(segment);
+			}
+		}
+		else if (!segment.empty() && segment != ".") {
+			segments.push_back(segment);
+		}
+		start = end + 1;
+	}
+
+	std::string path = absolute ? "/" : "";
+	for (size_t i = 0; i < segments.size(); i++) {
+		if (i > 0) {
+			path += '/';
+		}
+		path += segments[i];
+	}
+	return path;
+}
+
+MappedFile::~MappedFile() {
+	unmapFile(*this);
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+	*this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+	if (this != &other) {
+		unmapFile(*this);
+		data = other.data;
+		size = other.size;
+		fileHandle = other.fileHandle;
+		mappingHandle = other.mappingHandle;
+		view = other.view;
+		viewSize = other.viewSize;
+		buffer = std::move(other.buffer);
+		other.data = nullptr;
+		other.size = 0;
+		other.fileHandle = nullptr;
+		other.mappingHandle = nullptr;
+		other.view = nullptr;
+		other.viewSize = 0;
+	}
+	return *this;
+}
+
+bool mapFile(const std::string& filePath, MappedFile& file) {
+	return mapFileRange(filePath, file, 0, 0) == FileError::None;
+}
+
+#ifdef _WIN32
+FileError mapFileRange(const std::string& filePath, MappedFile& file, uint64_t offset, uint64_t size) {
+	unmapFile(file);
+
+	HANDLE fileHandle = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (fileHandle == INVALID_HANDLE_VALUE) {
+		DWORD lastError = GetLastError();
+		return lastError == ERROR_FILE_NOT_FOUND || lastError == ERROR_PATH_NOT_FOUND ? FileError::NotFound : FileError::AccessDenied;
+	}
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(fileHandle, &fileSize)) {
+		CloseHandle(fileHandle);
+		return FileError::ReadFailed;
+	}
+	FileError error = getRange(static_cast<uint64_t>(fileSize.QuadPart), offset, size);
+	if (error == FileError::None && size == 0) {
+		error = FileError::Empty;
+	}
+	if (error != FileError::None) {
+		CloseHandle(fileHandle);
+		return error;
+	}
+
+	HANDLE mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mappingHandle) {
+		CloseHandle(fileHandle);
+		return FileError::MapFailed;
 	}
 
-	std::streambuf* fileBuffer = fileStream.rdbuf();
-	std::stringstream buffer;
-	buffer << fileBuffer;
-	fileStream.close();
-	return buffer.str();
-}
\ No newline at end of file
+	// Views start on the allocation granularity
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	uint64_t viewOffset = offset - offset % info.dwAllocationGranularity;
+	size_t viewSize = static_cast<size_t>(offset - viewOffset + size);
+	void* view = MapViewOfFile(mappingHandle, FILE_MAP_READ, static_cast<DWORD>(viewOffset >> 32), static_cast<DWORD>(viewOffset), viewSize);
+	if (!view) {
+		CloseHandle(mappingHandle);
+		CloseHandle(fileHandle);
+		return FileError::MapFailed;
+	}
+
+	file.data = static_cast<const unsigned char*>(view) + (offset - viewOffset);
+	file.size = static_cast<size_t>(size);
+	file.fileHandle = fileHandle;
+	file.mappingHandle = mappingHandle;
+	file.view = view;
+	file.viewSize = viewSize;
+	return FileError::None;
+}
+
+void unmapFile(MappedFile& file) {
+	if (file.view) {
+		UnmapViewOfFile(file.view);
+	}
+	if (file.mappingHandle) {
+		CloseHandle(file.mappingHandle);
+	}
+	if (file.fileHandle) {
+		CloseHandle(file.fileHandle);
+	}
+	file.data = nullptr;
+	file.size = 0;
+	file.fileHandle = nullptr;
+	file.mappingHandle = nullptr;
+	file.view = nullptr;
+	file.viewSize = 0;
+	file.buffer = {};
+}
+#else
+FileError mapFileRange(const std::string& filePath, MappedFile& file, uint64_t offset, uint64_t size) {
+	unmapFile(file);
+
+	int fd = open(filePath.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return errno == ENOENT || errno == ENOTDIR ? FileError::NotFound : FileError::AccessDenied;
+	}
+
+	struct stat info;
+	if (fstat(fd, &info) != 0) {
+		close(fd);
+		return FileError::ReadFailed;
+	}
+	FileError error = getRange(static_cast<uint64_t>(info.st_size), offset, size);
+	if (error == FileError::None && size == 0) {
+		error = FileError::Empty;
+	}
+	if (error != FileError::None) {
+		close(fd);
+		return error;
+	}
+
+	// mmap offsets have to be page aligned
+	uint64_t pageSize = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+	uint64_t viewOffset = offset - offset % pageSize;
+	size_t viewSize = static_cast<size_t>(offset - viewOffset + size);
+	void* view = mmap(nullptr, viewSize, PROT_READ, MAP_SHARED, fd, static_cast<off_t>(viewOffset));
+	// The mapping keeps its own reference to the file
+	close(fd);
+	if (view == MAP_FAILED) {
+		return FileError::MapFailed;
+	}
+
+	file.data = static_cast<const unsigned char*>(view) + (offset - viewOffset);
+	file.size = static_cast<size_t>(size);
+	file.view = view;
+	file.viewSize = viewSize;
+	return FileError::None;
+}
+
+void unmapFile(MappedFile& file) {
+	if (file.view) {
+		munmap(file.view, file.viewSize);
+	}
+	file.data = nullptr;
+	file.size = 0;
+	file.fileHandle = nullptr;
+	file.mappingHandle = nullptr;
+	file.view = nullptr;
+	file.viewSize = 0;
+	file.buffer = {};
+}
+#endif
+
+bool getFileStamp(const std::string& filePath, FileStamp& stamp) {
+	std::error_code error;
+	auto size = std::filesystem::file_size(filePath, error);
+	if (error) {
+		return false;
+	}
+	auto writeTime = std::filesystem::last_write_time(filePath, error);
+	if (error) {
+		return false;
+	}
+
+	stamp.size = size;
+	stamp.writeTime = writeTime.time_since_epoch().count();
+	return true;
+}
+
+bool writeFile(const std::string& filePath, const void* data, size_t size) {
+	std::error_code error;
+	std::filesystem::path parent = std::filesystem::path(filePath).parent_path();
+	if (!parent.empty()) {
+		std::filesystem::create_directories(parent, error);
+	}
+
+	// Write next to the destination and rename, so readers never map a half
+	// written file. Concurrent writers of one path each get their own temp file
+	// and the last rename wins.
+	std::string tempPath = getTempPath(filePath);
+	{
+		std::ofstream fileStream(tempPath, std::ios::binary | std::ios::trunc);
+		if (!fileStream) {
+			std::cerr << "Error opening file for writing:" << tempPath << std::endl;
+			return false;
+		}
+
+		fileStream.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+		fileStream.close();
+		if (!fileStream) {
+			std::cerr << "Error writing file:" << tempPath << std::endl;
+			std::filesystem::remove(tempPath, error);
+			return false;
+		}
+	}
+
+	std::filesystem::rename(tempPath, filePath, error);
+	if (error) {
+		std::cerr << "Error replacing file:" << filePath << " " << error.message() << std::endl;
+		std::filesystem::remove(tempPath, error);
+		return false;
+	}
+	return true;
+}
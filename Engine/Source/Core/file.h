@@ -2,8 +2,77 @@
 #ifndef FILE_H
 #define FILE_H
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <string_view>
+#include <vector>
 
+enum class FileError {
+	None,
+	NotFound,
+	AccessDenied,
+	Empty,       // mapping needs at least one byte
+	OutOfRange,  // offset or size past the end of the file
+	ReadFailed,
+	MapFailed,
+};
+
+const char* getFileErrorName(FileError error);
+
+// Reads size bytes starting at offset (0 = to the end) into contents with a
+// single allocation
+FileError readFile(const std::string& filePath, std::string& contents, uint64_t offset = 0, uint64_t size = 0);
+
+// Whole file as a string, empty and logged on failure
 std::string readFileToString(const std::string& filePath);
 
-#endif 
\ No newline at end of file
+// Forward slashes, no "." segments and ".." folded into its parent, so every
+// spelling of a path hashes to the same asset ID
+std::string normalizePath(const std::string& filePath);
+
+// Read-only view of a file, or a range of one, mapped into memory. Unmapped on
+// destruction.
+struct MappedFile {
+	const unsigned char* data = nullptr;
+	size_t size = 0;
+
+	const unsigned char* begin() const { return data; }
+	const unsigned char* end() const { return data + size; }
+	std::string_view text() const { return std::string_view(reinterpret_cast<const char*>(data), size); }
+
+	MappedFile() = default;
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator=(MappedFile&& other) noexcept;
+
+	// Platform handles (file mapping object on Windows)
+	void* fileHandle = nullptr;
+	void* mappingHandle = nullptr;
+	// The mapping starts at an allocation boundary, data points into it
+	void* view = nullptr;
+	size_t viewSize = 0;
+	// Holds the bytes instead of a mapping when they had to be decompressed
+	std::vector<unsigned char> buffer;
+};
+
+// Maps size bytes starting at offset, 0 maps to the end of the file
+FileError mapFileRange(const std::string& filePath, MappedFile& file, uint64_t offset, uint64_t size);
+bool mapFile(const std::string& filePath, MappedFile& file);
+void unmapFile(MappedFile& file);
+
+// Size and last write time of a file, used to detect stale derived data
+struct FileStamp {
+	uint64_t size = 0;
+	int64_t writeTime = 0;
+};
+
+bool getFileStamp(const std::string& filePath, FileStamp& stamp);
+
+// Writes the buffer to disk, creating any missing parent directories
+bool writeFile(const std::string& filePath, const void* data, size_t size);
+
+#endif
@@ -0,0 +1,419 @@
+#include "filequeue.h"
+#include "profiler.h"
+#include "vfs.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <unordered_map>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define FILE_QUEUE_USE_IO_URING
+#include <linux/io_uring.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <atomic>
+#include <cerrno>
+#endif
+
+FileReadQueue gFileReads;
+
+#ifdef FILE_QUEUE_USE_IO_URING
+// Bare io_uring over the raw syscalls, just enough for batches of reads
+struct FileReadQueue::Ring {
+	static constexpr unsigned int kEntries = 256;
+
+	int fd = -1;
+	io_uring_params params = {};
+
+	void* sqRing = MAP_FAILED;
+	size_t sqRingSize = 0;
+	void* cqRing = MAP_FAILED;
+	size_t cqRingSize = 0;
+	io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+	size_t sqesSize = 0;
+
+	unsigned* sqTail = nullptr;
+	unsigned* sqMask = nullptr;
+	unsigned* sqArray = nullptr;
+	unsigned* cqHead = nullptr;
+	unsigned* cqTail = nullptr;
+	unsigned* cqMask = nullptr;
+	io_uring_cqe* cqes = nullptr;
+
+	~Ring() {
+		if (sqes != MAP_FAILED) {
+			munmap(sqes, sqesSize);
+		}
+		if (cqRing != MAP_FAILED && cqRing != sqRing) {
+			munmap(cqRing, cqRingSize);
+		}
+		if (sqRing != MAP_FAILED) {
+			munmap(sqRing, sqRingSize);
+		}
+		if (fd >= 0) {
+			close(fd);
+		}
+	}
+
+	// False when the kernel is too old or io_uring is blocked (containers often do)
+	bool init() {
+		fd = static_cast<int>(syscall(__NR_io_uring_setup, kEntries, &params));
+		if (fd < 0) {
+			return false;
+		}
+
+		sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+		cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+		if (params.features & IORING_FEAT_SINGLE_MMAP) {
+			sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+		}
+
+		sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+		if (sqRing == MAP_FAILED) {
+			return false;
+		}
+		cqRing = (params.features & IORING_FEAT_SINGLE_MMAP) ? sqRing :
+			mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+		if (cqRing == MAP_FAILED) {
+			return false;
+		}
+		sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+		sqes = static_cast<io_uring_sqe*>(mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+		if (sqes == MAP_FAILED) {
+			return false;
+		}
+
+		unsigned char* sq = static_cast<unsigned char*>(sqRing);
+		unsigned char* cq = static_cast<unsigned char*>(cqRing);
+		sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+		sqMask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+		sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+		cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+		cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+		cqMask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+		cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+		return true;
+	}
+
+	unsigned int capacity() const {
+		return params.sq_entries;
+	}
+
+	void queueRead(int file, void* buffer, unsigned int size, uint64_t offset, uint64_t userData) {
+		unsigned tail = *sqTail;
+		unsigned index = tail & *sqMask;
+		io_uring_sqe& sqe = sqes[index];
+		sqe = {};
+		sqe.opcode = IORING_OP_READ;
+		sqe.fd = file;
+		sqe.addr = reinterpret_cast<uint64_t>(buffer);
+		sqe.len = size;
+		sqe.off = offset;
+		sqe.user_data = userData;
+		sqArray[index] = index;
+		__atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+	}
+
+	// Submits up to submitCount queued entries and waits for at least waitCount
+	// completions. Returns how many the kernel took, which can be fewer than
+	// asked; the rest stay queued for the next call. -1 when the ring failed.
+	int enter(unsigned int submitCount, unsigned int waitCount) {
+		while (true) {
+			long result = syscall(__NR_io_uring_enter, fd, submitCount, waitCount, IORING_ENTER_GETEVENTS, nullptr, 0);
+			if (result >= 0) {
+				return static_cast<int>(result);
+			}
+			if (errno != EINTR) {
+				return -1;
+			}
+		}
+	}
+
+	template <typename F>
+	unsigned int reap(F&& onComplete) {
+		unsigned head = *cqHead;
+		unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+		unsigned int count = 0;
+		for (; head != tail; head++, count++) {
+			const io_uring_cqe& cqe = cqes[head & *cqMask];
+			onComplete(cqe.user_data, cqe.res);
+		}
+		__atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+		return count;
+	}
+};
+#else
+struct FileReadQueue::Ring {};
+#endif
+
+FileReadQueue::FileReadQueue() = default;
+
+FileReadQueue::~FileReadQueue() {
+	stop();
+}
+
+void FileReadQueue::start(const VirtualFileSystem& vfs, unsigned int readerCount) {
+	m_Files = &vfs;
+	m_Stopping = false;
+	m_ReaderCount = readerCount;
+
+#ifdef FILE_QUEUE_USE_IO_URING
+	auto ring = std::make_unique<Ring>();
+	if (ring->init()) {
+		m_Ring = std::move(ring);
+		m_UseRing = true;
+		m_RingThread = std::thread(&FileReadQueue::ringLoop, this);
+		std::cout << "File reads: io_uring, " << m_Ring->capacity() << " entries" << std::endl;
+		return;
+	}
+	std::cout << "File reads: io_uring unavailable, using " << readerCount << " reader threads" << std::endl;
+#endif
+	m_Readers.start(readerCount);
+}
+
+void FileReadQueue::stop() {
+	if (m_RingThread.joinable()) {
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Stopping = true;
+		}
+		m_Condition.notify_all();
+		m_RingThread.join();
+	}
+	m_UseRing = false;
+	m_Ring.reset();
+	m_Readers.stop();
+}
+
+void FileReadQueue::submit(std::vector<FileRead> reads) {
+	{
+		// Checked under the lock, the ring thread may be handing over to the readers
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		if (m_UseRing) {
+			for (FileRead& read : reads) {
+				m_Pending.push_back(std::move(read));
+			}
+			lock.unlock();
+			m_Condition.notify_one();
+			return;
+		}
+	}
+
+	for (FileRead& read : reads) {
+		m_Readers.submit([this, read = std::move(read)]() mutable { readBlocking(read); });
+	}
+}
+
+void FileReadQueue::readBlocking(FileRead& read) {
+	std::string contents;
+	FileError error = readVirtualFile(m_Files ? *m_Files : gVFS, read.path, contents);
+	read.done(error, contents);
+}
+
+void FileReadQueue::ringLoop() {
+	PROFILE_THREAD("File ring");
+	std::vector<FileRead> batch;
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_Condition.wait(lock, [this]() { return m_Stopping || !m_Pending.empty(); });
+			if (m_Pending.empty()) {
+				return;
+			}
+			batch.swap(m_Pending);
+		}
+		readBatch(batch);
+		batch.clear();
+		if (!m_Ring) {
+			return;
+		}
+	}
+}
+
+#ifdef FILE_QUEUE_USE_IO_URING
+void FileReadQueue::readBatch(std::vector<FileRead>& reads) {
+	struct Slot {
+		FileLocation location;
+		std::string contents;
+		FileError error = FileError::None;
+		int file = -1;
+		uint64_t done = 0;
+	};
+	std::vector<Slot> slots(reads.size());
+
+	// Resolve and open everything first; reads of one pack share its descriptor,
+	// or the error of opening it
+	struct OpenFile {
+		int file = -1;
+		FileError error = FileError::None;
+	};
+	std::unordered_map<std::string, OpenFile> files;
+	for (size_t i = 0; i < reads.size(); i++) {
+		Slot& slot = slots[i];
+		slot.error = resolveVirtualFile(*m_Files, reads[i].path, slot.location);
+		if (slot.error != FileError::None) {
+			continue;
+		}
+
+		auto [it, inserted] = files.try_emplace(slot.location.diskPath);
+		if (inserted) {
+			it->second.file = open(it->first.c_str(), O_RDONLY | O_CLOEXEC);
+			if (it->second.file < 0) {
+				it->second.error = errno == ENOENT ? FileError::NotFound : FileError::AccessDenied;
+			}
+		}
+		slot.file = it->second.file;
+		if (slot.file < 0) {
+			slot.error = it->second.error;
+			continue;
+		}
+
+		uint64_t size = slot.location.storedSize;
+		if (slot.location.offset == 0 && size == 0) {
+			struct stat info;
+			if (fstat(slot.file, &info) != 0) {
+				slot.error = FileError::ReadFailed;
+				continue;
+			}
+			size = static_cast<uint64_t>(info.st_size);
+		}
+		slot.contents.resize(static_cast<size_t>(size));
+	}
+
+	// Keep the ring full; a short read is queued again for the remainder
+	std::vector<size_t> queue;
+	for (size_t i = 0; i < slots.size(); i++) {
+		if (slots[i].error == FileError::None && !slots[i].contents.empty()) {
+			queue.push_back(i);
+		}
+	}
+
+	size_t next = 0;
+	unsigned int inFlight = 0;
+	// Queued in the submission ring but not yet taken by the kernel
+	unsigned int unsubmitted = 0;
+	while (next < queue.size() || inFlight > 0 || unsubmitted > 0) {
+		unsigned int queued = unsubmitted;
+		while (next < queue.size() && inFlight + queued < m_Ring->capacity()) {
+			Slot& slot = slots[queue[next]];
+			uint64_t remaining = slot.contents.size() - slot.done;
+			unsigned int chunk = static_cast<unsigned int>(std::min<uint64_t>(remaining, 1u << 30));
+			m_Ring->queueRead(slot.file, slot.contents.data() + slot.done, chunk, slot.location.offset + slot.done, queue[next]);
+			queued++;
+			next++;
+		}
+
+		auto onComplete = [&](uint64_t index, int result) {
+			Slot& slot = slots[index];
+			if (result <= 0) {
+				slot.error = FileError::ReadFailed;
+				return;
+			}
+			slot.done += static_cast<uint64_t>(result);
+			if (slot.done < slot.contents.size()) {
+				queue.push_back(static_cast<size_t>(index));
+			}
+		};
+
+		int submitted = m_Ring->enter(queued, 1);
+		if (submitted < 0 || (queued > 0 && submitted == 0)) {
+			// Lost the ring, or it stopped taking work. What is still queued never
+			// reached the kernel and never will, but submitted reads are still
+			// writing into their slots: wait them out before the buffers are read
+			// again or freed.
+			while (inFlight > 0) {
+				inFlight -= m_Ring->reap(onComplete);
+				if (inFlight > 0) {
+					std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				}
+			}
+			abandonRing();
+
+			// Finish the batch with blocking reads
+			for (Slot& slot : slots) {
+				if (slot.error == FileError::None && slot.done < slot.contents.size()) {
+					slot.error = readFile(slot.location.diskPath, slot.contents, slot.location.offset, slot.contents.size());
+					slot.done = slot.contents.size();
+				}
+			}
+			break;
+		}
+		inFlight += static_cast<unsigned int>(submitted);
+		unsubmitted = queued - static_cast<unsigned int>(submitted);
+		inFlight -= m_Ring->reap(onComplete);
+	}
+
+	for (auto& [path, opened] : files) {
+		if (opened.file >= 0) {
+			close(opened.file);
+		}
+	}
+
+	for (size_t i = 0; i < reads.size(); i++) {
+		Slot& slot = slots[i];
+		if (slot.error == FileError::None) {
+			slot.error = decodeStoredFile(slot.location, slot.contents);
+		}
+		if (slot.error != FileError::None) {
+			slot.contents.clear();
+		}
+		reads[i].done(slot.error, slot.contents);
+	}
+}
+
+void FileReadQueue::abandonRing() {
+	std::cout << "File reads: io_uring failed, switching to " << m_ReaderCount << " reader threads" << std::endl;
+	m_Readers.start(m_ReaderCount);
+
+	// Whatever was queued for the ring since this batch started goes to the readers too
+	std::vector<FileRead> pending;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_UseRing = false;
+		pending.swap(m_Pending);
+	}
+	m_Ring.reset();
+	for (FileRead& read : pending) {
+		m_Readers.submit([this, read = std::move(read)]() mutable { readBlocking(read); });
+	}
+}
+#else
+void FileReadQueue::abandonRing() {}
+
+void FileReadQueue::readBatch(std::vector<FileRead>& reads) {
+	for (FileRead& read : reads) {
+		readBlocking(read);
+	}
+}
+#endif
+
+std::vector<FileError> readFilesBlocking(FileReadQueue& queue, const std::vector<std::string>& paths, std::vector<std::string>& contents) {
+	std::vector<FileError> errors(paths.size(), FileError::None);
+	contents.assign(paths.size(), std::string());
+
+	std::mutex mutex;
+	std::condition_variable finished;
+	size_t remaining = paths.size();
+
+	std::vector<FileRead> reads;
+	reads.reserve(paths.size());
+	for (size_t i = 0; i < paths.size(); i++) {
+		reads.push_back({ paths[i], [&, i](FileError error, std::string& data) {
+			errors[i] = error;
+			contents[i] = std::move(data);
+			std::lock_guard<std::mutex> lock(mutex);
+			if (--remaining == 0) {
+				finished.notify_one();
+			}
+		} });
+	}
+	queue.submit(std::move(reads));
+
+	std::unique_lock<std::mutex> lock(mutex);
+	finished.wait(lock, [&]() { return remaining == 0; });
+	return errors;
+}
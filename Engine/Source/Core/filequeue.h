@@ -0,0 +1,77 @@
+#pragma once
+#ifndef FILE_QUEUE_H
+#define FILE_QUEUE_H
+
+#include "file.h"
+#include "threadpool.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct VirtualFileSystem;
+
+// Runs on an I/O thread once the read finished or failed. Keep it short and
+// hand decoding to the worker pool; contents may be moved out.
+using FileReadCallback = std::function<void(FileError error, std::string& contents)>;
+
+struct FileRead {
+	std::string path;
+	FileReadCallback done;
+};
+
+// Batched asynchronous reads through the virtual file system. On Linux the
+// reads of a batch go to the kernel together through io_uring from one I/O
+// thread; elsewhere, or when io_uring is unavailable, a few blocking reader
+// threads take one read each. A ring that fails mid-run is dropped for good
+// and the reader threads take over.
+class FileReadQueue {
+public:
+	FileReadQueue();
+	~FileReadQueue();
+
+	FileReadQueue(const FileReadQueue&) = delete;
+	FileReadQueue& operator=(const FileReadQueue&) = delete;
+
+	void start(const VirtualFileSystem& vfs, unsigned int readerCount = 4);
+	void stop();
+
+	// Before start() the reads run inline on the calling thread
+	void submit(std::vector<FileRead> reads);
+
+	bool usesIoUring() const { return m_UseRing; }
+private:
+	struct Ring;
+
+	const VirtualFileSystem* m_Files = nullptr;
+	ThreadPool m_Readers;
+	unsigned int m_ReaderCount = 4;
+
+	std::unique_ptr<Ring> m_Ring;
+	std::thread m_RingThread;
+	// Written under m_Mutex; submit only queues for the ring while it is set
+	std::atomic<bool> m_UseRing{ false };
+	std::vector<FileRead> m_Pending;
+	std::mutex m_Mutex;
+	std::condition_variable m_Condition;
+	bool m_Stopping = false;
+
+	void readBlocking(FileRead& read);
+	void ringLoop();
+	void readBatch(std::vector<FileRead>& reads);
+	// Ring thread only, once no read is left in flight
+	void abandonRing();
+};
+
+extern FileReadQueue gFileReads;
+
+// Submits every path as one batch and waits for all of them. contents[i] and
+// the returned errors line up with paths[i]. Never call from a read callback.
+std::vector<FileError> readFilesBlocking(FileReadQueue& queue, const std::vector<std::string>& paths, std::vector<std::string>& contents);
+
+#endif
@@ -0,0 +1,210 @@
+#include "framestats.h"
+#include "benchmark.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+namespace {
+	// Sorts scratch in place
+	FrameTimeSummary summarize(std::vector<float>& scratch) {
+		FrameTimeSummary summary;
+		if (scratch.empty()) {
+			return summary;
+		}
+		std::sort(scratch.begin(), scratch.end());
+		double total = 0.0;
+		for (float value : scratch) {
+			total += value;
+		}
+		summary.mean = float(total / scratch.size());
+		summary.p50 = getSortedPercentile(scratch, 50.0f);
+		summary.p95 = getSortedPercentile(scratch, 95.0f);
+		summary.p99 = getSortedPercentile(scratch, 99.0f);
+		summary.max = scratch.back();
+		return summary;
+	}
+
+	template <typename Value>
+	FrameTimeSummary summarizeField(const FrameSample* samples, size_t count, std::vector<float>& scratch, Value value) {
+		scratch.clear();
+		for (size_t i = 0; i < count; i++) {
+			scratch.push_back(value(samples[i]));
+		}
+		return summarize(scratch);
+	}
+
+	void appendSummaryJson(std::string& json, const char* indent, const char* name, const FrameTimeSummary& summary, bool last) {
+		char line[256];
+		std::snprintf(line, sizeof(line), "%s\"%s\": { \"mean\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f }%s\n",
+			indent, name, summary.mean, summary.p50, summary.p95, summary.p99, summary.max, last ? "" : ",");
+		json += line;
+	}
+}
+
+const char* getFramePhaseName(FramePhase phase) {
+	switch (phase) {
+	case FramePhase::Events:
+		return "Events";
+	case FramePhase::Uploads:
+		return "Uploads";
+	case FramePhase::Update:
+		return "Update";
+	case FramePhase::Render:
+		return "Render";
+	case FramePhase::Hud:
+		return "HUD";
+	case FramePhase::Present:
+		return "Present";
+	default:
+		return "Unknown";
+	}
+}
+
+void initFrameStats(FrameStats& stats, size_t windowFrames) {
+	stats = FrameStats{};
+	stats.samples.resize(std::max<size_t>(1, windowFrames));
+	stats.scratch.reserve(stats.samples.size());
+}
+
+void addFrameSample(FrameStats& stats, const FrameSample& sample) {
+	stats.samples[stats.next] = sample;
+	stats.next = (stats.next + 1) % stats.samples.size();
+	stats.count = std::min(stats.count + 1, stats.samples.size());
+	stats.totalFrames++;
+}
+
+const FrameSample& getFrameSample(const FrameStats& stats, size_t index) {
+	size_t oldest = stats.count < stats.samples.size() ? 0 : stats.next;
+	return stats.samples[(oldest + index) % stats.samples.size()];
+}
+
+void updateFrameStatsSummary(FrameStats& stats) {
+	// Order does not matter to a summary, the ring's first count slots are the window
+	summarizeFrameSamples(stats.samples.data(), stats.count, stats.scratch, stats.summary);
+}
+
+void getFrameTimeHistogram(const FrameStats& stats, float bucketMilliseconds, float* counts, size_t bucketCount) {
+	std::fill(counts, counts + bucketCount, 0.0f);
+	if (bucketCount == 0 || bucketMilliseconds <= 0.0f) {
+		return;
+	}
+	for (size_t i = 0; i < stats.count; i++) {
+		size_t bucket = size_t(stats.samples[i].milliseconds / bucketMilliseconds);
+		counts[std::min(bucket, bucketCount - 1)] += 1.0f;
+	}
+}
+
+void summarizeFrameSamples(const FrameSample* samples, size_t count, std::vector<float>& scratch, FrameStatsSummary& summary) {
+	summary = FrameStatsSummary{};
+	summary.frames = count;
+	if (count == 0) {
+		return;
+	}
+
+	summary.frame = summarizeField(samples, count, scratch, [](const FrameSample& sample) { return sample.milliseconds; });
+	for (size_t phase = 0; phase < kFramePhaseCount; phase++) {
+		summary.phases[phase] = summarizeField(samples, count, scratch, [phase](const FrameSample& sample) { return sample.phaseMilliseconds[phase]; });
+	}
+	summary.gpu = summarizeField(samples, count, scratch, [](const FrameSample& sample) { return sample.gpuMilliseconds; });
+
+	double drawCalls = 0.0;
+	double triangles = 0.0;
+	for (size_t i = 0; i < count; i++) {
+		drawCalls += samples[i].drawCalls;
+		triangles += double(samples[i].triangles);
+		summary.drawCallsMax = std::max(summary.drawCallsMax, samples[i].drawCalls);
+		summary.trianglesMax = std::max(summary.trianglesMax, samples[i].triangles);
+	}
+	summary.drawCallsMean = float(drawCalls / count);
+	summary.trianglesMean = float(triangles / count);
+}
+
+std::string getFrameStatsJson(const std::vector<FrameSample>& samples) {
+	std::vector<float> scratch;
+	FrameStatsSummary summary;
+	summarizeFrameSamples(samples.data(), samples.size(), scratch, summary);
+
+	char line[512];
+	std::string json = "{\n";
+	std::snprintf(line, sizeof(line), "  \"frames\": %zu,\n", summary.frames);
+	json += line;
+	appendSummaryJson(json, "  ", "frameMs", summary.frame, false);
+	appendSummaryJson(json, "  ", "gpuMs", summary.gpu, false);
+	json += "  \"phasesMs\": {\n";
+	for (size_t phase = 0; phase < kFramePhaseCount; phase++) {
+		appendSummaryJson(json, "    ", getFramePhaseName(FramePhase(phase)), summary.phases[phase], phase + 1 == kFramePhaseCount);
+	}
+	json += "  },\n";
+	std::snprintf(line, sizeof(line), "  \"drawCalls\": { \"mean\": %.2f, \"max\": %u },\n  \"triangles\": { \"mean\": %.1f, \"max\": %llu },\n",
+		summary.drawCallsMean, summary.drawCallsMax, summary.trianglesMean, (unsigned long long)summary.trianglesMax);
+	json += line;
+
+	// Columns rather than one object per frame, a long run stays readable
+	json += "  \"samples\": {\n    \"frameMs\": [";
+	for (size_t i = 0; i < samples.size(); i++) {
+		std::snprintf(line, sizeof(line), "%s%.4f", i > 0 ? ", " : "", samples[i].milliseconds);
+		json += line;
+	}
+	json += "],\n";
+	for (size_t phase = 0; phase < kFramePhaseCount; phase++) {
+		std::snprintf(line, sizeof(line), "    \"%sMs\": [", getFramePhaseName(FramePhase(phase)));
+		json += line;
+		for (size_t i = 0; i < samples.size(); i++) {
+			std::snprintf(line, sizeof(line), "%s%.4f", i > 0 ? ", " : "", samples[i].phaseMilliseconds[phase]);
+			json += line;
+		}
+		json += "],\n";
+	}
+	json += "    \"gpuMs\": [";
+	for (size_t i = 0; i < samples.size(); i++) {
+		std::snprintf(line, sizeof(line), "%s%.4f", i > 0 ? ", " : "", samples[i].gpuMilliseconds);
+		json += line;
+	}
+	json += "],\n    \"drawCalls\": [";
+	for (size_t i = 0; i < samples.size(); i++) {
+		std::snprintf(line, sizeof(line), "%s%u", i > 0 ? ", " : "", samples[i].drawCalls);
+		json += line;
+	}
+	json += "],\n    \"triangles\": [";
+	for (size_t i = 0; i < samples.size(); i++) {
+		std::snprintf(line, sizeof(line), "%s%llu", i > 0 ? ", " : "", (unsigned long long)samples[i].triangles);
+		json += line;
+	}
+	json += "]\n  }\n}\n";
+	return json;
+}
+
+std::string getFrameStatsCsv(const std::vector<FrameSample>& samples) {
+	std::string csv = "frame,frameMs";
+	for (size_t phase = 0; phase < kFramePhaseCount; phase++) {
+		csv += ",";
+		csv += getFramePhaseName(FramePhase(phase));
+		csv += "Ms";
+	}
+	csv += ",gpuMs,drawCalls,triangles\n";
+
+	char line[64];
+	for (size_t i = 0; i < samples.size(); i++) {
+		const FrameSample& sample = samples[i];
+		std::snprintf(line, sizeof(line), "%zu,%.4f", i + 1, sample.milliseconds);
+		csv += line;
+		for (size_t phase = 0; phase < kFramePhaseCount; phase++) {
+			std::snprintf(line, sizeof(line), ",%.4f", sample.phaseMilliseconds[phase]);
+			csv += line;
+		}
+		std::snprintf(line, sizeof(line), ",%.4f,%u,%llu\n", sample.gpuMilliseconds, sample.drawCalls, (unsigned long long)sample.triangles);
+		csv += line;
+	}
+	return csv;
+}
+
+bool writeFrameStats(const std::string& path, const std::vector<FrameSample>& samples) {
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file) {
+		return false;
+	}
+	bool csv = path.size() >= 4 && path.compare(path.size() - 4, 4, ".csv") == 0;
+	file << (csv ? getFrameStatsCsv(samples) : getFrameStatsJson(samples));
+	return bool(file);
+}
@@ -0,0 +1,86 @@
+#pragma once
+#ifndef FRAME_STATS_H
+#define FRAME_STATS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Per-frame timings kept over a rolling window, summarised as percentiles:
+// a mean hides the one frame in a hundred that hitches.
+
+// Where the main loop's time goes, in loop order
+enum class FramePhase : uint8_t {
+	Events,
+	Uploads,
+	Update,
+	Render,
+	Hud,
+	Present,
+	Count
+};
+
+constexpr size_t kFramePhaseCount = static_cast<size_t>(FramePhase::Count);
+
+const char* getFramePhaseName(FramePhase phase);
+
+struct FrameSample {
+	// Top of the loop to the end of present
+	float milliseconds = 0.0f;
+	float phaseMilliseconds[kFramePhaseCount] = {};
+	// Newest frame the GPU timers have resolved, a few frames behind this one
+	float gpuMilliseconds = 0.0f;
+	uint32_t drawCalls = 0;
+	uint64_t triangles = 0;
+};
+
+struct FrameTimeSummary {
+	float mean = 0.0f;
+	float p50 = 0.0f;
+	float p95 = 0.0f;
+	float p99 = 0.0f;
+	float max = 0.0f;
+};
+
+struct FrameStatsSummary {
+	size_t frames = 0;
+	FrameTimeSummary frame;
+	FrameTimeSummary phases[kFramePhaseCount];
+	FrameTimeSummary gpu;
+	float drawCallsMean = 0.0f;
+	uint32_t drawCallsMax = 0;
+	float trianglesMean = 0.0f;
+	uint64_t trianglesMax = 0;
+};
+
+// The last windowFrames samples. Nothing allocates after initFrameStats.
+struct FrameStats {
+	std::vector<FrameSample> samples; // ring, oldest at next once full
+	size_t next = 0;
+	size_t count = 0;
+	uint64_t totalFrames = 0;
+	FrameStatsSummary summary;
+	std::vector<float> scratch;
+};
+
+void initFrameStats(FrameStats& stats, size_t windowFrames);
+void addFrameSample(FrameStats& stats, const FrameSample& sample);
+// index 0 is the oldest sample in the window
+const FrameSample& getFrameSample(const FrameStats& stats, size_t index);
+// Recomputes stats.summary over the window. Sorts, so callers refresh it a few
+// times a second rather than every frame.
+void updateFrameStatsSummary(FrameStats& stats);
+// Frames per bucketMilliseconds wide bucket over the window, the last bucket
+// takes everything slower
+void getFrameTimeHistogram(const FrameStats& stats, float bucketMilliseconds, float* counts, size_t bucketCount);
+
+void summarizeFrameSamples(const FrameSample* samples, size_t count, std::vector<float>& scratch, FrameStatsSummary& summary);
+
+// Every sample of a run plus the summary, for automated runs. The format
+// follows the extension: .csv writes one row per frame, anything else JSON.
+std::string getFrameStatsJson(const std::vector<FrameSample>& samples);
+std::string getFrameStatsCsv(const std::vector<FrameSample>& samples);
+bool writeFrameStats(const std::string& path, const std::vector<FrameSample>& samples);
+
+#endif
@@ -0,0 +1,22 @@
+#pragma once
+#ifndef HASH_H
+#define HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// XXH64. The value only depends on the input bytes and seed, never on the
+// platform or standard library, so it is safe to persist in cooked files.
+uint64_t hash64(const void* data, size_t size, uint64_t seed = 0);
+
+inline uint64_t hash64(std::string_view text, uint64_t seed = 0) {
+	return hash64(text.data(), text.size(), seed);
+}
+
+// Order dependent combination of two hashes
+inline uint64_t hashCombine(uint64_t first, uint64_t second) {
+	return hash64(&second, sizeof(second), first);
+}
+
+#endif
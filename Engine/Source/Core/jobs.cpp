@@ -0,0 +1,303 @@
+#include "jobs.h"
+#include "profiler.h"
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+JobSystem gJobs;
+
+namespace {
+	// Which queue the current thread owns, so nested run() calls stay local
+	thread_local const JobSystem* tOwner = nullptr;
+	thread_local size_t tQueueIndex = 0;
+}
+
+void JobSystem::Queue::pushBack(Entry&& entry) {
+	if (count == slots.size()) {
+		std::vector<Entry> grown(std::max<size_t>(64, slots.size() * 2));
+		for (size_t i = 0; i < count; i++) {
+			grown[i] = std::move(slots[(head + i) % slots.size()]);
+		}
+		slots.swap(grown);
+		head = 0;
+	}
+	slots[(head + count) % slots.size()] = std::move(entry);
+	count++;
+}
+
+JobSystem::Entry JobSystem::Queue::popBack() {
+	count--;
+	return std::move(slots[(head + count) % slots.size()]);
+}
+
+JobSystem::Entry JobSystem::Queue::popFront() {
+	Entry entry = std::move(slots[head]);
+	head = (head + 1) % slots.size();
+	count--;
+	return entry;
+}
+
+JobSystem::~JobSystem() {
+	stop();
+}
+
+void JobSystem::start(unsigned int threadCount) {
+	if (!m_Workers.empty()) {
+		return;
+	}
+
+	if (threadCount == 0) {
+		unsigned int cores = std::thread::hardware_concurrency();
+		threadCount = std::max(1u, cores > 1 ? cores - 1 : 1u);
+	}
+
+	m_Stopping = false;
+	m_Queues.clear();
+	for (unsigned int i = 0; i <= threadCount; i++) {
+		m_Queues.push_back(std::make_unique<Queue>());
+	}
+	for (unsigned int i = 0; i < threadCount; i++) {
+		m_Workers.emplace_back(&JobSystem::workerLoop, this, size_t(i) + 1);
+	}
+}
+
+void JobSystem::stop() {
+	if (m_Workers.empty()) {
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_SleepMutex);
+		m_Stopping = true;
+	}
+	m_Wake.notify_all();
+
+	for (std::thread& worker : m_Workers) {
+		worker.join();
+	}
+	m_Workers.clear();
+	m_Queues.clear();
+}
+
+size_t JobSystem::getQueueIndex() const {
+	return tOwner == this ? tQueueIndex : 0;
+}
+
+void JobSystem::run(std::function<void()> job, JobCounter* counter) {
+	if (counter) {
+		counter->value.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	if (m_Workers.empty()) {
+		job();
+		if (counter) {
+			counter->value.fetch_sub(1, std::memory_order_release);
+		}
+		return;
+	}
+
+	Entry entry;
+	entry.job = std::move(job);
+	entry.counter = counter;
+	push(std::move(entry));
+}
+
+void JobSystem::runRange(RangeFunction function, void* context, size_t begin, size_t end, JobCounter* counter) {
+	if (counter) {
+		counter->value.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	if (m_Workers.empty()) {
+		function(context, begin, end);
+		if (counter) {
+			counter->value.fetch_sub(1, std::memory_order_release);
+		}
+		return;
+	}
+
+	Entry entry;
+	entry.range = function;
+	entry.context = context;
+	entry.begin = begin;
+	entry.end = end;
+	entry.counter = counter;
+	push(std::move(entry));
+}
+
+void JobSystem::push(Entry&& entry) {
+	Queue& queue = *m_Queues[getQueueIndex()];
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.pushBack(std::move(entry));
+	}
+
+	// Pairs with the sleeping check in workerLoop: either the worker sees the
+	// job, or this sees the worker asleep and wakes it
+	m_Queued.fetch_add(1);
+	if (m_Sleeping.load() > 0) {
+		{
+			std::lock_guard<std::mutex> lock(m_SleepMutex);
+		}
+		m_Wake.notify_one();
+	}
+}
+
+bool JobSystem::tryRunJob(size_t self) {
+	if (m_Queued.load(std::memory_order_relaxed) <= 0) {
+		return false;
+	}
+
+	Entry entry;
+	bool found = false;
+
+	// Own work newest first, it is the most likely to be in cache
+	if (self > 0) {
+		Queue& own = *m_Queues[self];
+		std::lock_guard<std::mutex> lock(own.mutex);
+		if (own.count > 0) {
+			entry = own.popBack();
+			found = true;
+		}
+	}
+
+	// Then the shared queue and everyone else's, oldest first
+	for (size_t i = 0; !found && i < m_Queues.size(); i++) {
+		size_t victim = (self + i) % m_Queues.size();
+		if (victim == self && self > 0) {
+			continue;
+		}
+		Queue& queue = *m_Queues[victim];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (queue.count > 0) {
+			entry = queue.popFront();
+			found = true;
+		}
+	}
+
+	if (!found) {
+		return false;
+	}
+
+	m_Queued.fetch_sub(1, std::memory_order_relaxed);
+	{
+		PROFILE_ZONE("Job");
+		if (entry.range) {
+			entry.range(entry.context, entry.begin, entry.end);
+		}
+		else {
+			entry.job();
+		}
+	}
+	if (entry.counter) {
+		entry.counter->value.fetch_sub(1, std::memory_order_release);
+	}
+	return true;
+}
+
+void JobSystem::wait(JobCounter& counter) {
+	size_t self = getQueueIndex();
+	while (!counter.isDone()) {
+		if (!tryRunJob(self)) {
+			std::this_thread::yield();
+		}
+	}
+}
+
+void JobSystem::workerLoop(size_t self) {
+	tOwner = this;
+	tQueueIndex = self;
+	PROFILE_THREAD(("Job worker " + std::to_string(self)).c_str());
+
+	for (;;) {
+		if (tryRunJob(self)) {
+			continue;
+		}
+
+		// Jobs come in bursts, spin briefly before paying for a sleep
+		bool ran = false;
+		for (int spin = 0; spin < 64 && !ran; spin++) {
+			std::this_thread::yield();
+			ran = tryRunJob(self);
+		}
+		if (ran) {
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_SleepMutex);
+		m_Sleeping.fetch_add(1);
+		m_Wake.wait(lock, [this] { return m_Stopping || m_Queued.load() > 0; });
+		m_Sleeping.fetch_sub(1);
+		// Drain remaining work before exiting so nothing that was submitted is lost
+		if (m_Stopping && m_Queued.load() <= 0) {
+			return;
+		}
+	}
+}
+
+bool benchmarkJobSystem(JobSystem& jobs) {
+	using Clock = std::chrono::steady_clock;
+	auto elapsedMilliseconds = [](Clock::time_point from) {
+		return std::chrono::duration<float, std::milli>(Clock::now() - from).count();
+	};
+	bool success = true;
+
+	// Data parallel math, the shape of animation and culling work
+	const size_t count = size_t(1) << 23;
+	std::vector<float> serial(count);
+	std::vector<float> parallel(count);
+	auto kernel = [](size_t i) {
+		float x = float(i) * 0.001f;
+		return std::sqrt(x) * std::sin(x) + std::cos(x * 0.5f);
+	};
+
+	Clock::time_point start = Clock::now();
+	for (size_t i = 0; i < count; i++) {
+		serial[i] = kernel(i);
+	}
+	float serialMilliseconds = elapsedMilliseconds(start);
+
+	start = Clock::now();
+	parallelFor(jobs, count, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			parallel[i] = kernel(i);
+		}
+	}, 4096);
+	float parallelMilliseconds = elapsedMilliseconds(start);
+
+	bool same = serial == parallel;
+	success &= same;
+	std::cout << "parallelFor over " << count << " elements: serial " << serialMilliseconds << " ms, "
+		<< jobs.getWorkerCount() + 1 << " threads " << parallelMilliseconds << " ms, "
+		<< serialMilliseconds / std::max(parallelMilliseconds, 0.001f) << "x" << (same ? "" : ", RESULTS DIFFER") << std::endl;
+
+	// Scheduling overhead with empty jobs
+	const int jobCount = 100000;
+	std::atomic<int> ran{ 0 };
+	JobCounter counter;
+	start = Clock::now();
+	for (int i = 0; i < jobCount; i++) {
+		jobs.run([&ran]() { ran.fetch_add(1, std::memory_order_relaxed); }, &counter);
+	}
+	jobs.wait(counter);
+	float emptyMilliseconds = elapsedMilliseconds(start);
+	success &= ran.load() == jobCount;
+	std::cout << jobCount << " empty jobs: " << emptyMilliseconds << " ms, "
+		<< emptyMilliseconds * 1000000.0f / jobCount << " ns per job" << (ran.load() == jobCount ? "" : ", JOBS LOST") << std::endl;
+
+	// Jobs that spawn and wait on their own children must not deadlock
+	std::atomic<int> leaves{ 0 };
+	start = Clock::now();
+	parallelFor(jobs, 64, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			parallelFor(jobs, 256, [&](size_t childBegin, size_t childEnd) {
+				leaves.fetch_add(int(childEnd - childBegin), std::memory_order_relaxed);
+			});
+		}
+	});
+	success &= leaves.load() == 64 * 256;
+	std::cout << "Nested parallelFor: " << leaves.load() << " of " << 64 * 256 << " leaves in "
+		<< elapsedMilliseconds(start) << " ms" << std::endl;
+
+	return success;
+}
@@ -0,0 +1,124 @@
+#pragma once
+#ifndef JOBS_H
+#define JOBS_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Jobs still outstanding. Running a job with a counter bumps it, finishing the
+// job drops it again; JobSystem::wait runs other jobs until it reaches zero.
+struct JobCounter {
+	std::atomic<int> value{ 0 };
+
+	bool isDone() const { return value.load(std::memory_order_acquire) == 0; }
+};
+
+// Work-stealing scheduler for short CPU work. Each worker pushes and pops the
+// back of its own queue and steals from the front of the others; threads that
+// are not workers, like the main thread, submit to a shared queue. Jobs must
+// not block on I/O, that stays on ThreadPool and FileReadQueue.
+class JobSystem {
+public:
+	JobSystem() = default;
+	~JobSystem();
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	// threadCount of 0 uses one worker per core, leaving one for the main thread
+	void start(unsigned int threadCount = 0);
+	void stop();
+
+	// Without workers the job runs inline, which keeps callers correct before start()
+	void run(std::function<void()> job, JobCounter* counter = nullptr);
+	// Same as run, for function(context, begin, end). Nothing is wrapped in a
+	// std::function, so once the queues have grown submitting never allocates.
+	using RangeFunction = void (*)(void* context, size_t begin, size_t end);
+	void runRange(RangeFunction function, void* context, size_t begin, size_t end, JobCounter* counter = nullptr);
+	// Runs queued jobs on the calling thread until counter reaches zero, so
+	// waiting inside a job cannot starve the pool
+	void wait(JobCounter& counter);
+
+	unsigned int getWorkerCount() const { return (unsigned int)m_Workers.size(); }
+private:
+	struct Entry {
+		std::function<void()> job;
+		RangeFunction range = nullptr;
+		void* context = nullptr;
+		size_t begin = 0;
+		size_t end = 0;
+		JobCounter* counter = nullptr;
+	};
+
+	// Ring buffer that only ever grows, so a steady frame reuses its slots
+	struct Queue {
+		std::mutex mutex;
+		std::vector<Entry> slots;
+		size_t head = 0;
+		size_t count = 0;
+
+		void pushBack(Entry&& entry);
+		Entry popBack();
+		Entry popFront();
+	};
+
+	std::vector<std::thread> m_Workers;
+	std::vector<std::unique_ptr<Queue>> m_Queues; // [0] is shared, [i + 1] belongs to worker i
+	std::atomic<int> m_Queued{ 0 };
+	std::atomic<int> m_Sleeping{ 0 };
+	std::atomic<bool> m_Stopping{ false };
+	std::mutex m_SleepMutex;
+	std::condition_variable m_Wake;
+
+	size_t getQueueIndex() const;
+	void push(Entry&& entry);
+	bool tryRunJob(size_t self);
+	void workerLoop(size_t self);
+};
+
+extern JobSystem gJobs;
+
+// Calls body(begin, end) over chunks of [0, count) on every worker and the
+// calling thread, and returns once all chunks are done. A few chunks per
+// thread let stealing even out uneven work; minChunk keeps tiny bodies from
+// drowning in scheduling.
+template <typename F>
+void parallelFor(JobSystem& jobs, size_t count, F&& body, size_t minChunk = 1) {
+	if (count == 0) {
+		return;
+	}
+
+	size_t threads = size_t(jobs.getWorkerCount()) + 1;
+	size_t chunk = std::max(minChunk, (count + threads * 4 - 1) / (threads * 4));
+	if (threads == 1 || chunk >= count) {
+		body(size_t(0), count);
+		return;
+	}
+
+	using Body = std::remove_reference_t<F>;
+	JobSystem::RangeFunction function = [](void* context, size_t begin, size_t end) {
+		(*static_cast<Body*>(context))(begin, end);
+	};
+
+	JobCounter counter;
+	for (size_t begin = chunk; begin < count; begin += chunk) {
+		size_t end = std::min(begin + chunk, count);
+		jobs.runRange(function, (void*)std::addressof(body), begin, end, &counter);
+	}
+	body(size_t(0), chunk);
+	jobs.wait(counter);
+}
+
+// Times serial against parallel runs of a few workloads and checks they agree,
+// run with --benchmark-jobs
+bool benchmarkJobSystem(JobSystem& jobs);
+
+#endif
@@ -0,0 +1,42 @@
+#include "json.h"
+
+#include <cstdio>
+
+void appendJsonString(std::string& json, const char* text) {
+	json += '"';
+	for (; *text; text++) {
+		unsigned char c = static_cast<unsigned char>(*text);
+		switch (c) {
+		case '"':
+			json += "\\\"";
+			break;
+		case '\\':
+			json += "\\\\";
+			break;
+		case '\n':
+			json += "\\n";
+			break;
+		case '\r':
+			json += "\\r";
+			break;
+		case '\t':
+			json += "\\t";
+			break;
+		default:
+			if (c < 0x20) {
+				char escaped[8];
+				std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+				json += escaped;
+			}
+			else {
+				json += *text;
+			}
+			break;
+		}
+	}
+	json += '"';
+}
+
+void appendJsonString(std::string& json, const std::string& text) {
+	appendJsonString(json, text.c_str());
+}
@@ -0,0 +1,15 @@
+#pragma once
+#ifndef JSON_H
+#define JSON_H
+
+#include <string>
+
+// The reports and traces build their JSON by hand; names in them come from
+// anywhere (thread names, GL entry points, paths), so they go through here.
+
+// Appends text as a quoted JSON string, escaping quotes, backslashes and
+// control characters
+void appendJsonString(std::string& json, const char* text);
+void appendJsonString(std::string& json, const std::string& text);
+
+#endif
@@ -0,0 +1,188 @@
+#include "lz4.h"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace {
+	constexpr size_t kMinMatch = 4;
+	// The format requires the last 5 bytes to be literals and the last match
+	// to start at least 12 bytes before the end
+	constexpr size_t kLastLiterals = 5;
+	constexpr size_t kMatchSafeDistance = 12;
+	constexpr size_t kMaxOffset = 65535;
+	constexpr int kHashBits = 16;
+
+	uint32_t read32(const unsigned char* p) {
+		uint32_t value;
+		std::memcpy(&value, p, sizeof(value));
+		return value;
+	}
+
+	uint32_t hashSequence(uint32_t sequence) {
+		return (sequence * 2654435761u) >> (32 - kHashBits);
+	}
+
+	// Writes the 15+ length continuation bytes
+	unsigned char* writeLength(unsigned char* out, size_t length) {
+		while (length >= 255) {
+			*out++ = 255;
+			length -= 255;
+		}
+		*out++ = static_cast<unsigned char>(length);
+		return out;
+	}
+
+	bool readLength(const unsigned char*& in, const unsigned char* end, size_t& length) {
+		unsigned char byte;
+		do {
+			if (in >= end) {
+				return false;
+			}
+			byte = *in++;
+			length += byte;
+		} while (byte == 255);
+		return true;
+	}
+}
+
+size_t getLz4MaxCompressedSize(size_t size) {
+	return size + size / 255 + 16;
+}
+
+size_t compressLz4(const void* src, size_t srcSize, void* dst, size_t dstCapacity) {
+	const unsigned char* input = static_cast<const unsigned char*>(src);
+	unsigned char* output = static_cast<unsigned char*>(dst);
+	unsigned char* outputEnd = output + dstCapacity;
+	unsigned char* out = output;
+
+	const unsigned char* anchor = input;
+	const unsigned char* inputEnd = input + srcSize;
+	const unsigned char* matchLimit = srcSize > kMatchSafeDistance ? inputEnd - kMatchSafeDistance : input;
+
+	// Positions are stored +1 so zero means empty
+	std::vector<uint32_t> table(size_t(1) << kHashBits, 0);
+
+	const unsigned char* ip = input;
+	while (ip < matchLimit) {
+		uint32_t sequence = read32(ip);
+		uint32_t& slot = table[hashSequence(sequence)];
+		const unsigned char* candidate = slot ? input + (slot - 1) : nullptr;
+		slot = static_cast<uint32_t>(ip - input) + 1;
+
+		if (!candidate || size_t(ip - candidate) > kMaxOffset || read32(candidate) != sequence) {
+			ip++;
+			continue;
+		}
+
+		// Extend the match, stopping where the trailing literals start
+		const unsigned char* matchEnd = ip + kMinMatch;
+		const unsigned char* ref = candidate + kMinMatch;
+		const unsigned char* extendLimit = inputEnd - kLastLiterals;
+		while (matchEnd < extendLimit && *matchEnd == *ref) {
+			matchEnd++;
+			ref++;
+		}
+
+		size_t literals = size_t(ip - anchor);
+		size_t matchLength = size_t(matchEnd - ip) - kMinMatch;
+		if (size_t(outputEnd - out) < 1 + literals + literals / 255 + 2 + matchLength / 255 + 2) {
+			return 0;
+		}
+
+		unsigned char* token = out++;
+		*token = static_cast<unsigned char>((literals >= 15 ? 15 : literals) << 4);
+		if (literals >= 15) {
+			out = writeLength(out, literals - 15);
+		}
+		std::memcpy(out, anchor, literals);
+		out += literals;
+
+		uint16_t offset = static_cast<uint16_t>(ip - candidate);
+		*out++ = static_cast<unsigned char>(offset & 0xFF);
+		*out++ = static_cast<unsigned char>(offset >> 8);
+
+		*token |= static_cast<unsigned char>(matchLength >= 15 ? 15 : matchLength);
+		if (matchLength >= 15) {
+			out = writeLength(out, matchLength - 15);
+		}
+
+		ip = matchEnd;
+		anchor = ip;
+	}
+
+	// Everything after the last match is one literal run
+	size_t literals = size_t(inputEnd - anchor);
+	if (size_t(outputEnd - out) < 1 + literals + literals / 255 + 1) {
+		return 0;
+	}
+	unsigned char* token = out++;
+	*token = static_cast<unsigned char>((literals >= 15 ? 15 : literals) << 4);
+	if (literals >= 15) {
+		out = writeLength(out, literals - 15);
+	}
+	std::memcpy(out, anchor, literals);
+	out += literals;
+
+	return size_t(out - output);
+}
+
+bool decompressLz4(const void* src, size_t srcSize, void* dst, size_t dstSize) {
+	const unsigned char* in = static_cast<const unsigned char*>(src);
+	const unsigned char* inEnd = in + srcSize;
+	unsigned char* output = static_cast<unsigned char*>(dst);
+	unsigned char* out = output;
+	unsigned char* outEnd = output + dstSize;
+
+	while (in < inEnd) {
+		unsigned char token = *in++;
+
+		size_t literals = token >> 4;
+		if (literals == 15 && !readLength(in, inEnd, literals)) {
+			return false;
+		}
+		if (literals > size_t(inEnd - in) || literals > size_t(outEnd - out)) {
+			return false;
+		}
+		std::memcpy(out, in, literals);
+		in += literals;
+		out += literals;
+
+		// The last sequence has no match
+		if (in == inEnd) {
+			break;
+		}
+
+		if (inEnd - in < 2) {
+			return false;
+		}
+		size_t offset = size_t(in[0]) | (size_t(in[1]) << 8);
+		in += 2;
+		if (offset == 0 || offset > size_t(out - output)) {
+			return false;
+		}
+
+		size_t matchLength = token & 15;
+		if (matchLength == 15 && !readLength(in, inEnd, matchLength)) {
+			return false;
+		}
+		matchLength += kMinMatch;
+		if (matchLength > size_t(outEnd - out)) {
+			return false;
+		}
+
+		// Matches may overlap their own output, so copy forward byte by byte
+		const unsigned char* match = out - offset;
+		if (offset >= matchLength) {
+			std::memcpy(out, match, matchLength);
+			out += matchLength;
+		}
+		else {
+			for (size_t i = 0; i < matchLength; i++) {
+				*out++ = *match++;
+			}
+		}
+	}
+
+	return out == outEnd;
+}
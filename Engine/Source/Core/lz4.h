@@ -0,0 +1,20 @@
+#pragma once
+#ifndef LZ4_H
+#define LZ4_H
+
+#include <cstddef>
+
+// LZ4 block format, the same bytes LZ4_compress_default writes and
+// LZ4_decompress_safe reads. No frame header or checksum; the caller stores
+// both sizes. The compressor is a simple greedy single-probe matcher, fast
+// enough for pack building and decoding at full LZ4 speed.
+
+size_t getLz4MaxCompressedSize(size_t size);
+
+// Returns the compressed size, or 0 when dst is too small
+size_t compressLz4(const void* src, size_t srcSize, void* dst, size_t dstCapacity);
+
+// Fails on malformed input or when the output is not exactly dstSize bytes
+bool decompressLz4(const void* src, size_t srcSize, void* dst, size_t dstSize);
+
+#endif
@@ -0,0 +1,244 @@
+#include "memorytags.h"
+
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+namespace {
+	constexpr size_t kTagCount = static_cast<size_t>(MemoryTag::Count);
+
+	const char* kTagNames[kTagCount] = {
+		"Untagged",
+		"Assets/Mesh",
+		"Assets/Texture",
+		"Animation",
+		"Scene",
+		"Render",
+		"Frame",
+		"Profiler",
+	};
+
+	// Constant initialized, so allocations made before main are already counted
+	struct TagCounters {
+		std::atomic<int64_t> heapBytes{ 0 };
+		std::atomic<int64_t> heapPeakBytes{ 0 };
+		std::atomic<uint64_t> heapAllocations{ 0 };
+		std::atomic<int64_t> heapLive{ 0 };
+
+		std::atomic<size_t> estimatedCpuBytes{ 0 };
+		std::atomic<size_t> estimatedCpuPeakBytes{ 0 };
+		std::atomic<size_t> estimatedGpuBytes{ 0 };
+		std::atomic<size_t> estimatedGpuPeakBytes{ 0 };
+	};
+
+	TagCounters gTagCounters[kTagCount];
+	std::atomic<uint64_t> gHeapAllocations{ 0 };
+	std::atomic<bool> gReportRequested{ false };
+
+	thread_local MemoryTag tCurrentTag = MemoryTag::Untagged;
+
+	template <typename T>
+	void raisePeak(std::atomic<T>& peak, T value) {
+		T previous = peak.load(std::memory_order_relaxed);
+		while (value > previous && !peak.compare_exchange_weak(previous, value, std::memory_order_relaxed)) {
+		}
+	}
+
+	void onSignal(int) {
+		gReportRequested.store(true);
+	}
+}
+
+const char* getMemoryTagName(MemoryTag tag) {
+	size_t index = static_cast<size_t>(tag);
+	return index < kTagCount ? kTagNames[index] : "Unknown";
+}
+
+MemoryTagScope::MemoryTagScope(MemoryTag tag) : m_Previous(tCurrentTag) {
+	tCurrentTag = tag;
+}
+
+MemoryTagScope::~MemoryTagScope() {
+	tCurrentTag = m_Previous;
+}
+
+MemoryTag getCurrentMemoryTag() {
+	return tCurrentTag;
+}
+
+#if ENGINE_TRACK_ALLOCATIONS
+namespace {
+	// Sits right in front of every tracked block, so a free knows its size and
+	// tag without a lookup. 16 bytes keeps the default new alignment.
+	struct AllocationHeader {
+		uint64_t size;
+		uint32_t offset; // from the start of the underlying block to the user pointer
+		uint8_t tag;
+		uint8_t padding[3];
+	};
+	static_assert(sizeof(AllocationHeader) == 16, "header must preserve 16 byte alignment");
+
+	void* allocateAligned(size_t size, size_t alignment) {
+#ifdef _WIN32
+		return _aligned_malloc(size ? size : 1, alignment);
+#else
+		void* memory = nullptr;
+		return posix_memalign(&memory, alignment, size ? size : 1) == 0 ? memory : nullptr;
+#endif
+	}
+
+	void freeAligned(void* memory) {
+#ifdef _WIN32
+		_aligned_free(memory);
+#else
+		std::free(memory);
+#endif
+	}
+
+	void* track(void* block, size_t offset, size_t size) {
+		unsigned char* memory = static_cast<unsigned char*>(block) + offset;
+		AllocationHeader* header = reinterpret_cast<AllocationHeader*>(memory) - 1;
+		header->size = size;
+		header->offset = (uint32_t)offset;
+		header->tag = static_cast<uint8_t>(tCurrentTag);
+
+		TagCounters& counters = gTagCounters[header->tag];
+		int64_t bytes = counters.heapBytes.fetch_add((int64_t)size, std::memory_order_relaxed) + (int64_t)size;
+		raisePeak(counters.heapPeakBytes, bytes);
+		counters.heapAllocations.fetch_add(1, std::memory_order_relaxed);
+		counters.heapLive.fetch_add(1, std::memory_order_relaxed);
+		gHeapAllocations.fetch_add(1, std::memory_order_relaxed);
+		return memory;
+	}
+
+	// Returns the start of the underlying block
+	void* untrack(void* memory) {
+		AllocationHeader* header = static_cast<AllocationHeader*>(memory) - 1;
+		TagCounters& counters = gTagCounters[header->tag];
+		counters.heapBytes.fetch_sub((int64_t)header->size, std::memory_order_relaxed);
+		counters.heapLive.fetch_sub(1, std::memory_order_relaxed);
+		return static_cast<unsigned char*>(memory) - header->offset;
+	}
+}
+
+// The array and nothrow forms forward to these by default
+void* operator new(size_t size) {
+	if (void* block = std::malloc(size + sizeof(AllocationHeader))) {
+		return track(block, sizeof(AllocationHeader), size);
+	}
+	throw std::bad_alloc();
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+	// A whole alignment unit in front keeps the user pointer aligned and leaves room for the header
+	size_t offset = static_cast<size_t>(alignment) < sizeof(AllocationHeader) ? sizeof(AllocationHeader) : static_cast<size_t>(alignment);
+	if (void* block = allocateAligned(size + offset, offset)) {
+		return track(block, offset, size);
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+	if (memory) {
+		std::free(untrack(memory));
+	}
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept {
+	if (memory) {
+		freeAligned(untrack(memory));
+	}
+}
+
+void operator delete(void* memory, size_t) noexcept {
+	operator delete(memory);
+}
+
+void operator delete(void* memory, size_t, std::align_val_t alignment) noexcept {
+	operator delete(memory, alignment);
+}
+
+uint64_t getHeapAllocationCount() {
+	return gHeapAllocations.load(std::memory_order_relaxed);
+}
+#else
+uint64_t getHeapAllocationCount() {
+	return 0;
+}
+#endif
+
+void setMemoryEstimate(MemoryTag tag, size_t cpuBytes, size_t gpuBytes) {
+	TagCounters& counters = gTagCounters[static_cast<size_t>(tag)];
+	counters.estimatedCpuBytes.store(cpuBytes, std::memory_order_relaxed);
+	counters.estimatedGpuBytes.store(gpuBytes, std::memory_order_relaxed);
+	raisePeak(counters.estimatedCpuPeakBytes, cpuBytes);
+	raisePeak(counters.estimatedGpuPeakBytes, gpuBytes);
+}
+
+MemoryTagStats getMemoryTagStats(MemoryTag tag) {
+	const TagCounters& counters = gTagCounters[static_cast<size_t>(tag)];
+	MemoryTagStats stats;
+	stats.heapBytes = counters.heapBytes.load(std::memory_order_relaxed);
+	stats.heapPeakBytes = counters.heapPeakBytes.load(std::memory_order_relaxed);
+	stats.heapAllocations = counters.heapAllocations.load(std::memory_order_relaxed);
+	stats.heapLive = counters.heapLive.load(std::memory_order_relaxed);
+	stats.estimatedCpuBytes = counters.estimatedCpuBytes.load(std::memory_order_relaxed);
+	stats.estimatedCpuPeakBytes = counters.estimatedCpuPeakBytes.load(std::memory_order_relaxed);
+	stats.estimatedGpuBytes = counters.estimatedGpuBytes.load(std::memory_order_relaxed);
+	stats.estimatedGpuPeakBytes = counters.estimatedGpuPeakBytes.load(std::memory_order_relaxed);
+	return stats;
+}
+
+std::string getMemoryReportJson() {
+	std::string json = "{\n";
+	json += ENGINE_TRACK_ALLOCATIONS ? "  \"heapTracking\": true,\n" : "  \"heapTracking\": false,\n";
+	json += "  \"heapAllocations\": " + std::to_string(getHeapAllocationCount()) + ",\n";
+	json += "  \"tags\": {\n";
+
+	char line[512];
+	for (size_t i = 0; i < kTagCount; i++) {
+		MemoryTagStats stats = getMemoryTagStats(static_cast<MemoryTag>(i));
+		std::snprintf(line, sizeof(line),
+			"    \"%s\": { \"heapBytes\": %lld, \"heapPeakBytes\": %lld, \"heapAllocations\": %llu, \"heapLive\": %lld, "
+			"\"cpuBytes\": %llu, \"cpuPeakBytes\": %llu, \"gpuBytes\": %llu, \"gpuPeakBytes\": %llu }%s\n",
+			kTagNames[i], (long long)stats.heapBytes, (long long)stats.heapPeakBytes, (unsigned long long)stats.heapAllocations,
+			(long long)stats.heapLive, (unsigned long long)stats.estimatedCpuBytes, (unsigned long long)stats.estimatedCpuPeakBytes,
+			(unsigned long long)stats.estimatedGpuBytes, (unsigned long long)stats.estimatedGpuPeakBytes, i + 1 < kTagCount ? "," : "");
+		json += line;
+	}
+
+	json += "  }\n}\n";
+	return json;
+}
+
+bool writeMemoryReport(const std::string& path) {
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file) {
+		return false;
+	}
+	file << getMemoryReportJson();
+	return bool(file);
+}
+
+void installMemoryReportSignal() {
+#if defined(SIGUSR1)
+	std::signal(SIGUSR1, onSignal);
+#elif defined(SIGBREAK)
+	std::signal(SIGBREAK, onSignal);
+#endif
+}
+
+void requestMemoryReport() {
+	gReportRequested.store(true);
+}
+
+bool takeMemoryReportRequest() {
+	return gReportRequested.exchange(false);
+}
@@ -0,0 +1,85 @@
+#pragma once
+#ifndef MEMORY_TAGS_H
+#define MEMORY_TAGS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Counts and tags every global operator new in debug builds, to prove
+// steady-state frames allocate nothing and to see which subsystem owns the
+// heap. Define ENGINE_TRACK_ALLOCATIONS=0 to turn it off.
+#if !defined(ENGINE_TRACK_ALLOCATIONS)
+#if defined(_DEBUG)
+#define ENGINE_TRACK_ALLOCATIONS 1
+#else
+#define ENGINE_TRACK_ALLOCATIONS 0
+#endif
+#endif
+
+// Global heap allocations since startup, 0 when tracking is compiled out
+uint64_t getHeapAllocationCount();
+
+enum class MemoryTag : uint8_t {
+	Untagged,
+	AssetsMesh,
+	AssetsTexture,
+	Animation,
+	Scene,
+	Render,
+	Frame,
+	Profiler,
+	Count
+};
+
+const char* getMemoryTagName(MemoryTag tag);
+
+// Heap allocations made on this thread while the scope is alive are charged to
+// its tag, and credited back to it when freed, whichever thread frees them.
+// Scopes nest; the innermost wins.
+class MemoryTagScope {
+public:
+	explicit MemoryTagScope(MemoryTag tag);
+	~MemoryTagScope();
+
+	MemoryTagScope(const MemoryTagScope&) = delete;
+	MemoryTagScope& operator=(const MemoryTagScope&) = delete;
+private:
+	MemoryTag m_Previous;
+};
+
+MemoryTag getCurrentMemoryTag();
+
+// Resident bytes of a tag that the allocator does not see: GPU buffers and
+// textures, or asset sizes computed by their owners. Replaces the previous
+// estimate and keeps the peak.
+void setMemoryEstimate(MemoryTag tag, size_t cpuBytes, size_t gpuBytes);
+
+struct MemoryTagStats {
+	// Tracked heap, zero without ENGINE_TRACK_ALLOCATIONS
+	int64_t heapBytes = 0;
+	int64_t heapPeakBytes = 0;
+	uint64_t heapAllocations = 0; // since startup
+	int64_t heapLive = 0;         // allocations not freed yet
+
+	// From setMemoryEstimate
+	size_t estimatedCpuBytes = 0;
+	size_t estimatedCpuPeakBytes = 0;
+	size_t estimatedGpuBytes = 0;
+	size_t estimatedGpuPeakBytes = 0;
+};
+
+MemoryTagStats getMemoryTagStats(MemoryTag tag);
+
+// Every tag's counters as one JSON object, for diffing between builds
+std::string getMemoryReportJson();
+bool writeMemoryReport(const std::string& path);
+
+// A dump can be asked for from a signal handler (SIGUSR1, or Ctrl+Break on
+// Windows) or a hotkey; the main loop writes it at a safe point
+void installMemoryReportSignal();
+void requestMemoryReport();
+// True once per request
+bool takeMemoryReportRequest();
+
+#endif
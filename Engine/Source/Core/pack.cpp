@@ -0,0 +1,155 @@
+#include "pack.h"
+#include "file.h"
+#include "hash.h"
+#include "lz4.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+uint64_t getPackPathHash(const std::string& path) {
+	return hash64(normalizePath(path));
+}
+
+bool openPack(const std::string& packPath, PackArchive& pack) {
+	PackHeader header;
+	std::string bytes;
+	if (readFile(packPath, bytes, 0, sizeof(header)) != FileError::None) {
+		std::cerr << "Error opening pack:" << packPath << std::endl;
+		return false;
+	}
+	std::memcpy(&header, bytes.data(), sizeof(header));
+
+	FileStamp stamp;
+	if (header.magic != kPackMagic || header.version != kPackVersion || !getFileStamp(packPath, stamp) || header.fileSize != stamp.size ||
+		header.tocOffset > stamp.size || header.entryCount > (stamp.size - header.tocOffset) / sizeof(PackEntry)) {
+		std::cerr << "Pack is malformed or from another version:" << packPath << std::endl;
+		return false;
+	}
+
+	if (readFile(packPath, bytes, header.tocOffset, uint64_t(header.entryCount) * sizeof(PackEntry)) != FileError::None && header.entryCount > 0) {
+		std::cerr << "Error reading pack contents:" << packPath << std::endl;
+		return false;
+	}
+
+	pack.path = packPath;
+	pack.entries.resize(header.entryCount);
+	std::memcpy(pack.entries.data(), bytes.data(), pack.entries.size() * sizeof(PackEntry));
+	for (const PackEntry& entry : pack.entries) {
+		if (entry.offset > header.tocOffset || entry.storedSize > header.tocOffset - entry.offset) {
+			std::cerr << "Pack entry points outside the archive:" << packPath << std::endl;
+			pack.entries.clear();
+			return false;
+		}
+	}
+	return true;
+}
+
+const PackEntry* findPackEntry(const PackArchive& pack, const std::string& path) {
+	uint64_t hash = getPackPathHash(path);
+	auto it = std::lower_bound(pack.entries.begin(), pack.entries.end(), hash,
+		[](const PackEntry& entry, uint64_t value) { return entry.pathHash < value; });
+	return it != pack.entries.end() && it->pathHash == hash ? &*it : nullptr;
+}
+
+bool writePack(const std::string& packPath, const std::vector<std::string>& files, bool compress) {
+	std::error_code error;
+	std::filesystem::path parent = std::filesystem::path(packPath).parent_path();
+	if (!parent.empty()) {
+		std::filesystem::create_directories(parent, error);
+	}
+
+	std::string tempPath = packPath + ".tmp";
+	std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+	if (!out) {
+		std::cerr << "Error opening file for writing:" << tempPath << std::endl;
+		return false;
+	}
+
+	PackHeader header = {};
+	header.magic = kPackMagic;
+	header.version = kPackVersion;
+	header.alignment = kPackAlignment;
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	uint64_t position = sizeof(header);
+
+	auto pad = [&](uint64_t alignment) {
+		static const char zeros[kPackAlignment] = {};
+		uint64_t padding = (alignment - position % alignment) % alignment;
+		out.write(zeros, static_cast<std::streamsize>(padding));
+		position += padding;
+	};
+
+	std::vector<PackEntry> entries;
+	std::string contents;
+	std::string compressed;
+	uint64_t rawBytes = 0;
+	for (const std::string& file : files) {
+		FileStamp stamp;
+		FileError readError = readFile(file, contents);
+		if (readError != FileError::None || !getFileStamp(file, stamp)) {
+			std::cerr << "Error reading file for pack:" << file << " " << getFileErrorName(readError) << std::endl;
+			return false;
+		}
+
+		PackEntry entry = {};
+		entry.pathHash = getPackPathHash(file);
+		entry.size = contents.size();
+		entry.writeTime = stamp.writeTime;
+		entry.compression = static_cast<uint32_t>(PackCompression::None);
+
+		const std::string* stored = &contents;
+		if (compress && !contents.empty()) {
+			compressed.resize(getLz4MaxCompressedSize(contents.size()));
+			size_t compressedSize = compressLz4(contents.data(), contents.size(), compressed.data(), compressed.size());
+			if (compressedSize > 0 && compressedSize <= contents.size() - contents.size() / 8) {
+				compressed.resize(compressedSize);
+				entry.compression = static_cast<uint32_t>(PackCompression::LZ4);
+				stored = &compressed;
+			}
+		}
+
+		pad(kPackAlignment);
+		entry.offset = position;
+		entry.storedSize = stored->size();
+		out.write(stored->data(), static_cast<std::streamsize>(stored->size()));
+		position += stored->size();
+		rawBytes += contents.size();
+		entries.push_back(entry);
+	}
+
+	std::sort(entries.begin(), entries.end(), [](const PackEntry& a, const PackEntry& b) { return a.pathHash < b.pathHash; });
+	for (size_t i = 1; i < entries.size(); i++) {
+		if (entries[i].pathHash == entries[i - 1].pathHash) {
+			std::cerr << "Two pack paths hash the same, or a file is listed twice:" << packPath << std::endl;
+			return false;
+		}
+	}
+
+	pad(alignof(PackEntry));
+	header.entryCount = static_cast<uint32_t>(entries.size());
+	header.tocOffset = position;
+	out.write(reinterpret_cast<const char*>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(PackEntry)));
+	position += entries.size() * sizeof(PackEntry);
+	header.fileSize = position;
+
+	out.seekp(0);
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	out.close();
+	if (!out) {
+		std::cerr << "Error writing file:" << tempPath << std::endl;
+		return false;
+	}
+
+	std::filesystem::rename(tempPath, packPath, error);
+	if (error) {
+		std::cerr << "Error replacing file:" << packPath << " " << error.message() << std::endl;
+		std::filesystem::remove(tempPath, error);
+		return false;
+	}
+
+	std::cout << "Packed " << entries.size() << " files, " << rawBytes << " bytes into " << position << ":" << packPath << std::endl;
+	return true;
+}
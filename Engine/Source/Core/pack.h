@@ -0,0 +1,58 @@
+#pragma once
+#ifndef PACK_H
+#define PACK_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Pack archive: every entry's data back to back at kPackAlignment, then a
+// table of contents sorted by path hash, then nothing else. Entries are looked
+// up by hashing the normalized path they were packed under, so the archive
+// stores no names.
+
+constexpr uint32_t kPackMagic = 0x4B415045; // "EPAK"
+constexpr uint32_t kPackVersion = 1;
+constexpr uint32_t kPackAlignment = 4096;
+
+enum class PackCompression : uint32_t {
+	None = 0,
+	LZ4 = 1, // LZ4 block, see Core/lz4.h
+};
+
+struct PackHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t entryCount;
+	uint32_t alignment;
+	uint64_t tocOffset;
+	uint64_t fileSize;
+};
+
+struct PackEntry {
+	uint64_t pathHash;
+	uint64_t offset;
+	uint64_t storedSize; // bytes in the archive
+	uint64_t size;       // bytes once decompressed
+	int64_t writeTime;   // of the packed file, so cooked data can still check its source
+	uint32_t compression;
+	uint32_t reserved;
+};
+
+struct PackArchive {
+	std::string path;
+	std::vector<PackEntry> entries;
+};
+
+uint64_t getPackPathHash(const std::string& path);
+
+// Reads and validates the table of contents
+bool openPack(const std::string& packPath, PackArchive& pack);
+const PackEntry* findPackEntry(const PackArchive& pack, const std::string& path);
+
+// Packs files under the paths they are given as. With compress, an entry is
+// stored as LZ4 when that saves at least an eighth of it; already compressed
+// data such as PNGs and BCn textures stays raw and mappable.
+bool writePack(const std::string& packPath, const std::vector<std::string>& files, bool compress);
+
+#endif
@@ -0,0 +1,297 @@
+#include "profiler.h"
+#include "json.h"
+#include "memorytags.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+	// 1.5 MB per thread that ever records a zone, and per extra track. A few
+	// hundred zones a frame keeps several hundred frames of history.
+	constexpr uint64_t kEventsPerTrack = uint64_t(1) << 16;
+
+	// Only the owning thread writes, but the exporting thread may read a slot
+	// while it is being overwritten. Relaxed atomics keep that race defined and
+	// compile to plain moves.
+	struct ProfileEvent {
+		std::atomic<const char*> name{ nullptr };
+		std::atomic<uint64_t> start{ 0 };
+		std::atomic<uint64_t> end{ 0 };
+	};
+}
+
+// One per thread that records zones, plus one per createProfilerTrack
+struct ProfileTrack {
+	uint32_t id = 0;
+	std::string name; // guarded by Profiler::mutex
+	std::unique_ptr<ProfileEvent[]> events;
+	// Event i lives in slot i % kEventsPerTrack. claimed is bumped before a
+	// slot is overwritten and written after, so a reader can tell which of
+	// the slots it copied may be torn.
+	std::atomic<uint64_t> claimed{ 0 };
+	std::atomic<uint64_t> written{ 0 };
+};
+
+namespace {
+	struct Profiler {
+		std::mutex mutex;
+		// Never freed: workers record until they are joined, which can be after
+		// static destruction has begun
+		std::vector<ProfileTrack*> tracks;
+		// Main thread only
+		uint64_t frameStarts[kProfilerFrameHistory] = {};
+		std::atomic<uint64_t> frame{ 0 };
+		uint64_t calibrationTicks = getProfilerTicks();
+		std::chrono::steady_clock::time_point calibrationTime = std::chrono::steady_clock::now();
+	};
+
+	Profiler& getProfiler() {
+		static Profiler* profiler = new Profiler();
+		return *profiler;
+	}
+
+	thread_local ProfileTrack* tThread = nullptr;
+
+	ProfileTrack* registerTrack(const char* name) {
+		ProfileTrack* track;
+		{
+			MemoryTagScope tag(MemoryTag::Profiler);
+			track = new ProfileTrack();
+			track->events.reset(new ProfileEvent[kEventsPerTrack]);
+		}
+
+		Profiler& profiler = getProfiler();
+		std::lock_guard<std::mutex> lock(profiler.mutex);
+		track->id = (uint32_t)profiler.tracks.size() + 1;
+		track->name = name ? name : "Thread " + std::to_string(track->id);
+		profiler.tracks.push_back(track);
+		return track;
+	}
+
+	ProfileTrack* registerThread() {
+		tThread = registerTrack(nullptr);
+		return tThread;
+	}
+
+	void writeEvent(ProfileTrack& track, const char* name, uint64_t start, uint64_t end) {
+		uint64_t index = track.written.load(std::memory_order_relaxed);
+		track.claimed.store(index + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		ProfileEvent& event = track.events[index % kEventsPerTrack];
+		event.name.store(name, std::memory_order_relaxed);
+		event.start.store(start, std::memory_order_relaxed);
+		event.end.store(end, std::memory_order_relaxed);
+		track.written.store(index + 1, std::memory_order_release);
+	}
+
+	struct CopiedEvent {
+		const char* name;
+		uint64_t start;
+		uint64_t end;
+	};
+
+	void copyEvents(const ProfileTrack& track, std::vector<CopiedEvent>& events) {
+		events.clear();
+		uint64_t written = track.written.load(std::memory_order_acquire);
+		uint64_t first = written > kEventsPerTrack ? written - kEventsPerTrack : 0;
+		for (uint64_t i = first; i < written; i++) {
+			const ProfileEvent& event = track.events[i % kEventsPerTrack];
+			events.push_back({ event.name.load(std::memory_order_relaxed), event.start.load(std::memory_order_relaxed),
+				event.end.load(std::memory_order_relaxed) });
+		}
+
+		// Anything the owner claimed while we copied has overwritten the oldest
+		// slots; drop those
+		std::atomic_thread_fence(std::memory_order_acquire);
+		uint64_t claimed = track.claimed.load(std::memory_order_relaxed);
+		uint64_t valid = claimed > kEventsPerTrack ? claimed - kEventsPerTrack : 0;
+		if (valid > first) {
+			size_t stale = (size_t)std::min(valid - first, written - first);
+			events.erase(events.begin(), events.begin() + stale);
+		}
+	}
+
+	// Ticks per microsecond, measured against steady_clock since startup
+	double getTicksPerMicrosecond(Profiler& profiler) {
+		using Clock = std::chrono::steady_clock;
+		// Reading the two clocks is not atomic, a millisecond apart that error
+		// is already down to a few parts in a hundred thousand
+		Clock::duration minimum = std::chrono::milliseconds(1);
+		Clock::duration elapsed = Clock::now() - profiler.calibrationTime;
+		if (elapsed < minimum) {
+			std::this_thread::sleep_for(minimum - elapsed);
+		}
+		uint64_t ticks = getProfilerTicks();
+		double microseconds = std::chrono::duration<double, std::micro>(Clock::now() - profiler.calibrationTime).count();
+		return double(ticks - profiler.calibrationTicks) / microseconds;
+	}
+}
+
+void recordProfileZone(const char* name, uint64_t start, uint64_t end) {
+	ProfileTrack* thread = tThread;
+	if (!thread) {
+		thread = registerThread();
+	}
+	writeEvent(*thread, name, start, end);
+}
+
+void setProfilerThreadName(const char* name) {
+	ProfileTrack* thread = tThread ? tThread : registerThread();
+	std::lock_guard<std::mutex> lock(getProfiler().mutex);
+	thread->name = name;
+}
+
+ProfileTrack* createProfilerTrack(const char* name) {
+	return registerTrack(name);
+}
+
+void recordProfileZone(ProfileTrack* track, const char* name, uint64_t start, uint64_t end) {
+	writeEvent(*track, name, start, end);
+}
+
+double getProfilerTicksPerMicrosecond() {
+	return getTicksPerMicrosecond(getProfiler());
+}
+
+void beginProfilerFrame() {
+	Profiler& profiler = getProfiler();
+	uint64_t frame = profiler.frame.load(std::memory_order_relaxed) + 1;
+	profiler.frameStarts[frame % kProfilerFrameHistory] = getProfilerTicks();
+	profiler.frame.store(frame, std::memory_order_relaxed);
+}
+
+uint64_t getProfilerFrame() {
+	return getProfiler().frame.load(std::memory_order_relaxed);
+}
+
+std::string getChromeTraceJson(uint64_t firstFrame, uint64_t lastFrame) {
+	Profiler& profiler = getProfiler();
+	uint64_t current = profiler.frame.load(std::memory_order_relaxed);
+	uint64_t oldest = current >= kProfilerFrameHistory ? current - kProfilerFrameHistory + 1 : 1;
+	firstFrame = std::max(firstFrame, oldest);
+	lastFrame = std::min(lastFrame, current);
+
+	// Numbers go through the line buffer, names straight into json so no
+	// length of name can cut an event short
+	char line[256];
+	std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	bool firstEvent = true;
+	auto beginEvent = [&]() {
+		json += firstEvent ? "" : ",\n";
+		firstEvent = false;
+	};
+
+	std::vector<ProfileTrack*> tracks;
+	{
+		std::lock_guard<std::mutex> lock(profiler.mutex);
+		tracks = profiler.tracks;
+		for (const ProfileTrack* track : tracks) {
+			beginEvent();
+			std::snprintf(line, sizeof(line), "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", track->id);
+			json += line;
+			appendJsonString(json, track->name);
+			json += "}}";
+		}
+	}
+
+	if (firstFrame <= lastFrame) {
+		double ticksPerMicrosecond = getTicksPerMicrosecond(profiler);
+		uint64_t rangeStart = profiler.frameStarts[firstFrame % kProfilerFrameHistory];
+		uint64_t rangeEnd = lastFrame < current ? profiler.frameStarts[(lastFrame + 1) % kProfilerFrameHistory] : getProfilerTicks();
+		auto toMicroseconds = [&](uint64_t ticks) { return double(int64_t(ticks - rangeStart)) / ticksPerMicrosecond; };
+
+		for (uint64_t frame = firstFrame; frame <= lastFrame; frame++) {
+			beginEvent();
+			std::snprintf(line, sizeof(line), "{\"name\":\"Frame %llu\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":0,\"ts\":%.3f}",
+				(unsigned long long)frame, toMicroseconds(profiler.frameStarts[frame % kProfilerFrameHistory]));
+			json += line;
+		}
+
+		// Zones that started inside the range, whenever they ended
+		std::vector<CopiedEvent> events;
+		events.reserve(kEventsPerTrack);
+		for (const ProfileTrack* track : tracks) {
+			copyEvents(*track, events);
+			for (const CopiedEvent& event : events) {
+				if (event.start < rangeStart || event.start >= rangeEnd) {
+					continue;
+				}
+				beginEvent();
+				json += "{\"name\":";
+				appendJsonString(json, event.name);
+				std::snprintf(line, sizeof(line), ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+					track->id, toMicroseconds(event.start), double(event.end - event.start) / ticksPerMicrosecond);
+				json += line;
+			}
+		}
+	}
+
+	json += "\n]}\n";
+	return json;
+}
+
+bool writeChromeTrace(const std::string& path, uint64_t firstFrame, uint64_t lastFrame) {
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file) {
+		return false;
+	}
+	file << getChromeTraceJson(firstFrame, lastFrame);
+	return bool(file);
+}
+
+bool benchmarkProfiler() {
+#if ENGINE_PROFILER
+	using Clock = std::chrono::steady_clock;
+	const int zoneCount = 1000000;
+
+	// First zone registers the thread, keep it out of the measurement
+	{
+		PROFILE_ZONE("benchmarkProfiler");
+	}
+
+	Clock::time_point start = Clock::now();
+	for (int i = 0; i < zoneCount; i++) {
+		PROFILE_ZONE("Empty zone");
+	}
+	float emptyMilliseconds = std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+
+	start = Clock::now();
+	for (int i = 0; i < zoneCount / 4; i++) {
+		PROFILE_ZONE("Outer zone");
+		for (int j = 0; j < 3; j++) {
+			PROFILE_ZONE("Inner zone");
+		}
+	}
+	float nestedMilliseconds = std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+
+	// Two timestamps are most of a zone; virtual machines that trap rdtsc pay
+	// for them several times over
+	uint64_t sum = 0;
+	start = Clock::now();
+	for (int i = 0; i < zoneCount; i++) {
+		sum += getProfilerTicks();
+	}
+	float timerMilliseconds = std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+
+	float emptyNanoseconds = emptyMilliseconds * 1000000.0f / zoneCount;
+	float nestedNanoseconds = nestedMilliseconds * 1000000.0f / zoneCount;
+	std::cout << zoneCount << " empty zones: " << emptyMilliseconds << " ms, " << emptyNanoseconds << " ns per zone" << std::endl;
+	std::cout << zoneCount << " nested zones: " << nestedMilliseconds << " ms, " << nestedNanoseconds << " ns per zone" << std::endl;
+	std::cout << "Timer: " << (PROFILER_USE_RDTSC ? "rdtsc" : "steady_clock") << ", "
+		<< timerMilliseconds * 1000000.0f / zoneCount << " ns per read, "
+		<< getTicksPerMicrosecond(getProfiler()) << " ticks per us" << (sum == 0 ? " (stopped)" : "") << std::endl;
+	return true;
+#else
+	std::cout << "The profiler is compiled out (ENGINE_PROFILER=0)" << std::endl;
+	return false;
+#endif
+}
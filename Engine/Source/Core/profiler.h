@@ -0,0 +1,97 @@
+#pragma once
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <cstdint>
+#include <string>
+
+// Hierarchical CPU zones for finding out where a frame spike went.
+// PROFILE_ZONE("name") times the rest of its scope into a ring buffer owned by
+// the calling thread, so recording takes no lock and touches no shared cache
+// line; zones nest by time, a viewer draws them as a tree per thread. Traces
+// are written on request for a range of recent frames. Build with
+// ENGINE_PROFILER=0 and every zone compiles to nothing.
+#if !defined(ENGINE_PROFILER)
+#define ENGINE_PROFILER 1
+#endif
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define PROFILER_USE_RDTSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define PROFILER_USE_RDTSC 1
+#else
+#include <chrono>
+#define PROFILER_USE_RDTSC 0
+#endif
+
+// Raw timestamp: the invariant TSC on x86, steady_clock nanoseconds elsewhere.
+// Converted to time when a trace is written.
+inline uint64_t getProfilerTicks() {
+#if PROFILER_USE_RDTSC
+	return __rdtsc();
+#else
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+// name must outlive the profiler, a string literal or __FUNCTION__. Events
+// past a thread's ring capacity overwrite its oldest ones.
+void recordProfileZone(const char* name, uint64_t start, uint64_t end);
+
+class ProfileZone {
+public:
+	explicit ProfileZone(const char* name) : m_Name(name), m_Start(getProfilerTicks()) {}
+	~ProfileZone() { recordProfileZone(m_Name, m_Start, getProfilerTicks()); }
+
+	ProfileZone(const ProfileZone&) = delete;
+	ProfileZone& operator=(const ProfileZone&) = delete;
+private:
+	const char* m_Name;
+	uint64_t m_Start;
+};
+
+// Shown as the thread's track name, copied
+void setProfilerThreadName(const char* name);
+
+// A timeline that is not a CPU thread, such as the GPU. Its zones are recorded
+// after the fact, by one thread at a time, with times already converted to
+// profiler ticks.
+struct ProfileTrack;
+ProfileTrack* createProfilerTrack(const char* name);
+void recordProfileZone(ProfileTrack* track, const char* name, uint64_t start, uint64_t end);
+
+// Rate of getProfilerTicks, measured against steady_clock since the first zone
+double getProfilerTicksPerMicrosecond();
+
+// Main thread, once at the top of every frame. Frames are what traces are cut by.
+void beginProfilerFrame();
+// Index of the frame in progress, 0 before the first beginProfilerFrame
+uint64_t getProfilerFrame();
+
+// Chrome trace event JSON of frames [firstFrame, lastFrame], opened by
+// chrome://tracing and ui.perfetto.dev. Only the last kProfilerFrameHistory
+// frames can be written, and busy threads may have overwritten the oldest of
+// those already. Main thread only.
+constexpr uint64_t kProfilerFrameHistory = 1024;
+std::string getChromeTraceJson(uint64_t firstFrame, uint64_t lastFrame);
+bool writeChromeTrace(const std::string& path, uint64_t firstFrame, uint64_t lastFrame);
+
+// Cost of an empty zone, printed. Returns false when the profiler is compiled out.
+bool benchmarkProfiler();
+
+#if ENGINE_PROFILER
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#define PROFILE_THREAD(name) setProfilerThreadName(name)
+#define PROFILE_FRAME() beginProfilerFrame()
+#else
+#define PROFILE_ZONE(name) ((void)0)
+#define PROFILE_THREAD(name) ((void)0)
+#define PROFILE_FRAME() ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,70 @@
+#include "threadpool.h"
+#include "profiler.h"
+
+#include <algorithm>
+
+ThreadPool::~ThreadPool() {
+	stop();
+}
+
+void ThreadPool::start(unsigned int threadCount) {
+	if (!m_Workers.empty()) {
+		return;
+	}
+
+	if (threadCount == 0) {
+		unsigned int cores = std::thread::hardware_concurrency();
+		threadCount = std::max(1u, cores > 1 ? cores - 1 : 1u);
+	}
+
+	m_Stopping = false;
+	for (unsigned int i = 0; i < threadCount; i++) {
+		m_Workers.emplace_back(&ThreadPool::workerLoop, this);
+	}
+}
+
+void ThreadPool::stop() {
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Stopping = true;
+	}
+	m_Condition.notify_all();
+
+	for (std::thread& worker : m_Workers) {
+		worker.join();
+	}
+	m_Workers.clear();
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+	// Without workers the task runs inline, which keeps callers correct before start()
+	if (m_Workers.empty()) {
+		task();
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Tasks.push_back(std::move(task));
+	}
+	m_Condition.notify_one();
+}
+
+void ThreadPool::workerLoop() {
+	PROFILE_THREAD("Pool worker");
+
+	for (;;) {
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_Condition.wait(lock, [this] { return m_Stopping || !m_Tasks.empty(); });
+			// Drain remaining work before exiting so nothing that was submitted is lost
+			if (m_Tasks.empty()) {
+				return;
+			}
+			task = std::move(m_Tasks.front());
+			m_Tasks.pop_front();
+		}
+		task();
+	}
+}
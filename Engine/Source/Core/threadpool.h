@@ -0,0 +1,39 @@
+#pragma once
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads pulling tasks from a shared FIFO queue.
+// Meant for coarse, possibly blocking work such as file I/O and decoding.
+class ThreadPool {
+public:
+	ThreadPool() = default;
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	// threadCount of 0 uses one thread per core, leaving one for the main thread
+	void start(unsigned int threadCount = 0);
+	void stop();
+
+	void submit(std::function<void()> task);
+
+	unsigned int getThreadCount() const { return (unsigned int)m_Workers.size(); }
+private:
+	std::vector<std::thread> m_Workers;
+	std::deque<std::function<void()>> m_Tasks;
+	std::mutex m_Mutex;
+	std::condition_variable m_Condition;
+	bool m_Stopping = false;
+
+	void workerLoop();
+};
+
+#endif
@@ -0,0 +1,193 @@
+#include "vfs.h"
+#include "lz4.h"
+
+#include <filesystem>
+#include <iostream>
+
+VirtualFileSystem gVFS;
+
+namespace {
+	// Path relative to the mount, or false when the mount does not cover it
+	bool getMountPath(const VfsMount& mount, const std::string& path, std::string& relative) {
+		if (mount.prefix.empty()) {
+			relative = path;
+			return true;
+		}
+		if (path.compare(0, mount.prefix.size(), mount.prefix) != 0 ||
+			(path.size() > mount.prefix.size() && path[mount.prefix.size()] != '/')) {
+			return false;
+		}
+		relative = path.size() > mount.prefix.size() ? path.substr(mount.prefix.size() + 1) : "";
+		return true;
+	}
+
+	struct MountMatch {
+		const VfsMount* mount = nullptr;
+		const PackEntry* entry = nullptr;
+		std::string diskPath;
+	};
+
+	bool findMount(const VirtualFileSystem& vfs, const std::string& filePath, MountMatch& match) {
+		std::string path = normalizePath(filePath);
+		std::string relative;
+		for (auto it = vfs.mounts.rbegin(); it != vfs.mounts.rend(); ++it) {
+			if (!getMountPath(*it, path, relative)) {
+				continue;
+			}
+
+			if (it->pack) {
+				if (const PackEntry* entry = findPackEntry(*it->pack, relative)) {
+					match.mount = &*it;
+					match.entry = entry;
+					match.diskPath = it->pack->path;
+					return true;
+				}
+				continue;
+			}
+
+			std::string diskPath = it->directory.empty() || it->directory == "." ? relative : it->directory + "/" + relative;
+			std::error_code error;
+			if (std::filesystem::is_regular_file(diskPath, error)) {
+				match.mount = &*it;
+				match.diskPath = std::move(diskPath);
+				return true;
+			}
+		}
+		return false;
+	}
+}
+
+void mountDirectory(VirtualFileSystem& vfs, const std::string& prefix, const std::string& directory) {
+	VfsMount mount;
+	mount.prefix = normalizePath(prefix);
+	mount.directory = normalizePath(directory);
+	vfs.mounts.push_back(std::move(mount));
+}
+
+bool mountPack(VirtualFileSystem& vfs, const std::string& prefix, const std::string& packPath) {
+	auto pack = std::make_shared<PackArchive>();
+	if (!openPack(packPath, *pack)) {
+		return false;
+	}
+
+	VfsMount mount;
+	mount.prefix = normalizePath(prefix);
+	mount.pack = std::move(pack);
+	vfs.mounts.push_back(std::move(mount));
+	return true;
+}
+
+FileError resolveVirtualFile(const VirtualFileSystem& vfs, const std::string& path, FileLocation& location) {
+	// Nothing mounted reads straight from the working directory
+	if (vfs.mounts.empty()) {
+		location = {};
+		location.diskPath = path;
+		return FileError::None;
+	}
+
+	MountMatch match;
+	if (!findMount(vfs, path, match)) {
+		return FileError::NotFound;
+	}
+
+	location = {};
+	location.diskPath = std::move(match.diskPath);
+	if (match.entry) {
+		location.offset = match.entry->offset;
+		location.storedSize = match.entry->storedSize;
+		location.size = match.entry->size;
+		location.compression = static_cast<PackCompression>(match.entry->compression);
+	}
+	return FileError::None;
+}
+
+bool virtualFileExists(const VirtualFileSystem& vfs, const std::string& path) {
+	if (vfs.mounts.empty()) {
+		std::error_code error;
+		return std::filesystem::is_regular_file(path, error);
+	}
+	MountMatch match;
+	return findMount(vfs, path, match);
+}
+
+bool getVirtualFileStamp(const VirtualFileSystem& vfs, const std::string& path, FileStamp& stamp) {
+	if (vfs.mounts.empty()) {
+		return getFileStamp(path, stamp);
+	}
+
+	MountMatch match;
+	if (!findMount(vfs, path, match)) {
+		return false;
+	}
+	if (match.entry) {
+		stamp.size = match.entry->size;
+		stamp.writeTime = match.entry->writeTime;
+		return true;
+	}
+	return getFileStamp(match.diskPath, stamp);
+}
+
+FileError decodeStoredFile(const FileLocation& location, std::string& contents) {
+	switch (location.compression) {
+	case PackCompression::None:
+		return FileError::None;
+	case PackCompression::LZ4: {
+		std::string decompressed(static_cast<size_t>(location.size), '\0');
+		if (!decompressLz4(contents.data(), contents.size(), decompressed.data(), decompressed.size())) {
+			return FileError::ReadFailed;
+		}
+		contents = std::move(decompressed);
+		return FileError::None;
+	}
+	}
+	return FileError::ReadFailed;
+}
+
+FileError readVirtualFile(const VirtualFileSystem& vfs, const std::string& path, std::string& contents) {
+	FileLocation location;
+	FileError error = resolveVirtualFile(vfs, path, location);
+	if (error != FileError::None) {
+		return error;
+	}
+
+	// An empty pack entry would read as "to the end of the archive"
+	if (location.offset != 0 && location.storedSize == 0) {
+		contents.clear();
+		return FileError::None;
+	}
+	error = readFile(location.diskPath, contents, location.offset, location.storedSize);
+	if (error != FileError::None) {
+		return error;
+	}
+	return decodeStoredFile(location, contents);
+}
+
+FileError mapVirtualFile(const VirtualFileSystem& vfs, const std::string& path, MappedFile& file) {
+	FileLocation location;
+	FileError error = resolveVirtualFile(vfs, path, location);
+	if (error != FileError::None) {
+		return error;
+	}
+
+	if (location.compression == PackCompression::None) {
+		if (location.offset != 0 && location.storedSize == 0) {
+			return FileError::Empty;
+		}
+		return mapFileRange(location.diskPath, file, location.offset, location.storedSize);
+	}
+
+	std::string contents;
+	error = readFile(location.diskPath, contents, location.offset, location.storedSize);
+	if (error == FileError::None) {
+		error = decodeStoredFile(location, contents);
+	}
+	if (error != FileError::None) {
+		return error;
+	}
+
+	unmapFile(file);
+	file.buffer.assign(contents.begin(), contents.end());
+	file.data = file.buffer.data();
+	file.size = file.buffer.size();
+	return FileError::None;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#ifndef VFS_H
+#define VFS_H
+
+#include "file.h"
+#include "pack.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// Where a virtual path's bytes are: a whole loose file, or a range of a pack
+struct FileLocation {
+	std::string diskPath;
+	uint64_t offset = 0;
+	uint64_t storedSize = 0; // 0 for a loose file, read to its end
+	uint64_t size = 0;
+	PackCompression compression = PackCompression::None;
+};
+
+// A directory or pack answering for every path under prefix ("" for all)
+struct VfsMount {
+	std::string prefix;
+	std::string directory;
+	std::shared_ptr<PackArchive> pack;
+};
+
+// Mount everything before loaders start, lookups are not synchronized.
+// Later mounts take priority, so loose files mounted after a pack override it.
+struct VirtualFileSystem {
+	std::vector<VfsMount> mounts;
+};
+
+extern VirtualFileSystem gVFS;
+
+void mountDirectory(VirtualFileSystem& vfs, const std::string& prefix, const std::string& directory);
+bool mountPack(VirtualFileSystem& vfs, const std::string& prefix, const std::string& packPath);
+
+FileError resolveVirtualFile(const VirtualFileSystem& vfs, const std::string& path, FileLocation& location);
+bool virtualFileExists(const VirtualFileSystem& vfs, const std::string& path);
+// Pack entries report the stamp of the file they were packed from
+bool getVirtualFileStamp(const VirtualFileSystem& vfs, const std::string& path, FileStamp& stamp);
+
+FileError readVirtualFile(const VirtualFileSystem& vfs, const std::string& path, std::string& contents);
+// Raw pack entries and loose files are mapped, compressed entries are
+// decompressed into the MappedFile's buffer
+FileError mapVirtualFile(const VirtualFileSystem& vfs, const std::string& path, MappedFile& file);
+
+// Turns the stored bytes of a location into the file contents, in place
+FileError decodeStoredFile(const FileLocation& location, std::string& contents);
+
+#endif
@@ -3,11 +3,13 @@
 #define ANIMATION_H
 
 #include <glm/mat4x4.hpp>
-#include <assimp/scene.h>
+#include "Core/file.h"
 #include "animdata.h"
 #include "bone.h"
 
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <map>
 
@@ -15,34 +17,61 @@ class Bone;
 struct Model;
 struct BoneInfo;
 
-struct AssimpNodeData {
+// Node of the flattened scene hierarchy. Nodes are stored parent first, so a
+// single forward pass over the array visits every parent before its children.
+struct AnimationNode {
 	glm::mat4 transformation;
-	std::string name;
-	int childrenCount;
-	std::vector<AssimpNodeData> children;
+	uint64_t nameOffset;
+	uint32_t nameLength;
+	int32_t parent;  // -1 for the root
+	int32_t channel; // index into the channel table, -1 when the node is not animated
+	uint32_t padding;
 };
 
+// Key ranges of one animated node inside the clip's key streams
+struct AnimationChannel {
+	uint64_t nameOffset;
+	uint32_t nameLength;
+	uint32_t positionFirst;
+	uint32_t positionCount;
+	uint32_t rotationFirst;
+	uint32_t rotationCount;
+	uint32_t scaleFirst;
+	uint32_t scaleCount;
+	uint32_t padding;
+};
+
+// Clip data is referenced in place, either from a mapped cooked file or from an
+// in-memory buffer with the same layout when the clip was just imported.
 class Animation {
 public:
 	float m_Duration;
 	int m_TicksPerSecond;
 	std::vector<Bone> m_Bones;
-	AssimpNodeData m_RootNode;
 	std::map<std::string, BoneInfo> m_BoneInfoMap;
 
+	const unsigned char* m_Data = nullptr;
+	const AnimationNode* m_Nodes = nullptr;
+	uint32_t m_NodeCount = 0;
+
+	MappedFile m_File;
+	std::vector<unsigned char> m_Blob;
+
 	Animation() = default;
 
-	Bone* findBone(const std::string& name);
+	Bone* findBone(std::string_view name);
+
+	// Bytes of clip data this animation keeps resident
+	size_t getDataSize() const;
 
 	inline float getTicksPerSecond() { return m_TicksPerSecond; }
 	inline float getDuration() { return m_Duration; }
-	inline const AssimpNodeData& getRootNode() { return m_RootNode; }
+	inline const AnimationNode* getNodes() const { return m_Nodes; }
+	inline uint32_t getNodeCount() const { return m_NodeCount; }
+	inline std::string_view getNodeName(const AnimationNode& node) const { return std::string_view(reinterpret_cast<const char*>(m_Data + node.nameOffset), node.nameLength); }
 	inline const std::map<std::string, BoneInfo>& getBoneIDMap() {  return m_BoneInfoMap; }
 	inline const void setBoneIDMap(std::map<std::string, BoneInfo>& newBoneInfoMap) { m_BoneInfoMap = newBoneInfoMap; }
 	inline std::vector<Bone>& getBones() { return m_Bones; }
-
-	void readMissingBones(const aiAnimation* animation);
-	void readHierarchyData(AssimpNodeData& dest, const aiNode* src);
 };
 
-#endif 
+#endif
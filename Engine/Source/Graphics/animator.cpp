@@ -4,6 +4,8 @@
 #include "animdata.h"
 #include "model.h"
 
+#include "Core/profiler.h"
+
 #include <iostream>
 
 Animator::Animator(Animation* animation, Model* model)
@@ -25,7 +27,7 @@ void Animator::ResolveBoneMappings(Animation* animation, Model* model) {
 
 	for (int i = 0; i < animation->getBones().size(); i++) {
 		Bone& bone = animation->getBones()[i];
-		std::string boneName = bone.GetBoneName();
+		std::string boneName(bone.GetBoneName());
 
 		if (boneInfoMap.find(boneName) == boneInfoMap.end()) {
 			std::cerr << "Warning: No matching bone found for " << boneName << "\n";
@@ -40,15 +42,27 @@ void Animator::ResolveBoneMappings(Animation* animation, Model* model) {
 	}
 
 	animation->setBoneIDMap(boneInfoMap);
+
+	// Resolve node names once so the per-frame pass needs no lookups
+	const AnimationNode* nodes = animation->getNodes();
+	m_GlobalTransforms.assign(animation->getNodeCount(), glm::mat4(1.0f));
+	m_NodeBones.assign(animation->getNodeCount(), BoneInfo{ -1, glm::mat4(1.0f) });
+	for (uint32_t i = 0; i < animation->getNodeCount(); i++) {
+		auto it = boneInfoMap.find(std::string(animation->getNodeName(nodes[i])));
+		if (it != boneInfoMap.end() && it->second.id < (int)m_FinalBoneMatrices.size()) {
+			m_NodeBones[i] = it->second;
+		}
+	}
 }
 
 void Animator::UpdateAnimation(float dt)
 {
+	PROFILE_ZONE("Animator::UpdateAnimation");
 	if (m_CurrentAnimation)
 	{
 		m_CurrentTime += m_CurrentAnimation->getTicksPerSecond() * dt;
 		m_CurrentTime = fmod(m_CurrentTime, m_CurrentAnimation->getDuration());
-		CalculateBoneTransform(&m_CurrentAnimation->getRootNode(), glm::mat4(1.0f));
+		CalculateBoneTransforms();
 	}
 }
 
@@ -59,34 +73,32 @@ void Animator::PlayAnimation(Animation* pAnimation, Model* model)
 	ResolveBoneMappings(pAnimation, model);
 }
 
-void Animator::CalculateBoneTransform(const AssimpNodeData* node, glm::mat4 parentTransform)
+void Animator::CalculateBoneTransforms()
 {
-	std::string nodeName = node->name;
-	glm::mat4 nodeTransform = node->transformation;
-
-	Bone* Bone = m_CurrentAnimation->findBone(nodeName);
+	const AnimationNode* nodes = m_CurrentAnimation->getNodes();
+	const std::vector<Bone>& bones = m_CurrentAnimation->getBones();
 
-	if (Bone)
+	// Parents precede their children, so one forward pass resolves the hierarchy
+	for (uint32_t i = 0; i < m_CurrentAnimation->getNodeCount(); i++)
 	{
-		Bone->Update(m_CurrentTime);
-		nodeTransform = Bone->GetLocalTransform();
-	}
+		const AnimationNode& node = nodes[i];
+		glm::mat4 nodeTransform = node.transformation;
 
-	glm::mat4 globalTransformation = parentTransform * nodeTransform;
+		if (node.channel >= 0)
+		{
+			nodeTransform = bones[node.channel].Sample(m_CurrentTime);
+		}
 
-	auto boneInfoMap = m_CurrentAnimation->getBoneIDMap();
-	if (boneInfoMap.find(nodeName) != boneInfoMap.end())
-	{
-		int index = boneInfoMap[nodeName].id;
-		glm::mat4 offset = boneInfoMap[nodeName].offset;
-		m_FinalBoneMatrices[index] = globalTransformation * offset;
-	}
+		glm::mat4 parentTransform = node.parent >= 0 ? m_GlobalTransforms[node.parent] : glm::mat4(1.0f);
+		m_GlobalTransforms[i] = parentTransform * nodeTransform;
 
-	for (int i = 0; i < node->childrenCount; i++)
-		CalculateBoneTransform(&node->children[i], globalTransformation);
+		const BoneInfo& boneInfo = m_NodeBones[i];
+		if (boneInfo.id >= 0)
+			m_FinalBoneMatrices[boneInfo.id] = m_GlobalTransforms[i] * boneInfo.offset;
+	}
 }
 
-std::vector<glm::mat4> Animator::GetFinalBoneMatrices()
+const std::vector<glm::mat4>& Animator::GetFinalBoneMatrices() const
 {
 	return m_FinalBoneMatrices;
 }
@@ -8,9 +8,10 @@
 #include <map>
 #include <string>
 
+#include "animdata.h"
+
 struct Model;
 class Animation;
-struct AssimpNodeData;
 
 class Animator
 {
@@ -23,12 +24,14 @@ public:
 
 	void PlayAnimation(Animation* pAnimation, Model* model);
 
-	void CalculateBoneTransform(const AssimpNodeData* node, glm::mat4 parentTransform);
+	void CalculateBoneTransforms();
 
-	std::vector<glm::mat4> GetFinalBoneMatrices();
+	const std::vector<glm::mat4>& GetFinalBoneMatrices() const;
 private:
 	Model* model;
 	std::vector<glm::mat4> m_FinalBoneMatrices;
+	std::vector<glm::mat4> m_GlobalTransforms; // per animation node
+	std::vector<BoneInfo> m_NodeBones; // per animation node, id is -1 when the node drives no vertices
 	Animation* m_CurrentAnimation;
 	std::map<std::string, int> m_BoneMapping;
 	float m_CurrentTime;
@@ -1,55 +1,36 @@
 #include "bone.h"
 
-Bone::Bone(const std::string& name, int ID, const aiNodeAnim* channel)
+Bone::Bone(std::string_view name, int ID,
+	const KeyPosition* positions, int numPositions,
+	const KeyRotation* rotations, int numRotations,
+	const KeyScale* scales, int numScales)
 	:
+	m_Positions(positions),
+	m_Rotations(rotations),
+	m_Scales(scales),
+	m_NumPositions(numPositions),
+	m_NumRotations(numRotations),
+	m_NumScalings(numScales),
+	m_LocalTransform(1.0f),
 	m_Name(name),
-	m_ID(ID),
-	m_LocalTransform(1.0f)
+	m_ID(ID)
 {
-	m_NumPositions = channel->mNumPositionKeys;
-
-	for (int positionIndex = 0; positionIndex < m_NumPositions; ++positionIndex)
-	{
-		aiVector3D aiPosition = channel->mPositionKeys[positionIndex].mValue;
-		float timeStamp = channel->mPositionKeys[positionIndex].mTime;
-		KeyPosition data;
-		data.position = getGLMVec(aiPosition);
-		data.timeStamp = timeStamp;
-		m_Positions.push_back(data);
-	}
-
-	m_NumRotations = channel->mNumRotationKeys;
-	for (int rotationIndex = 0; rotationIndex < m_NumRotations; ++rotationIndex)
-	{
-		aiQuaternion aiOrientation = channel->mRotationKeys[rotationIndex].mValue;
-		float timeStamp = channel->mRotationKeys[rotationIndex].mTime;
-		KeyRotation data;
-		data.orientation = getGLMQuat(aiOrientation);
-		data.timeStamp = timeStamp;
-		m_Rotations.push_back(data);
-	}
-
-	m_NumScalings = channel->mNumScalingKeys;
-	for (int keyIndex = 0; keyIndex < m_NumScalings; ++keyIndex)
-	{
-		aiVector3D scale = channel->mScalingKeys[keyIndex].mValue;
-		float timeStamp = channel->mScalingKeys[keyIndex].mTime;
-		KeyScale data;
-		data.scale = getGLMVec(scale);
-		data.timeStamp = timeStamp;
-		m_Scales.push_back(data);
-	}
 }
 
 void Bone::Update(float animationTime)
+{
+	m_LocalTransform = Sample(animationTime);
+}
+
+glm::mat4 Bone::Sample(float animationTime) const
 {
 	glm::mat4 translation = InterpolatePosition(animationTime);
 	glm::mat4 rotation = InterpolateRotation(animationTime);
 	glm::mat4 scale = InterpolateScaling(animationTime);
-	m_LocalTransform = translation * rotation * scale;
+	return translation * rotation * scale;
 }
 
-int Bone::GetPositionIndex(float animationTime)
+int Bone::GetPositionIndex(float animationTime) const
 {
 	for (int index = 0; index < m_NumPositions - 1; ++index)
 	{
@@ -59,7 +40,7 @@ int Bone::GetPositionIndex(float animationTime)
 	assert(0);
 }
 
-int Bone::GetRotationIndex(float animationTime)
+int Bone::GetRotationIndex(float animationTime) const
 {
 	for (int index = 0; index < m_NumRotations - 1; ++index)
 	{
@@ -69,7 +50,7 @@ int Bone::GetRotationIndex(float animationTime)
 	assert(0);
 }
 
-int Bone::GetScaleIndex(float animationTime)
+int Bone::GetScaleIndex(float animationTime) const
 {
 	for (int index = 0; index < m_NumScalings - 1; ++index)
 	{
@@ -79,7 +60,7 @@ int Bone::GetScaleIndex(float animationTime)
 	assert(0);
 }
 
-float Bone::GetScaleFactor(float lastTimeStamp, float nextTimeStamp, float animationTime)
+float Bone::GetScaleFactor(float lastTimeStamp, float nextTimeStamp, float animationTime) const
 {
 	float scaleFactor = 0.0f;
 	float midWayLength = animationTime - lastTimeStamp;
@@ -88,7 +69,7 @@ float Bone::GetScaleFactor(float lastTimeStamp, float nextTimeStamp, float anima
 	return scaleFactor;
 }
 
-glm::mat4 Bone::InterpolatePosition(float animationTime)
+glm::mat4 Bone::InterpolatePosition(float animationTime) const
 {
 	if (1 == m_NumPositions)
 		return glm::translate(glm::mat4(1.0f), m_Positions[0].position);
@@ -102,7 +83,7 @@ glm::mat4 Bone::InterpolatePosition(float animationTime)
 	return glm::translate(glm::mat4(1.0f), finalPosition);
 }
 
-glm::mat4 Bone::InterpolateRotation(float animationTime)
+glm::mat4 Bone::InterpolateRotation(float animationTime) const
 {
 	if (1 == m_NumRotations)
 	{
@@ -121,7 +102,7 @@ glm::mat4 Bone::InterpolateRotation(float animationTime)
 
 }
 
-glm::mat4 Bone::InterpolateScaling(float animationTime)
+glm::mat4 Bone::InterpolateScaling(float animationTime) const
 {
 	if (1 == m_NumScalings)
 		return glm::scale(glm::mat4(1.0f), m_Scales[0].scale);
@@ -9,9 +9,9 @@
 #include <glm/gtx/quaternion.hpp>
 #include <assimp/scene.h>
 
-#include <string>
-#include <vector>
+#include <string_view>
 
+// Key layouts are stored as-is in cooked animation files
 struct KeyPosition
 {
 	glm::vec3 position;
@@ -33,38 +33,45 @@ struct KeyScale
 class Bone
 {
 public:
-	Bone(const std::string& name, int ID, const aiNodeAnim* channel);
+	Bone(std::string_view name, int ID,
+		const KeyPosition* positions, int numPositions,
+		const KeyRotation* rotations, int numRotations,
+		const KeyScale* scales, int numScales);
 
 	void Update(float animationTime);
+	// Local transform at animationTime without touching the bone, so animators
+	// sharing one Animation can evaluate it on different threads
+	glm::mat4 Sample(float animationTime) const;
 
 	glm::mat4 GetLocalTransform() { return m_LocalTransform; }
-	std::string GetBoneName() const { return m_Name; }
+	std::string_view GetBoneName() const { return m_Name; }
 	int GetBoneID() { return m_ID; }
 
-	int GetPositionIndex(float animationTime);
+	int GetPositionIndex(float animationTime) const;
 
-	int GetRotationIndex(float animationTime);
+	int GetRotationIndex(float animationTime) const;
 
-	int GetScaleIndex(float animationTime);
+	int GetScaleIndex(float animationTime) const;
 private:
-	std::vector<KeyPosition> m_Positions;
-	std::vector<KeyRotation> m_Rotations;
-	std::vector<KeyScale> m_Scales;
+	// Key streams are owned by the Animation
+	const KeyPosition* m_Positions;
+	const KeyRotation* m_Rotations;
+	const KeyScale* m_Scales;
 	int m_NumPositions;
 	int m_NumRotations;
 	int m_NumScalings;
 
 	glm::mat4 m_LocalTransform;
-	std::string m_Name;
+	std::string_view m_Name;
 	int m_ID;
 
-	float GetScaleFactor(float lastTimeStamp, float nextTimeStamp, float animationTime);
+	float GetScaleFactor(float lastTimeStamp, float nextTimeStamp, float animationTime) const;
 
-	glm::mat4 InterpolatePosition(float animationTime);
+	glm::mat4 InterpolatePosition(float animationTime) const;
 
-	glm::mat4 InterpolateRotation(float animationTime);
+	glm::mat4 InterpolateRotation(float animationTime) const;
 
-	glm::mat4 InterpolateScaling(float animationTime);
+	glm::mat4 InterpolateScaling(float animationTime) const;
 };
 
 #endif 
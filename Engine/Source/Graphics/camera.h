@@ -15,6 +15,7 @@ public:
 	void handleEvent(const std::vector<SDL_Event>& events, float deltaTime);
 
 	glm::mat4 getViewMatrix();
+	glm::vec3 getPosition() const { return m_position; }
 private:
 	glm::vec3 m_position;
 	glm::vec3 m_front;
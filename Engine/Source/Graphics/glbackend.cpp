@@ -0,0 +1,183 @@
+#include "glbackend.h"
+#include "glext.h"
+#include "nullgl.h"
+
+#include <glad/glad.h>
+#include <spdlog/spdlog.h>
+
+#include <cstring>
+
+// EGL ships with Mesa on Linux; elsewhere the Egl backend reports itself unsupported
+#if !defined(ENGINE_HAS_EGL)
+#if defined(__linux__)
+#define ENGINE_HAS_EGL 1
+#else
+#define ENGINE_HAS_EGL 0
+#endif
+#endif
+
+#if ENGINE_HAS_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+namespace {
+#if ENGINE_HAS_EGL
+    void* getEglProcAddress(const char* name) {
+        return reinterpret_cast<void*>(eglGetProcAddress(name));
+    }
+
+    // No window system at all, so no config and no surface: the context renders
+    // into framebuffer objects only
+    bool createEglContext(HeadlessContext& headless) {
+        auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+        if (!getPlatformDisplay) {
+            spdlog::error("EGL has no eglGetPlatformDisplayEXT");
+            return false;
+        }
+
+        EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        EGLint major = 0;
+        EGLint minor = 0;
+        if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)) {
+            spdlog::error("Failed to initialize a surfaceless EGL display: 0x{:x}", eglGetError());
+            return false;
+        }
+        if (!eglBindAPI(EGL_OPENGL_API)) {
+            spdlog::error("EGL cannot create desktop GL contexts");
+            eglTerminate(display);
+            return false;
+        }
+
+        const EGLint attributes[] = {
+            EGL_CONTEXT_MAJOR_VERSION, 4,
+            EGL_CONTEXT_MINOR_VERSION, 5,
+            EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+            EGL_NONE
+        };
+        EGLContext context = eglCreateContext(display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, attributes);
+        if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+            spdlog::error("Failed to create a GL 4.5 core EGL context: 0x{:x}", eglGetError());
+            if (context != EGL_NO_CONTEXT) {
+                eglDestroyContext(display, context);
+            }
+            eglTerminate(display);
+            return false;
+        }
+
+        headless.display = display;
+        headless.context = context;
+        spdlog::info("EGL {}.{} surfaceless context", major, minor);
+        return true;
+    }
+
+    void destroyEglContext(HeadlessContext& headless) {
+        EGLDisplay display = static_cast<EGLDisplay>(headless.display);
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglDestroyContext(display, static_cast<EGLContext>(headless.context));
+        eglTerminate(display);
+    }
+#endif
+
+    // What the window's default framebuffer would be: color and depth
+    bool createFramebuffer(HeadlessContext& headless, int width, int height) {
+        glGenRenderbuffers(1, &headless.colorBuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, headless.colorBuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+        glGenRenderbuffers(1, &headless.depthBuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, headless.depthBuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+        glGenFramebuffers(1, &headless.framebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, headless.framebuffer);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, headless.colorBuffer);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, headless.depthBuffer);
+        return glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    }
+}
+
+const char* getGLBackendName(GLBackend backend) {
+    switch (backend) {
+    case GLBackend::Egl:
+        return "egl";
+    case GLBackend::Null:
+        return "null";
+    default:
+        return "window";
+    }
+}
+
+bool parseGLBackend(const char* name, GLBackend& backend) {
+    for (GLBackend candidate : { GLBackend::Window, GLBackend::Egl, GLBackend::Null }) {
+        if (std::strcmp(name, getGLBackendName(candidate)) == 0) {
+            backend = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool initHeadlessContext(HeadlessContext& headless, GLBackend backend, int width, int height) {
+    GLADloadproc getProcAddress = nullptr;
+    if (backend == GLBackend::Egl) {
+#if ENGINE_HAS_EGL
+        if (!createEglContext(headless)) {
+            return false;
+        }
+        getProcAddress = getEglProcAddress;
+#else
+        spdlog::error("This build has no EGL backend");
+        return false;
+#endif
+    }
+    else if (backend == GLBackend::Null) {
+        if (!isNullGLSupported()) {
+            spdlog::error("The null GL backend is not supported on this platform");
+            return false;
+        }
+        getProcAddress = getNullGLProcAddress;
+    }
+    else {
+        spdlog::error("The window backend has no headless context");
+        return false;
+    }
+    headless.backend = backend;
+
+    if (!gladLoadGLLoader(getProcAddress)) {
+        spdlog::error("GLAD Init through the {} backend", getGLBackendName(backend));
+        shutdownHeadlessContext(headless);
+        return false;
+    }
+    loadGLExtensions(getProcAddress);
+
+    if (!createFramebuffer(headless, width, height)) {
+        spdlog::error("Failed to create a {}x{} offscreen framebuffer", width, height);
+        shutdownHeadlessContext(headless);
+        return false;
+    }
+
+    spdlog::info("Headless {} backend, {} {}x{}", getGLBackendName(backend),
+        reinterpret_cast<const char*>(glGetString(GL_RENDERER)), width, height);
+    return true;
+}
+
+void presentHeadlessFrame(const HeadlessContext& headless) {
+    if (headless.backend == GLBackend::Egl) {
+        glFinish();
+    }
+}
+
+void shutdownHeadlessContext(HeadlessContext& headless) {
+    if (headless.framebuffer != 0) {
+        glDeleteFramebuffers(1, &headless.framebuffer);
+        glDeleteRenderbuffers(1, &headless.colorBuffer);
+        glDeleteRenderbuffers(1, &headless.depthBuffer);
+    }
+#if ENGINE_HAS_EGL
+    if (headless.context) {
+        destroyEglContext(headless);
+    }
+#endif
+    headless = HeadlessContext{};
+}
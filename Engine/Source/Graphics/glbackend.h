@@ -0,0 +1,38 @@
+#pragma once
+#ifndef GL_BACKEND_H
+#define GL_BACKEND_H
+
+// Where GL comes from. Window is the SDL window and its context. The other two
+// need no display: Egl renders offscreen through a surfaceless EGL context
+// (Mesa llvmpipe on machines without a GPU), Null executes nothing at all and
+// only counts calls, see nullgl.h.
+enum class GLBackend {
+	Window,
+	Egl,
+	Null
+};
+
+const char* getGLBackendName(GLBackend backend);
+// "window", "egl" or "null"
+bool parseGLBackend(const char* name, GLBackend& backend);
+
+// Context and offscreen framebuffer of a backend without a window
+struct HeadlessContext {
+	GLBackend backend = GLBackend::Window;
+	void* display = nullptr; // EGLDisplay
+	void* context = nullptr; // EGLContext
+	unsigned int framebuffer = 0;
+	unsigned int colorBuffer = 0;
+	unsigned int depthBuffer = 0;
+};
+
+// Creates the context, loads glad and the extensions through it and leaves a
+// width x height framebuffer bound in place of the window's. Egl is only
+// available where the engine is built with EGL, see ENGINE_HAS_EGL.
+bool initHeadlessContext(HeadlessContext& headless, GLBackend backend, int width, int height);
+// Stands in for the buffer swap: waits for the frame so the next one does not
+// queue up behind it, like a swap would
+void presentHeadlessFrame(const HeadlessContext& headless);
+void shutdownHeadlessContext(HeadlessContext& headless);
+
+#endif
@@ -0,0 +1,93 @@
+#include "glext.h"
+
+#include <spdlog/spdlog.h>
+
+#include <cstring>
+
+GLExtensions gGLExt;
+
+namespace {
+    GLADloadproc gGetProcAddress = nullptr;
+
+    template <typename T>
+    T getProc(const char* name) {
+        return reinterpret_cast<T>(gGetProcAddress(name));
+    }
+
+    bool isVersionAtLeast(int major, int minor) {
+        return gGLExt.majorVersion > major || (gGLExt.majorVersion == major && gGLExt.minorVersion >= minor);
+    }
+}
+
+bool hasGLExtension(const char* name) {
+    int count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (int i = 0; i < count; i++) {
+        const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+        if (extension && std::strcmp(extension, name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void loadGLExtensions(GLADloadproc getProcAddress) {
+    gGetProcAddress = getProcAddress;
+    glGetIntegerv(GL_MAJOR_VERSION, &gGLExt.majorVersion);
+    glGetIntegerv(GL_MINOR_VERSION, &gGLExt.minorVersion);
+
+    if (isVersionAtLeast(4, 1) || hasGLExtension("GL_ARB_get_program_binary")) {
+        gGLExt.getProgramBinary = getProc<PFNGETPROGRAMBINARY>("glGetProgramBinary");
+        gGLExt.loadProgramBinary = getProc<PFNPROGRAMBINARY>("glProgramBinary");
+        gGLExt.programParameteri = getProc<PFNPROGRAMPARAMETERI>("glProgramParameteri");
+
+        // A driver may expose the API but support no binary formats at all
+        int formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        gGLExt.programBinary = gGLExt.getProgramBinary && gGLExt.loadProgramBinary && gGLExt.programParameteri && formats > 0;
+    }
+
+    if (hasGLExtension("GL_KHR_parallel_shader_compile")) {
+        gGLExt.maxShaderCompilerThreads = getProc<PFNMAXSHADERCOMPILERTHREADS>("glMaxShaderCompilerThreadsKHR");
+    }
+    else if (hasGLExtension("GL_ARB_parallel_shader_compile")) {
+        gGLExt.maxShaderCompilerThreads = getProc<PFNMAXSHADERCOMPILERTHREADS>("glMaxShaderCompilerThreadsARB");
+    }
+    gGLExt.parallelShaderCompile = gGLExt.maxShaderCompilerThreads != nullptr;
+    if (gGLExt.parallelShaderCompile) {
+        // Let the driver pick how many threads it compiles on
+        gGLExt.maxShaderCompilerThreads(0xFFFFFFFF);
+    }
+
+    if (isVersionAtLeast(4, 3) || hasGLExtension("GL_ARB_copy_image")) {
+        gGLExt.copyImageSubData = getProc<PFNCOPYIMAGESUBDATA>("glCopyImageSubData");
+    }
+    gGLExt.copyImage = gGLExt.copyImageSubData != nullptr;
+
+    if (isVersionAtLeast(4, 4) || hasGLExtension("GL_ARB_buffer_storage")) {
+        gGLExt.bufferStorage = getProc<PFNBUFFERSTORAGE>("glBufferStorage");
+    }
+    gGLExt.persistentMapping = gGLExt.bufferStorage != nullptr;
+
+    if (hasGLExtension("GL_ARB_bindless_texture")) {
+        gGLExt.getTextureHandle = getProc<PFNGETTEXTUREHANDLE>("glGetTextureHandleARB");
+        gGLExt.makeTextureHandleResident = getProc<PFNMAKETEXTUREHANDLERESIDENT>("glMakeTextureHandleResidentARB");
+        gGLExt.makeTextureHandleNonResident = getProc<PFNMAKETEXTUREHANDLENONRESIDENT>("glMakeTextureHandleNonResidentARB");
+    }
+    gGLExt.bindlessTexture = gGLExt.getTextureHandle && gGLExt.makeTextureHandleResident && gGLExt.makeTextureHandleNonResident;
+
+    GLint timestampBits = 0;
+    glGetQueryiv(GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &timestampBits);
+    gGLExt.timerQuery = timestampBits > 0;
+    gGLExt.pipelineStatisticsQuery = isVersionAtLeast(4, 6) || hasGLExtension("GL_ARB_pipeline_statistics_query");
+    gGLExt.textureCompressionS3tc = hasGLExtension("GL_EXT_texture_compression_s3tc");
+    gGLExt.textureCompressionBptc = isVersionAtLeast(4, 2) || hasGLExtension("GL_ARB_texture_compression_bptc");
+
+    spdlog::info("OpenGL {}.{}, program binaries {}, parallel shader compile {}, copy image {}, persistent mapping {}, bindless textures {}, timer queries {}, pipeline statistics {}, S3TC {}, BPTC {}",
+        gGLExt.majorVersion, gGLExt.minorVersion,
+        gGLExt.programBinary ? "supported" : "unsupported", gGLExt.parallelShaderCompile ? "supported" : "unsupported",
+        gGLExt.copyImage ? "supported" : "unsupported", gGLExt.persistentMapping ? "supported" : "unsupported",
+        gGLExt.bindlessTexture ? "supported" : "unsupported",
+        gGLExt.timerQuery ? "supported" : "unsupported", gGLExt.pipelineStatisticsQuery ? "supported" : "unsupported",
+        gGLExt.textureCompressionS3tc ? "supported" : "unsupported", gGLExt.textureCompressionBptc ? "supported" : "unsupported");
+}
@@ -0,0 +1,102 @@
+#pragma once
+#ifndef GLEXT_H
+#define GLEXT_H
+
+#include <glad/glad.h>
+
+// glad is generated for the 3.3 core profile. Entry points from later versions
+// and extensions are loaded here, and only used when the driver reports them.
+
+// GL 4.1 / ARB_get_program_binary
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+
+// KHR_parallel_shader_compile / ARB_parallel_shader_compile
+#ifndef GL_MAX_SHADER_COMPILER_THREADS_KHR
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#endif
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+// ARB_pipeline_statistics_query, core in 4.6
+#ifndef GL_VERTICES_SUBMITTED_ARB
+#define GL_VERTICES_SUBMITTED_ARB 0x82EE
+#define GL_PRIMITIVES_SUBMITTED_ARB 0x82EF
+#define GL_VERTEX_SHADER_INVOCATIONS_ARB 0x82F0
+#define GL_FRAGMENT_SHADER_INVOCATIONS_ARB 0x82F4
+#define GL_CLIPPING_OUTPUT_PRIMITIVES_ARB 0x82F7
+#endif
+
+// GL 4.4 / ARB_buffer_storage
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+
+typedef void (APIENTRYP PFNGETPROGRAMBINARY)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+typedef void (APIENTRYP PFNPROGRAMBINARY)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+typedef void (APIENTRYP PFNPROGRAMPARAMETERI)(GLuint program, GLenum pname, GLint value);
+typedef void (APIENTRYP PFNMAXSHADERCOMPILERTHREADS)(GLuint count);
+typedef void (APIENTRYP PFNCOPYIMAGESUBDATA)(GLuint srcName, GLenum srcTarget, GLint srcLevel, GLint srcX, GLint srcY, GLint srcZ,
+	GLuint dstName, GLenum dstTarget, GLint dstLevel, GLint dstX, GLint dstY, GLint dstZ, GLsizei srcWidth, GLsizei srcHeight, GLsizei srcDepth);
+typedef void (APIENTRYP PFNBUFFERSTORAGE)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+typedef GLuint64 (APIENTRYP PFNGETTEXTUREHANDLE)(GLuint texture);
+typedef void (APIENTRYP PFNMAKETEXTUREHANDLERESIDENT)(GLuint64 handle);
+typedef void (APIENTRYP PFNMAKETEXTUREHANDLENONRESIDENT)(GLuint64 handle);
+
+struct GLExtensions {
+	int majorVersion = 0;
+	int minorVersion = 0;
+
+	bool programBinary = false;
+	PFNGETPROGRAMBINARY getProgramBinary = nullptr;
+	PFNPROGRAMBINARY loadProgramBinary = nullptr;
+	PFNPROGRAMPARAMETERI programParameteri = nullptr;
+
+	// GL_COMPLETION_STATUS_KHR can be polled without waiting for the compiler
+	bool parallelShaderCompile = false;
+	PFNMAXSHADERCOMPILERTHREADS maxShaderCompilerThreads = nullptr;
+
+	// GL 4.3 / ARB_copy_image, GPU side copies between textures of the same format
+	bool copyImage = false;
+	PFNCOPYIMAGESUBDATA copyImageSubData = nullptr;
+
+	// GL 4.4 / ARB_buffer_storage, buffers that stay mapped while the GL reads them
+	bool persistentMapping = false;
+	PFNBUFFERSTORAGE bufferStorage = nullptr;
+
+	// Samplers from 64-bit handles stored in buffers, no texture units involved
+	bool bindlessTexture = false;
+	PFNGETTEXTUREHANDLE getTextureHandle = nullptr;
+	PFNMAKETEXTUREHANDLERESIDENT makeTextureHandleResident = nullptr;
+	PFNMAKETEXTUREHANDLENONRESIDENT makeTextureHandleNonResident = nullptr;
+
+	// GL_TIMESTAMP queries that actually count. The entry points are core 3.3,
+	// but a driver may report a zero bit counter.
+	bool timerQuery = false;
+	// Vertex, primitive and shader invocation counts through glBeginQuery
+	bool pipelineStatisticsQuery = false;
+
+	// BC1/BC3 uploads. Never core, though nearly every desktop driver has it.
+	bool textureCompressionS3tc = false;
+	// BC7 uploads, GL 4.2 / ARB_texture_compression_bptc. BC5 (RGTC) is core 3.0.
+	bool textureCompressionBptc = false;
+};
+
+extern GLExtensions gGLExt;
+
+// Call once after glad is loaded, on the context thread, with the loader of the
+// context's backend
+void loadGLExtensions(GLADloadproc getProcAddress);
+
+bool hasGLExtension(const char* name);
+
+#endif
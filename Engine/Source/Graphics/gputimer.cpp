@@ -0,0 +1,295 @@
+#include "gputimer.h"
+#include "glext.h"
+
+#include <glad/glad.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    constexpr int kStatisticCount = 5;
+    const GLenum kStatisticTargets[kStatisticCount] = {
+        GL_VERTICES_SUBMITTED_ARB,
+        GL_PRIMITIVES_SUBMITTED_ARB,
+        GL_VERTEX_SHADER_INVOCATIONS_ARB,
+        GL_CLIPPING_OUTPUT_PRIMITIVES_ARB,
+        GL_FRAGMENT_SHADER_INVOCATIONS_ARB,
+    };
+
+    // The GPU and CPU clocks drift apart, they are paired again this often
+    constexpr uint64_t kCalibrationFrames = 120;
+
+    struct GpuZoneQuery {
+        const char* name = nullptr;
+        int depth = 0;
+    };
+
+    // Queries of one frame in flight. Zone i writes queries 2i and 2i + 1; zone
+    // 0 spans the frame, so its end is the last timestamp written.
+    struct GpuTimerFrame {
+        GLuint queries[kMaxGpuZones * 2] = {};
+        GLuint statistics[kStatisticCount] = {};
+        GpuZoneQuery zones[kMaxGpuZones];
+        int zoneCount = 0;
+        bool pending = false;
+    };
+
+    struct GpuTimers {
+        GpuTimerDetail detail = GpuTimerDetail::Off;
+        bool pipelineStatistics = false;
+        GpuTimerFrame frames[kGpuTimerFrames];
+        int current = 0;
+        // Zone index per nesting level, -1 for zones past kMaxGpuZones
+        int open[kMaxGpuZones] = {};
+        int depth = 0;
+        uint64_t frameCount = 0;
+        uint64_t droppedFrames = 0;
+
+        ProfileTrack* track = nullptr;
+        GLint64 calibrationNanoseconds = 0;
+        uint64_t calibrationTicks = 0;
+
+        std::vector<GpuZoneTiming> timings;
+        float frameMilliseconds = 0.0f;
+        GpuPipelineStatistics statistics;
+    };
+
+    GpuTimers gGpuTimers;
+
+    void calibrate() {
+        glGetInteger64v(GL_TIMESTAMP, &gGpuTimers.calibrationNanoseconds);
+        gGpuTimers.calibrationTicks = getProfilerTicks();
+    }
+
+    bool isQueryAvailable(GLuint query) {
+        GLint available = 0;
+        glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+        return available != 0;
+    }
+
+    // False while the GPU is still working on the frame; never waits for it
+    bool resolveFrame(const GpuTimerFrame& frame) {
+        if (frame.zoneCount == 0 || !isQueryAvailable(frame.queries[1])) {
+            return false;
+        }
+        if (gGpuTimers.pipelineStatistics && !isQueryAvailable(frame.statistics[kStatisticCount - 1])) {
+            return false;
+        }
+
+        GLuint64 timestamps[kMaxGpuZones * 2];
+        for (int i = 0; i < frame.zoneCount * 2; i++) {
+            glGetQueryObjectui64v(frame.queries[i], GL_QUERY_RESULT, &timestamps[i]);
+        }
+
+        // Onto the profiler's clock, relative to the last pairing of the two
+        double ticksPerNanosecond = getProfilerTicksPerMicrosecond() / 1000.0;
+        auto toTicks = [&](GLuint64 nanoseconds) {
+            return gGpuTimers.calibrationTicks + uint64_t(double(GLint64(nanoseconds) - gGpuTimers.calibrationNanoseconds) * ticksPerNanosecond);
+        };
+
+        gGpuTimers.timings.clear();
+        for (int i = 0; i < frame.zoneCount; i++) {
+            GLuint64 begin = timestamps[i * 2];
+            GLuint64 end = std::max(timestamps[i * 2 + 1], begin);
+            float milliseconds = float(end - begin) / 1000000.0f;
+            gGpuTimers.timings.push_back({ frame.zones[i].name, frame.zones[i].depth, milliseconds });
+            recordProfileZone(gGpuTimers.track, frame.zones[i].name, toTicks(begin), toTicks(end));
+        }
+        gGpuTimers.frameMilliseconds = gGpuTimers.timings[0].milliseconds;
+
+        if (gGpuTimers.pipelineStatistics) {
+            GLuint64 counts[kStatisticCount];
+            for (int i = 0; i < kStatisticCount; i++) {
+                glGetQueryObjectui64v(frame.statistics[i], GL_QUERY_RESULT, &counts[i]);
+            }
+            GpuPipelineStatistics& statistics = gGpuTimers.statistics;
+            statistics.verticesSubmitted = counts[0];
+            statistics.primitivesSubmitted = counts[1];
+            statistics.vertexShaderInvocations = counts[2];
+            statistics.clippingOutputPrimitives = counts[3];
+            statistics.fragmentShaderInvocations = counts[4];
+        }
+        return true;
+    }
+
+    void openZone(const char* name) {
+        GpuTimerFrame& frame = gGpuTimers.frames[gGpuTimers.current];
+        int zone = -1;
+        if (frame.zoneCount < kMaxGpuZones) {
+            zone = frame.zoneCount++;
+            frame.zones[zone].name = name;
+            frame.zones[zone].depth = gGpuTimers.depth;
+            glQueryCounter(frame.queries[zone * 2], GL_TIMESTAMP);
+        }
+        gGpuTimers.open[gGpuTimers.depth++] = zone;
+    }
+}
+
+const char* getGpuTimerDetailName(GpuTimerDetail detail) {
+    switch (detail) {
+    case GpuTimerDetail::Passes:
+        return "passes";
+    case GpuTimerDetail::DrawGroups:
+        return "draws";
+    default:
+        return "off";
+    }
+}
+
+bool parseGpuTimerDetail(const char* name, GpuTimerDetail& detail) {
+    for (GpuTimerDetail candidate : { GpuTimerDetail::Off, GpuTimerDetail::Passes, GpuTimerDetail::DrawGroups }) {
+        if (std::strcmp(name, getGpuTimerDetailName(candidate)) == 0) {
+            detail = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+GpuTimerDetail initGpuTimers(GpuTimerDetail detail, bool pipelineStatistics) {
+    if (detail != GpuTimerDetail::Off && !gGLExt.timerQuery) {
+        spdlog::warn("Timer queries are not supported, GPU zones are off");
+        detail = GpuTimerDetail::Off;
+    }
+    if (detail == GpuTimerDetail::Off) {
+        return detail;
+    }
+    if (pipelineStatistics && !gGLExt.pipelineStatisticsQuery) {
+        spdlog::warn("Pipeline statistics queries are not supported");
+        pipelineStatistics = false;
+    }
+
+    gGpuTimers.detail = detail;
+    gGpuTimers.pipelineStatistics = pipelineStatistics;
+    for (GpuTimerFrame& frame : gGpuTimers.frames) {
+        glGenQueries(kMaxGpuZones * 2, frame.queries);
+        if (pipelineStatistics) {
+            glGenQueries(kStatisticCount, frame.statistics);
+        }
+    }
+    gGpuTimers.timings.reserve(kMaxGpuZones);
+    if (!gGpuTimers.track) {
+        gGpuTimers.track = createProfilerTrack("GPU");
+    }
+    calibrate();
+
+    spdlog::info("GPU timers: {}, pipeline statistics {}", getGpuTimerDetailName(detail), pipelineStatistics ? "on" : "off");
+    return detail;
+}
+
+void shutdownGpuTimers() {
+    if (gGpuTimers.detail == GpuTimerDetail::Off) {
+        return;
+    }
+    if (gGpuTimers.droppedFrames > 0) {
+        spdlog::info("GPU timers dropped {} of {} frames that were still in flight", gGpuTimers.droppedFrames, gGpuTimers.frameCount);
+    }
+    for (GpuTimerFrame& frame : gGpuTimers.frames) {
+        glDeleteQueries(kMaxGpuZones * 2, frame.queries);
+        if (gGpuTimers.pipelineStatistics) {
+            glDeleteQueries(kStatisticCount, frame.statistics);
+        }
+    }
+    // The track stays registered with the profiler, a later init writes to it again
+    ProfileTrack* track = gGpuTimers.track;
+    gGpuTimers = GpuTimers{};
+    gGpuTimers.track = track;
+}
+
+GpuTimerDetail getGpuTimerDetail() {
+    return gGpuTimers.detail;
+}
+
+void beginGpuFrame() {
+    if (gGpuTimers.detail == GpuTimerDetail::Off) {
+        return;
+    }
+
+    // Oldest first, and the first one still busy means the newer ones are too
+    for (int i = 1; i <= kGpuTimerFrames; i++) {
+        GpuTimerFrame& frame = gGpuTimers.frames[(gGpuTimers.current + i) % kGpuTimerFrames];
+        if (!frame.pending) {
+            continue;
+        }
+        if (!resolveFrame(frame)) {
+            break;
+        }
+        frame.pending = false;
+    }
+
+    if (gGpuTimers.frameCount % kCalibrationFrames == 0) {
+        calibrate();
+    }
+    gGpuTimers.frameCount++;
+
+    // A GPU more than kGpuTimerFrames behind costs the oldest results, not a stall
+    gGpuTimers.current = (gGpuTimers.current + 1) % kGpuTimerFrames;
+    GpuTimerFrame& frame = gGpuTimers.frames[gGpuTimers.current];
+    if (frame.pending) {
+        gGpuTimers.droppedFrames++;
+        frame.pending = false;
+    }
+    frame.zoneCount = 0;
+    gGpuTimers.depth = 0;
+
+    if (gGpuTimers.pipelineStatistics) {
+        for (int i = 0; i < kStatisticCount; i++) {
+            glBeginQuery(kStatisticTargets[i], frame.statistics[i]);
+        }
+    }
+    openZone("GPU frame");
+}
+
+void endGpuFrame() {
+    if (gGpuTimers.detail == GpuTimerDetail::Off) {
+        return;
+    }
+
+    // Closes anything left open, the frame zone last
+    while (gGpuTimers.depth > 0) {
+        endGpuZone();
+    }
+    GpuTimerFrame& frame = gGpuTimers.frames[gGpuTimers.current];
+    if (gGpuTimers.pipelineStatistics) {
+        for (int i = 0; i < kStatisticCount; i++) {
+            glEndQuery(kStatisticTargets[i]);
+        }
+    }
+    frame.pending = frame.zoneCount > 0;
+}
+
+void beginGpuZone(const char* name) {
+    // Outside a frame the queries would land in one that is already in flight
+    if (gGpuTimers.depth == 0 || gGpuTimers.depth >= kMaxGpuZones) {
+        return;
+    }
+    openZone(name);
+}
+
+void endGpuZone() {
+    if (gGpuTimers.depth == 0) {
+        return;
+    }
+
+    int zone = gGpuTimers.open[--gGpuTimers.depth];
+    if (zone >= 0) {
+        glQueryCounter(gGpuTimers.frames[gGpuTimers.current].queries[zone * 2 + 1], GL_TIMESTAMP);
+    }
+}
+
+const std::vector<GpuZoneTiming>& getGpuZoneTimings() {
+    return gGpuTimers.timings;
+}
+
+float getGpuFrameMilliseconds() {
+    return gGpuTimers.frameMilliseconds;
+}
+
+const GpuPipelineStatistics& getGpuPipelineStatistics() {
+    return gGpuTimers.statistics;
+}
+
+uint64_t getDroppedGpuFrameCount() {
+    return gGpuTimers.droppedFrames;
+}
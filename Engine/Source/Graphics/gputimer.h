@@ -0,0 +1,85 @@
+#pragma once
+#ifndef GPU_TIMER_H
+#define GPU_TIMER_H
+
+#include "Core/profiler.h"
+
+#include <cstdint>
+#include <vector>
+
+// GPU time per render pass from GL_TIMESTAMP queries. Each frame writes its
+// queries into one of kGpuTimerFrames sets and reads back the oldest set only
+// once the driver reports it done, so nothing ever waits on the GPU. Results
+// land a few frames late on a "GPU" track of the CPU profiler, and in
+// getGpuZoneTimings. Without timer queries (the null backend, drivers with a
+// zero bit counter) every call here does nothing.
+constexpr int kGpuTimerFrames = 3;
+// Zones past this in one frame are not timed
+constexpr int kMaxGpuZones = 64;
+
+enum class GpuTimerDetail {
+	Off,
+	Passes,
+	// Also every run of draws that share a program
+	DrawGroups
+};
+
+const char* getGpuTimerDetailName(GpuTimerDetail detail);
+// "off", "passes" or "draws"
+bool parseGpuTimerDetail(const char* name, GpuTimerDetail& detail);
+
+// Vertex and fragment work of a whole frame, ARB_pipeline_statistics_query
+struct GpuPipelineStatistics {
+	uint64_t verticesSubmitted = 0;
+	uint64_t primitivesSubmitted = 0;
+	uint64_t vertexShaderInvocations = 0;
+	uint64_t clippingOutputPrimitives = 0;
+	uint64_t fragmentShaderInvocations = 0;
+};
+
+struct GpuZoneTiming {
+	const char* name = nullptr;
+	int depth = 0;
+	float milliseconds = 0.0f;
+};
+
+// After loadGLExtensions. Returns the detail actually in effect, Off when the
+// driver cannot time anything.
+GpuTimerDetail initGpuTimers(GpuTimerDetail detail, bool pipelineStatistics);
+void shutdownGpuTimers();
+GpuTimerDetail getGpuTimerDetail();
+
+// Around everything a frame renders, before present
+void beginGpuFrame();
+void endGpuFrame();
+
+// Nestable, between beginGpuFrame and endGpuFrame. name must outlive the
+// profiler, as for PROFILE_ZONE.
+void beginGpuZone(const char* name);
+void endGpuZone();
+
+class GpuZone {
+public:
+	explicit GpuZone(const char* name) { beginGpuZone(name); }
+	~GpuZone() { endGpuZone(); }
+
+	GpuZone(const GpuZone&) = delete;
+	GpuZone& operator=(const GpuZone&) = delete;
+};
+
+// The newest frame whose queries have come back, outermost zone first.
+// Empty until one has.
+const std::vector<GpuZoneTiming>& getGpuZoneTimings();
+float getGpuFrameMilliseconds();
+// Zero unless enabled and supported
+const GpuPipelineStatistics& getGpuPipelineStatistics();
+// Frames whose results were still outstanding when their query set came round again
+uint64_t getDroppedGpuFrameCount();
+
+#if ENGINE_PROFILER
+#define PROFILE_GPU_ZONE(name) GpuZone PROFILE_CONCAT(gpuZone, __LINE__)(name)
+#else
+#define PROFILE_GPU_ZONE(name) ((void)0)
+#endif
+
+#endif
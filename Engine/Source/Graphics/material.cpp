@@ -0,0 +1,71 @@
+#include "material.h"
+#include "texture.h"
+
+#include "Core/hash.h"
+
+#include <glad/glad.h>
+
+static_assert(sizeof(MaterialParams) == 48, "MaterialParams must match the std140 MaterialBlock, bump kCookedModelVersion");
+static_assert(sizeof(MaterialBlock) == 96, "MaterialBlock must match the std140 MaterialBlock in Include/material.glsl");
+
+MaterialSlot getMaterialSlot(const std::string& textureType) {
+    if (textureType == "texture_diffuse") {
+        return MaterialSlot::Diffuse;
+    }
+    if (textureType == "texture_specular") {
+        return MaterialSlot::Specular;
+    }
+    if (textureType == "texture_normal") {
+        return MaterialSlot::Normal;
+    }
+    if (textureType == "texture_height") {
+        return MaterialSlot::Height;
+    }
+    return MaterialSlot::Count;
+}
+
+AssetId makeMaterialId(const MaterialDesc& desc, const AssetId (&textureIds)[kMaterialSlotCount]) {
+    uint64_t id = hash64(getShaderDefinesText(desc.defines));
+    id = hashCombine(id, hash64(textureIds, sizeof(textureIds)));
+    return hashCombine(id, hash64(&desc.params, sizeof(desc.params)));
+}
+
+void setMaterialTexture(Material& material, MaterialSlot slot, Texture& texture) {
+    uint32_t index = static_cast<uint32_t>(slot);
+    if (makeTextureIndexable(texture)) {
+        if (texture.bindlessHandle != 0) {
+            material.block.handles[index] = texture.bindlessHandle;
+            return;
+        }
+        if (texture.layer >= 0) {
+            material.block.layers[index] = (uint32_t(texture.page) << 16) | uint32_t(texture.layer);
+            return;
+        }
+    }
+    material.textureIds[index] = texture.id;
+}
+
+void uploadMaterial(Material& material) {
+    glGenBuffers(1, &material.ubo);
+    glBindBuffer(GL_UNIFORM_BUFFER, material.ubo);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(MaterialBlock), &material.block, GL_STATIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void bindMaterial(const Material& material) {
+    glBindBufferBase(GL_UNIFORM_BUFFER, kMaterialBlockBinding, material.ubo);
+    // Empty and indexed slots keep whatever is bound, the shader never samples them
+    for (uint32_t slot = 0; slot < kMaterialSlotCount; slot++) {
+        if (material.textureIds[slot] != 0) {
+            glActiveTexture(GL_TEXTURE0 + slot);
+            glBindTexture(GL_TEXTURE_2D, material.textureIds[slot]);
+        }
+    }
+}
+
+void destroyMaterialBuffer(Material& material) {
+    if (material.ubo != 0) {
+        glDeleteBuffers(1, &material.ubo);
+        material.ubo = 0;
+    }
+}
@@ -0,0 +1,81 @@
+#pragma once
+#ifndef MATERIAL_H
+#define MATERIAL_H
+
+#include "Asset/handle.h"
+#include "Asset/shadersource.h"
+#include "Graphics/texturepages.h"
+
+#include <glm/vec4.hpp>
+
+#include <cstdint>
+#include <string>
+
+struct Texture;
+struct ShaderProgram;
+
+// Texture units, fixed with layout(binding) in Include/material.glsl
+enum class MaterialSlot : uint32_t {
+	Diffuse,
+	Specular,
+	Normal,
+	Height,
+	Count
+};
+
+constexpr uint32_t kMaterialSlotCount = static_cast<uint32_t>(MaterialSlot::Count);
+// Uniform buffer binding of the MaterialBlock in Include/material.glsl
+constexpr unsigned int kMaterialBlockBinding = 0;
+
+// "texture_diffuse" and friends, as stored in models. Count for anything else.
+MaterialSlot getMaterialSlot(const std::string& textureType);
+
+// std140 layout of the MaterialBlock uniform block, stored as-is in cooked models
+struct MaterialParams {
+	glm::vec4 baseColor = glm::vec4(1.0f);  // rgb and opacity, used where there is no diffuse map
+	glm::vec4 specular = glm::vec4(0.0f);   // rgb and shininess
+	uint32_t mapMask = 0;                   // bit per MaterialSlot that has a texture
+	uint32_t padding[3] = { 0, 0, 0 };
+};
+
+// Everything the shader reads per material, the whole std140 MaterialBlock.
+// Slots served from a texture page or a bindless handle need no unit.
+struct MaterialBlock {
+	MaterialParams params;
+	uint32_t layers[kMaterialSlotCount] = { kUnpackedLayer, kUnpackedLayer, kUnpackedLayer, kUnpackedLayer }; // page << 16 | layer
+	uint64_t handles[kMaterialSlotCount] = {}; // bindless, 0 where the slot reads its unit
+};
+
+// Shader permutation, textures and parameters. Materials are deduplicated by
+// content, so meshes that look the same share one and the renderer binds it once.
+struct Material {
+	ShaderDefines defines;
+	Handle<ShaderProgram> program;
+	Handle<ShaderProgram> skinnedProgram;
+	Handle<Texture> textures[kMaterialSlotCount];
+	unsigned int textureIds[kMaterialSlotCount] = {}; // GL names of slots bound to units, 0 for the rest
+	MaterialBlock block;
+	unsigned int ubo = 0;
+};
+
+// What a material is made of, before it is deduplicated
+struct MaterialDesc {
+	ShaderDefines defines;
+	Handle<Texture> textures[kMaterialSlotCount];
+	MaterialParams params;
+};
+
+// Stable across runs: hashes the defines, the texture asset IDs and the parameters
+AssetId makeMaterialId(const MaterialDesc& desc, const AssetId (&textureIds)[kMaterialSlotCount]);
+
+// Puts the texture in a slot: a page layer or bindless handle when the texture
+// binding mode allows it, its unit otherwise
+void setMaterialTexture(Material& material, MaterialSlot slot, Texture& texture);
+// Creates the parameter buffer. GL thread only.
+void uploadMaterial(Material& material);
+// Binds the parameter block and the slots that still use texture units
+void bindMaterial(const Material& material);
+// Deletes the parameter buffer. Texture and program references are the owner's to drop.
+void destroyMaterialBuffer(Material& material);
+
+#endif
@@ -1,8 +1,36 @@
 #include "mesh.h"
 
 #include <glad/glad.h>
+#include <glm/geometric.hpp>
 
-Mesh setupMesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices) {
+#include <cmath>
+#include <cstring>
+
+namespace {
+    void measureMesh(const Vertex* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount, Mesh& mesh) {
+        if (vertexCount == 0) {
+            return;
+        }
+
+        mesh.boundsMin = mesh.boundsMax = vertices[0].position;
+        for (size_t i = 1; i < vertexCount; i++) {
+            mesh.boundsMin = glm::min(mesh.boundsMin, vertices[i].position);
+            mesh.boundsMax = glm::max(mesh.boundsMax, vertices[i].position);
+        }
+
+        for (size_t i = 0; i + 2 < indexCount; i += 3) {
+            const Vertex& a = vertices[indices[i]];
+            const Vertex& b = vertices[indices[i + 1]];
+            const Vertex& c = vertices[indices[i + 2]];
+            glm::vec2 uvB = b.texCoords - a.texCoords;
+            glm::vec2 uvC = c.texCoords - a.texCoords;
+            mesh.surfaceArea += 0.5f * glm::length(glm::cross(b.position - a.position, c.position - a.position));
+            mesh.uvArea += 0.5f * std::abs(uvB.x * uvC.y - uvB.y * uvC.x);
+        }
+    }
+}
+
+Mesh setupMesh(const Vertex* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount, bool retainCpuData) {
     Mesh mesh;
     //-----------------------------------------------------------------------------
     // Create buffers/arrays
@@ -14,12 +42,12 @@ Mesh setupMesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices)
     // Generate and bind the Vertex Buffer Object
     glGenBuffers(1, &mesh.vbo);
     glBindBuffer(GL_ARRAY_BUFFER, mesh.vbo);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(Vertex), vertices, GL_STATIC_DRAW);
 
     // Generate and bind the Element Buffer Object
     glGenBuffers(1, &mesh.ebo);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.ebo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(unsigned int), indices, GL_STATIC_DRAW);
 
     //-----------------------------------------------------------------------------
     // Set vertex attributes pointers 
@@ -43,8 +71,23 @@ Mesh setupMesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices)
     // Unbind VAO
     glBindVertexArray(0);
 
-    mesh.vertices = vertices;
-    mesh.indices = indices;
+    mesh.vertexCount = (uint32_t)vertexCount;
+    mesh.indexCount = (uint32_t)indexCount;
+    if (retainCpuData) {
+        // Vertex is a multiple of 4 bytes, so the indices after it stay aligned
+        size_t vertexBytes = vertexCount * sizeof(Vertex);
+        mesh.cpuData.reset(new unsigned char[vertexBytes + indexCount * sizeof(unsigned int)]);
+        std::memcpy(mesh.cpuData.get(), vertices, vertexBytes);
+        std::memcpy(mesh.cpuData.get() + vertexBytes, indices, indexCount * sizeof(unsigned int));
+    }
+    measureMesh(vertices, vertexCount, indices, indexCount, mesh);
 
     return mesh;
-}
\ No newline at end of file
+}
+
+void destroyMesh(Mesh& mesh) {
+    glDeleteVertexArrays(1, &mesh.vao);
+    glDeleteBuffers(1, &mesh.vbo);
+    glDeleteBuffers(1, &mesh.ebo);
+    mesh.vao = mesh.vbo = mesh.ebo = 0;
+}
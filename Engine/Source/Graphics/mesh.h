@@ -7,8 +7,11 @@
 #include <glm/vec4.hpp>
 #include <spdlog/spdlog.h>
 
-#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 
+// Stored as-is in cooked model files, so any layout change needs a cook version bump
 struct Vertex {
 	glm::vec3 position;
 	glm::vec3 color;
@@ -19,12 +22,27 @@ struct Vertex {
 	float boneWeights[4] = { 0.0f, 0.0f, 0.0f, 0.0f }; // (skinning)
 };
 
+// What drawing needs: the GL objects and counts. The vertices and indices only
+// stay in CPU memory when asked for, e.g. for collision, picking or CPU skinning.
 struct Mesh {
-	unsigned int vao, vbo, ebo;
-	std::vector<Vertex> vertices;
-	std::vector<unsigned int> indices;
+	unsigned int vao = 0, vbo = 0, ebo = 0;
+	uint32_t vertexCount = 0;
+	uint32_t indexCount = 0;
+	std::unique_ptr<unsigned char[]> cpuData; // vertices then indices in one block, null unless retained
+	uint32_t materialIndex = 0; // into Model::materials
+
+	// Bind pose bounds and triangle areas, texture streaming estimates screen size from these
+	glm::vec3 boundsMin = glm::vec3(0.0f);
+	glm::vec3 boundsMax = glm::vec3(0.0f);
+	float surfaceArea = 0.0f;
+	float uvArea = 0.0f;
+
+	bool hasCpuData() const { return cpuData != nullptr; }
+	const Vertex* getVertices() const { return reinterpret_cast<const Vertex*>(cpuData.get()); }
+	const unsigned int* getIndices() const { return cpuData ? reinterpret_cast<const unsigned int*>(cpuData.get() + vertexCount * sizeof(Vertex)) : nullptr; }
 };
 
-Mesh setupMesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices);
+Mesh setupMesh(const Vertex* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount, bool retainCpuData = false);
+void destroyMesh(Mesh& mesh);
 
 #endif
\ No newline at end of file
@@ -2,6 +2,10 @@
 #include "util.h"
 
 #include "Asset/asset.h"
+#include "Asset/assimpio.h"
+#include "Core/filequeue.h"
+#include "Core/jobs.h"
+#include "Core/profiler.h"
 #include "Graphics/mesh.h"
 
 #include <glad/glad.h>
@@ -10,24 +14,361 @@
 #include <spdlog/spdlog.h>
 #include <stb_image.h>
 
-void processNode(aiNode* node, const aiScene* scene, Model& model) {
+#include <algorithm>
+#include <cmath>
+#include <unordered_set>
+
+bool importModel(const std::string& filePath, ModelData& model) {
+    PROFILE_ZONE("importModel");
+    Assimp::Importer importer;
+    importer.SetIOHandler(new MappedIOSystem);
+    importer.SetPropertyBool(AI_CONFIG_IMPORT_FBX_PRESERVE_PIVOTS, false);
+
+    unsigned flags = aiProcess_Triangulate | aiProcess_SortByPType | aiProcess_JoinIdenticalVertices |
+        aiProcess_FixInfacingNormals | aiProcess_GenUVCoords | aiProcess_OptimizeMeshes;
+
+    const aiScene* scene = importer.ReadFile(filePath, flags);
+
+    if (scene == nullptr) {
+        spdlog::error("Assimp Import Error (null scene): {}", importer.GetErrorString());
+        return false;
+    }
+
+    if (scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE) {
+        std::string const errorString = importer.GetErrorString();
+
+        if (!errorString.empty()) {
+            spdlog::error("Assimp Import Error (incomplete scene): {}", importer.GetErrorString());
+            return false;
+        }
+        spdlog::warn("Assimp flagged incomplete scene");
+    }
+
+    if (scene->mRootNode == nullptr) {
+        spdlog::error("No root node for model, cannot process");
+        return false;
+    }
+
+    model.path = filePath;
+    model.directory = filePath.substr(0, filePath.find_last_of("/\\"));
+
+    // Materials and bone IDs are shared across meshes, so they are registered
+    // in node order first; then each mesh converts on its own job
+    std::vector<const aiMesh*> meshes;
+    processNode(scene->mRootNode, scene, model, meshes);
+
+    // Each scene material is loaded once, by the first mesh that uses it
+    std::vector<int> materials(scene->mNumMaterials, -1);
+    model.meshes.resize(meshes.size());
+    for (size_t i = 0; i < meshes.size(); i++) {
+        int& material = materials[meshes[i]->mMaterialIndex];
+        if (material < 0) {
+            material = (int)loadMaterial(scene->mMaterials[meshes[i]->mMaterialIndex], scene, model);
+        }
+        model.meshes[i].material = (uint32_t)material;
+    }
+
+    parallelFor(gJobs, meshes.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            processMesh(meshes[i], model, model.meshes[i]);
+        }
+    });
+
+    return true;
+}
+
+void uploadModel(const ModelData& data, Model& model, bool retainMeshData) {
+    uploadMeshes(data, model, retainMeshData);
+
+    std::vector<TextureSource> sources = getTextureSources(data);
+    uploadModelMaterials(sources, data.materials, model);
+}
+
+void uploadMeshes(const ModelData& data, Model& model, bool retainMeshData) {
+    model.path = data.path;
+    model.directory = data.directory;
+    model.m_BoneInfoMap = data.m_BoneInfoMap;
+    model.m_BoneCounter = data.m_BoneCounter;
+
+    model.retainsMeshData = retainMeshData;
+    model.meshes.reserve(data.meshes.size());
+    for (const MeshData& mesh : data.meshes) {
+        model.meshes.push_back(setupMesh(mesh.vertices.data(), mesh.vertices.size(), mesh.indices.data(), mesh.indices.size(), retainMeshData));
+        model.meshes.back().materialIndex = mesh.material;
+    }
+    updateModelBounds(model);
+}
+
+std::vector<TextureSource> getTextureSources(const ModelData& data) {
+    // Repeated embedded textures only carry their bytes on the first reference
+    std::unordered_map<AssetId, const TextureRef*> embedded;
+    for (const TextureRef& ref : data.textures) {
+        if (ref.path.empty() && !ref.embedded.empty()) {
+            embedded.emplace(ref.id, &ref);
+        }
+    }
+
+    std::vector<TextureSource> sources(data.textures.size());
+    for (size_t i = 0; i < data.textures.size(); i++) {
+        const TextureRef& ref = data.textures[i];
+        sources[i].id = ref.id;
+        sources[i].type = ref.type;
+        sources[i].path = ref.path;
+        sources[i].width = ref.width;
+        sources[i].height = ref.height;
+
+        if (ref.path.empty()) {
+            auto it = embedded.find(ref.id);
+            if (it != embedded.end()) {
+                sources[i].data = it->second->embedded.data();
+                sources[i].size = it->second->embedded.size();
+            }
+        }
+    }
+    return sources;
+}
+
+void decodeTextureSources(std::vector<TextureSource>& sources) {
+    std::unordered_set<AssetId> decoded;
+    std::vector<TextureSource*> uncooked;
+    for (TextureSource& source : sources) {
+        // Every reference to the same image resolves to one upload, decode it once
+        if (!decoded.insert(source.id).second) {
+            continue;
+        }
+
+        if (!source.path.empty()) {
+            auto cooked = std::make_shared<CookedImage>();
+            if (openCookedTexture(source.path, *cooked)) {
+                source.cooked = std::move(cooked);
+            }
+            else {
+                uncooked.push_back(&source);
+            }
+        }
+        else if (source.height == 0) { // Compressed texture
+            loadImageFromMemory(source.data, source.size, 4, source.image);
+        }
+    }
+
+    // Source images are read as one batch so the disk sees all of them at once
+    std::vector<std::string> paths;
+    for (TextureSource* source : uncooked) {
+        paths.push_back(source->path);
+    }
+    std::vector<std::string> contents;
+    std::vector<FileError> errors = readFilesBlocking(gFileReads, paths, contents);
+    for (size_t i = 0; i < uncooked.size(); i++) {
+        TextureSource& source = *uncooked[i];
+        if (errors[i] != FileError::None) {
+            spdlog::error("Failed to read texture {}: {}", source.path, getFileErrorName(errors[i]));
+            continue;
+        }
+        if (loadImageFromMemory(reinterpret_cast<const unsigned char*>(contents[i].data()), contents[i].size(), 0, source.image)) {
+            expandToRgba(source.image);
+        }
+        contents[i] = {};
+    }
+}
+
+namespace {
+    Handle<Texture> addEmbeddedTexture(Assets& assets, AssetId id, const std::string& name, const TextureSource& source) {
+        unsigned int textureID = 0;
+        int width = source.width;
+        int height = source.height;
+        int channels = 4;
+
+        if (source.image.pixels) {
+            textureID = uploadImage(source.image);
+            width = source.image.width;
+            height = source.image.height;
+            channels = source.image.channels;
+        }
+        else if (source.height == 0) { // Compressed texture
+            Image image;
+            if (loadImageFromMemory(source.data, source.size, 4, image)) {
+                textureID = uploadImage(image);
+                width = image.width;
+                height = image.height;
+                channels = image.channels;
+            }
+        }
+        else { // Uncompressed texture
+            textureID = uploadTexture2D(source.data, source.width, source.height, 4);
+        }
+
+        if (textureID == 0) {
+            spdlog::error("Failed to load embedded texture");
+            return {};
+        }
+
+        auto texture = std::make_unique<Texture>();
+        texture->id = textureID;
+        texture->type = source.type;
+        texture->width = width;
+        texture->height = height;
+        texture->channels = channels;
+
+        spdlog::info("Embedded texture loaded");
+        assets.stats.texturesUploaded++;
+
+        AssetMemory memory;
+        memory.gpuBytes = getTextureMemory(width, height, channels);
+        return assets.textures.add(id, name, std::move(texture), memory);
+    }
+}
+
+void uploadModelMaterials(std::vector<TextureSource>& sources, const std::vector<MaterialRef>& materials, Model& model) {
+    // Handles stay invalid for textures that failed, their slots are left empty
+    std::vector<Handle<Texture>> textures(sources.size());
+    for (size_t i = 0; i < sources.size(); i++) {
+        TextureSource& source = sources[i];
+        // External textures are keyed by normalized path, embedded ones by content,
+        // so anything already uploaded this process is shared
+        std::string name = source.path.empty() ? fmt::format("{}#{:016x}", normalizePath(model.path), source.id) : normalizePath(source.path);
+        Handle<Texture> handle = gAssets.textures.find(source.id, name);
+        if (handle.isValid()) {
+            gAssets.stats.duplicateTexturesAvoided++;
+        }
+        else if (source.cooked) {
+            handle = addCookedTexture(gAssets, source.path, source.type, source.cooked);
+        }
+        else if (!source.path.empty()) {
+            handle = source.image.pixels ? addTexture(gAssets, source.path, source.type, source.image) : loadTexture(gAssets, source.path, source.type);
+        }
+        else {
+            handle = addEmbeddedTexture(gAssets, source.id, name, source);
+        }
+
+        textures[i] = handle;
+    }
+
+    // Materials take their own references on the textures, the model only
+    // references the materials
+    for (const MaterialRef& ref : materials) {
+        MaterialDesc desc;
+        desc.params = ref.params;
+        desc.params.mapMask = 0;
+        for (uint32_t i = ref.firstTexture; i < ref.firstTexture + ref.textureCount && i < sources.size(); i++) {
+            uint32_t slot = static_cast<uint32_t>(getMaterialSlot(sources[i].type));
+            // The first texture of a kind wins the slot
+            if (slot < kMaterialSlotCount && !desc.textures[slot].isValid() && gAssets.textures.contains(textures[i])) {
+                desc.textures[slot] = textures[i];
+                desc.params.mapMask |= 1u << slot;
+            }
+        }
+
+        Handle<Material> handle = addMaterial(gAssets, desc);
+        gAssets.materials.addRef(handle);
+        model.materials.push_back(handle);
+    }
+
+    for (Mesh& mesh : model.meshes) {
+        if (mesh.materialIndex >= model.materials.size()) {
+            mesh.materialIndex = 0;
+        }
+    }
+}
+
+void updateModelBounds(Model& model) {
+    if (model.meshes.empty()) {
+        return;
+    }
+
+    glm::vec3 boundsMin = model.meshes[0].boundsMin;
+    glm::vec3 boundsMax = model.meshes[0].boundsMax;
+    float surfaceArea = 0.0f;
+    float uvArea = 0.0f;
+    for (const Mesh& mesh : model.meshes) {
+        boundsMin = glm::min(boundsMin, mesh.boundsMin);
+        boundsMax = glm::max(boundsMax, mesh.boundsMax);
+        surfaceArea += mesh.surfaceArea;
+        uvArea += mesh.uvArea;
+    }
+
+    model.boundsCenter = (boundsMin + boundsMax) * 0.5f;
+    model.boundsRadius = glm::length(boundsMax - boundsMin) * 0.5f;
+    model.worldUnitsPerUv = uvArea > 0.0f ? std::sqrt(surfaceArea / uvArea) : 0.0f;
+}
+
+AssetMemory getModelMemory(const Model& model) {
+    AssetMemory memory;
+    for (const Mesh& mesh : model.meshes) {
+        size_t bytes = size_t(mesh.vertexCount) * sizeof(Vertex) + size_t(mesh.indexCount) * sizeof(unsigned int);
+        memory.gpuBytes += bytes;
+        if (mesh.hasCpuData()) {
+            memory.cpuBytes += bytes;
+        }
+    }
+    for (const auto& [name, info] : model.m_BoneInfoMap) {
+        memory.cpuBytes += name.size() + sizeof(BoneInfo);
+    }
+    return memory;
+}
+
+void destroyModel(Assets& assets, Model& model) {
+    for (Mesh& mesh : model.meshes) {
+        destroyMesh(mesh);
+    }
+    model.meshes.clear();
+
+    for (Handle<Material> handle : model.materials) {
+        assets.materials.release(handle);
+    }
+    model.materials.clear();
+}
+
+void processNode(aiNode* node, const aiScene* scene, ModelData& model, std::vector<const aiMesh*>& meshes) {
     for (unsigned int i = 0; i < node->mNumMeshes; i++) {
-        aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-        model.meshes.push_back(processMesh(mesh, scene, model));
+        const aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
+        RegisterMeshBones(model, mesh);
+        meshes.push_back(mesh);
     }
 
     for (unsigned int i = 0; i < node->mNumChildren; i++) {
-        processNode(node->mChildren[i], scene, model);
+        processNode(node->mChildren[i], scene, model, meshes);
+    }
+}
+
+uint32_t loadMaterial(const aiMaterial* material, const aiScene* scene, ModelData& model) {
+    MaterialRef ref;
+
+    aiColor4D diffuse;
+    if (aiGetMaterialColor(material, AI_MATKEY_COLOR_DIFFUSE, &diffuse) == AI_SUCCESS) {
+        ref.params.baseColor = glm::vec4(diffuse.r, diffuse.g, diffuse.b, 1.0f);
     }
+    float opacity = 1.0f;
+    if (aiGetMaterialFloat(material, AI_MATKEY_OPACITY, &opacity) == AI_SUCCESS) {
+        ref.params.baseColor.a = opacity;
+    }
+    aiColor4D specular;
+    if (aiGetMaterialColor(material, AI_MATKEY_COLOR_SPECULAR, &specular) == AI_SUCCESS) {
+        ref.params.specular = glm::vec4(specular.r, specular.g, specular.b, 0.0f);
+    }
+    float shininess = 0.0f;
+    if (aiGetMaterialFloat(material, AI_MATKEY_SHININESS, &shininess) == AI_SUCCESS) {
+        ref.params.specular.w = shininess;
+    }
+
+    ref.firstTexture = (uint32_t)model.textures.size();
+    loadMaterialTexture(material, aiTextureType_DIFFUSE, "texture_diffuse", scene, model);
+    loadMaterialTexture(material, aiTextureType_SPECULAR, "texture_specular", scene, model);
+    loadMaterialTexture(material, aiTextureType_HEIGHT, "texture_normal", scene, model);
+    loadMaterialTexture(material, aiTextureType_AMBIENT, "texture_height", scene, model);
+    ref.textureCount = (uint32_t)model.textures.size() - ref.firstTexture;
+
+    model.materials.push_back(ref);
+    return (uint32_t)model.materials.size() - 1;
 }
 
-Mesh processMesh(aiMesh* mesh, const aiScene* scene, Model& model) {
-    std::vector<Vertex> vertices;
-    std::vector<unsigned int> indices;
+void processMesh(const aiMesh* mesh, const ModelData& model, MeshData& data) {
+    std::vector<Vertex>& vertices = data.vertices;
+    std::vector<unsigned int>& indices = data.indices;
 
     // Process vertices
+    vertices.resize(mesh->mNumVertices);
     for (unsigned int i = 0; i < mesh->mNumVertices; i++) {
-        Vertex vertex;
+        Vertex& vertex = vertices[i];
         SetVertexBoneDataToDefault(vertex);
         vertex.position = glm::vec3(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z);
         vertex.color = glm::vec3(1.0f); // Default color
@@ -37,34 +378,23 @@ Mesh processMesh(aiMesh* mesh, const aiScene* scene, Model& model) {
         else {
             vertex.texCoords = glm::vec2(0.0f, 0.0f);
         }
-        vertices.push_back(vertex);
     }
 
-    // Process indices
+    // Process indices, triangulated on import so usually three per face
+    size_t indexCount = 0;
     for (unsigned int i = 0; i < mesh->mNumFaces; i++) {
-        aiFace face = mesh->mFaces[i];
+        indexCount += mesh->mFaces[i].mNumIndices;
+    }
+    indices.resize(indexCount);
+    unsigned int* index = indices.data();
+    for (unsigned int i = 0; i < mesh->mNumFaces; i++) {
+        const aiFace& face = mesh->mFaces[i];
         for (unsigned int j = 0; j < face.mNumIndices; j++) {
-            indices.push_back(face.mIndices[j]);
+            *index++ = face.mIndices[j];
         }
     }
 
-    aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
-
-    std::vector<Texture> diffuseMaps = loadMaterialTexture(material, aiTextureType_DIFFUSE, "texture_diffuse", scene, model);
-    model.textures.insert(model.textures.end(), diffuseMaps.begin(), diffuseMaps.end());
-
-    std::vector<Texture> specularMaps = loadMaterialTexture(material, aiTextureType_SPECULAR, "texture_specular", scene, model);
-    model.textures.insert(model.textures.end(), specularMaps.begin(), specularMaps.end());
-
-    std::vector<Texture> normalMaps = loadMaterialTexture(material, aiTextureType_HEIGHT, "texture_normal", scene, model);
-    model.textures.insert(model.textures.end(), normalMaps.begin(), normalMaps.end());
-
-    std::vector<Texture> heightMaps = loadMaterialTexture(material, aiTextureType_AMBIENT, "texture_height", scene, model);
-    model.textures.insert(model.textures.end(), heightMaps.begin(), heightMaps.end());
-
-    ExtractBoneWeightForVertices(model, vertices, mesh, scene);
-
-    return setupMesh(vertices, indices);
+    ExtractBoneWeightForVertices(model, vertices, mesh);
 }
 
 void SetVertexBoneDataToDefault(Vertex& vertex)
@@ -84,34 +414,67 @@ void SetVertexBoneData(Vertex& vertex, int boneID, float weight)
         {
             vertex.boneWeights[i] = weight;
             vertex.boneIds[i] = boneID;
-            break;
+            return;
         }
     }
+
+    // More than four influences: keep the strongest ones
+    int weakest = 0;
+    for (int i = 1; i < 4; ++i)
+    {
+        if (vertex.boneWeights[i] < vertex.boneWeights[weakest])
+        {
+            weakest = i;
+        }
+    }
+    if (weight > vertex.boneWeights[weakest])
+    {
+        vertex.boneWeights[weakest] = weight;
+        vertex.boneIds[weakest] = boneID;
+    }
 }
 
-void ExtractBoneWeightForVertices(Model& model, std::vector<Vertex>& vertices, aiMesh* mesh, const aiScene* scene)
+void NormalizeVertexBoneWeights(Vertex& vertex)
+{
+    float total = vertex.boneWeights[0] + vertex.boneWeights[1] + vertex.boneWeights[2] + vertex.boneWeights[3];
+    if (total > 0.0f)
+    {
+        for (int i = 0; i < 4; ++i)
+        {
+            vertex.boneWeights[i] /= total;
+        }
+    }
+}
+
+void RegisterMeshBones(ModelData& model, const aiMesh* mesh)
 {
     auto& boneInfoMap = model.m_BoneInfoMap;
     int& boneCount = model.m_BoneCounter;
 
-    for (int boneIndex = 0; boneIndex < mesh->mNumBones; ++boneIndex)
+    for (unsigned int boneIndex = 0; boneIndex < mesh->mNumBones; ++boneIndex)
     {
-        int boneID = -1;
         std::string boneName = mesh->mBones[boneIndex]->mName.C_Str();
         if (boneInfoMap.find(boneName) == boneInfoMap.end())
         {
             BoneInfo newBoneInfo;
             newBoneInfo.id = boneCount;
             newBoneInfo.offset = convertMatrixToGLMFormat(mesh->mBones[boneIndex]->mOffsetMatrix);
-            boneInfoMap[boneName] = newBoneInfo;
-            boneID = boneCount;
+            boneInfoMap.emplace(std::move(boneName), newBoneInfo);
             boneCount++;
         }
-        else
-        {
-            boneID = boneInfoMap[boneName].id;
-        }
-        assert(boneID != -1);
+    }
+}
+
+void ExtractBoneWeightForVertices(const ModelData& model, std::vector<Vertex>& vertices, const aiMesh* mesh)
+{
+    const auto& boneInfoMap = model.m_BoneInfoMap;
+
+    for (unsigned int boneIndex = 0; boneIndex < mesh->mNumBones; ++boneIndex)
+    {
+        // Registered up front by RegisterMeshBones, only read here
+        auto boneInfo = boneInfoMap.find(mesh->mBones[boneIndex]->mName.C_Str());
+        assert(boneInfo != boneInfoMap.end());
+        int boneID = boneInfo->second.id;
         auto weights = mesh->mBones[boneIndex]->mWeights;
         int numWeights = mesh->mBones[boneIndex]->mNumWeights;
 
@@ -123,69 +486,46 @@ void ExtractBoneWeightForVertices(Model& model, std::vector<Vertex>& vertices, a
             SetVertexBoneData(vertices[vertexId], boneID, weight);
         }
     }
+
+    if (mesh->mNumBones > 0)
+    {
+        for (Vertex& vertex : vertices)
+        {
+            NormalizeVertexBoneWeights(vertex);
+        }
+    }
 }
 
 // https://chatgpt.com/g/g-3s6SJ5V7S-askthecode-git-companion/c/7ce512cd-ffa7-43f6-97ab-fdb33385d32c?oauth_success=true
-std::vector<Texture> loadMaterialTexture(aiMaterial* mat, aiTextureType type, std::string typeName, const aiScene* scene, Model& model) {
-    std::vector<Texture> textures;
-
+void loadMaterialTexture(const aiMaterial* mat, aiTextureType type, std::string typeName, const aiScene* scene, ModelData& model) {
     for (unsigned int i = 0; i < mat->GetTextureCount(type); i++)
     {
         aiString path;
         mat->GetTexture(type, i, &path);
 
+        TextureRef ref;
+        ref.type = typeName;
+
         aiTexture const* texture = scene->GetEmbeddedTexture(path.C_Str());
         if (texture) {
-            unsigned int textureID;
-            glGenTextures(1, &textureID);
-            glBindTexture(GL_TEXTURE_2D, textureID);
-
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-            int width, height;
-            unsigned char* data = nullptr;
-            if (texture->mHeight == 0) { // Compressed texture
-                data = stbi_load_from_memory((unsigned char*)texture->pcData, texture->mWidth, &width, &height, nullptr, 4);
-            }
-            else { // Uncompressed texture
-                width = texture->mWidth;
-                height = texture->mHeight;
-                data = (unsigned char*)texture->pcData;
-            }
+            const unsigned char* data = reinterpret_cast<const unsigned char*>(texture->pcData);
+            size_t size = texture->mHeight == 0 ? texture->mWidth : size_t(texture->mWidth) * texture->mHeight * sizeof(aiTexel);
+            ref.id = hashCombine(makeAssetId(model.path), hash64(data, size));
+            ref.width = texture->mWidth;
+            ref.height = texture->mHeight;
 
-            if (data) {
-                glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-                glGenerateMipmap(GL_TEXTURE_2D);
-                if (texture->mHeight == 0) {
-                    stbi_image_free(data);
-                }
-            }
-            else {
-                spdlog::error("Failed to load embedded texture");
-                if (texture->mHeight == 0) {
-                    stbi_image_free(data);
-                }
-                glDeleteTextures(1, &textureID);
-                return {};
+            // Materials sharing an atlas keep a single copy of its bytes
+            bool seen = std::any_of(model.textures.begin(), model.textures.end(), [&](const TextureRef& other) { return other.id == ref.id; });
+            if (!seen) {
+                ref.embedded.assign(data, data + size);
             }
-
-            auto texture = std::make_shared<Texture>();
-            texture->id = textureID;
-            texture->type = type;
-
-            spdlog::info("Embedded texture loaded");
-
-            textures.push_back(*texture);
         }
         else {
             spdlog::info("external  texture");
-            std::string absolutePath = model.directory + "/" + path.C_Str();
-            textures.push_back(*loadTexture(gAssets, absolutePath.c_str(), typeName));
+            ref.path = model.directory + "/" + path.C_Str();
+            ref.id = makeAssetId(ref.path);
         }
-    }
 
-    return textures;
-}
\ No newline at end of file
+        model.textures.push_back(std::move(ref));
+    }
+}
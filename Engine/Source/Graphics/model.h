@@ -2,6 +2,9 @@
 #ifndef MODEL_H
 #define MODEL_H
 
+#include "Asset/cookedtexture.h"
+#include "Asset/handle.h"
+#include "Graphics/material.h"
 #include "Graphics/mesh.h"
 #include "Graphics/texture.h"
 #include "animdata.h"
@@ -14,6 +17,7 @@
 #include <vector>
 #include <string>
 #include <map>
+#include <memory>
 #include <unordered_map>
 
 struct Assets;
@@ -23,23 +27,105 @@ struct aiScene;
 struct aiNode;
 
 struct Model {
+	std::string path;
 	std::string directory;
 	std::vector<Mesh> meshes;
-	std::vector<Texture> textures;
+	std::vector<Handle<Material>> materials; // the model holds a reference on each of these
+
+	glm::vec3 boundsCenter = glm::vec3(0.0f);
+	float boundsRadius = 0.0f;
+	float worldUnitsPerUv = 0.0f; // average texture scale over the surface, 0 without UVs
 
 	std::map<std::string, BoneInfo> m_BoneInfoMap; // (skeleton)
 	int m_BoneCounter = 0;
+
+	bool retainsMeshData = false; // meshes kept their vertices and indices on the CPU
+};
+
+// CPU-side result of importing a model, before anything is uploaded to the GPU.
+// This is also what gets written to the cooked model format.
+struct MeshData {
+	std::vector<Vertex> vertices;
+	std::vector<unsigned int> indices;
+	uint32_t material = 0;
 };
 
-void processNode(aiNode* node, const aiScene* scene, Model& model);
-Mesh processMesh(aiMesh* mesh, const aiScene* scene, Model& model);
+struct TextureRef {
+	AssetId id = 0; // external textures only
+	std::string type;
+	std::string path; // external file, empty for embedded textures
+	std::vector<unsigned char> embedded; // compressed image when height is 0, raw texels otherwise
+	unsigned int width = 0;
+	unsigned int height = 0;
+};
 
-std::vector<Texture> loadMaterialTexture(aiMaterial* mat, aiTextureType type, std::string typeName, const aiScene* scene, Model& model);
+// One material of a model: its parameters and a range of the model's textures
+struct MaterialRef {
+	MaterialParams params;
+	uint32_t firstTexture = 0;
+	uint32_t textureCount = 0;
+};
+
+struct ModelData {
+	std::string path;
+	std::string directory;
+	std::vector<MeshData> meshes;
+	std::vector<MaterialRef> materials;
+	std::vector<TextureRef> textures; // grouped by material
+
+	std::map<std::string, BoneInfo> m_BoneInfoMap;
+	int m_BoneCounter = 0;
+};
+
+// Material texture on its way to the GPU. Embedded bytes point into a ModelData
+// or a mapped cooked file; the image may be decoded ahead of time off the GL thread.
+struct TextureSource {
+	AssetId id = 0;
+	std::string type;
+	std::string path;
+	const unsigned char* data = nullptr;
+	size_t size = 0;
+	unsigned int width = 0;
+	unsigned int height = 0;
+	Image image;
+	std::shared_ptr<CookedImage> cooked; // external textures that have been through the texture cooker
+};
+
+bool importModel(const std::string& filePath, ModelData& model);
+// retainMeshData keeps a CPU copy of every mesh next to its GL buffers
+void uploadModel(const ModelData& data, Model& model, bool retainMeshData = false);
+void uploadMeshes(const ModelData& data, Model& model, bool retainMeshData = false);
+
+std::vector<TextureSource> getTextureSources(const ModelData& data);
+void decodeTextureSources(std::vector<TextureSource>& sources);
+// Uploads the textures, then finds or creates each material and points the
+// meshes at them. GL thread only.
+void uploadModelMaterials(std::vector<TextureSource>& sources, const std::vector<MaterialRef>& materials, Model& model);
+
+// Bounds and texture scale from the uploaded meshes
+void updateModelBounds(Model& model);
+
+AssetMemory getModelMemory(const Model& model);
+// Frees the GL buffers and drops the model's material references
+void destroyModel(Assets& assets, Model& model);
+
+// Serial pass in node order: registers materials and bones and lists the meshes
+void processNode(aiNode* node, const aiScene* scene, ModelData& model, std::vector<const aiMesh*>& meshes);
+// Appends a scene material and its textures to the model, returns its index
+uint32_t loadMaterial(const aiMaterial* material, const aiScene* scene, ModelData& model);
+// Converts one mesh. Only reads the model, so meshes can convert in parallel.
+void processMesh(const aiMesh* mesh, const ModelData& model, MeshData& data);
+
+void loadMaterialTexture(const aiMaterial* mat, aiTextureType type, std::string typeName, const aiScene* scene, ModelData& model);
 
 void SetVertexBoneDataToDefault(Vertex& vertex);
 
 void SetVertexBoneData(Vertex& vertex, int boneID, float weight);
 
-void ExtractBoneWeightForVertices(Model& model, std::vector<Vertex>& vertices, aiMesh* mesh, const aiScene* scene);
+void NormalizeVertexBoneWeights(Vertex& vertex);
+
+void RegisterMeshBones(ModelData& model, const aiMesh* mesh);
+
+void ExtractBoneWeightForVertices(const ModelData& model, std::vector<Vertex>& vertices, const aiMesh* mesh);
 
-#endif 
\ No newline at end of file
+#endif
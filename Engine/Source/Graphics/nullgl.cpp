@@ -0,0 +1,259 @@
+#include "nullgl.h"
+#include "glext.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <unordered_map>
+#include <utility>
+
+namespace {
+    // glad 3.3 core plus the extensions in glext.h is under 400 entry points.
+    // The last slot collects anything past the limit.
+    constexpr size_t kMaxNullFunctions = 512;
+
+    struct NullGL {
+        std::vector<std::string> names;
+        std::unordered_map<std::string, size_t> lookup;
+        uint64_t counts[kMaxNullFunctions] = {};
+        GLuint nextName = 1;
+        // Buffer bound per target, so each buffer maps its own memory. Persistently
+        // mapped buffers stay mapped side by side.
+        std::unordered_map<GLenum, GLuint> boundBuffers;
+        std::unordered_map<GLuint, std::vector<unsigned char>> mapped;
+    };
+
+    NullGL gNullGL;
+
+    size_t registerFunction(const char* name) {
+        auto it = gNullGL.lookup.find(name);
+        if (it != gNullGL.lookup.end()) {
+            return it->second;
+        }
+        if (gNullGL.names.size() + 1 >= kMaxNullFunctions) {
+            return kMaxNullFunctions - 1;
+        }
+        size_t index = gNullGL.names.size();
+        gNullGL.names.push_back(name);
+        gNullGL.lookup.emplace(name, index);
+        return index;
+    }
+
+    // Entry points with results get their own stub, registered on first call
+#define NULL_GL_COUNT(name) \
+    static const size_t callIndex = registerFunction(name); \
+    gNullGL.counts[callIndex]++
+
+    // Everything else: ignore the arguments, return 0. GL_NO_ERROR, location 0,
+    // GL_FALSE, a null pointer, all fine for a driver that draws nothing.
+    using NullProc = uintptr_t(APIENTRY*)();
+
+    template <size_t I>
+    uintptr_t APIENTRY nullCall() {
+        gNullGL.counts[I]++;
+        return 0;
+    }
+
+    template <size_t... I>
+    std::array<NullProc, sizeof...(I)> makeNullCalls(std::index_sequence<I...>) {
+        return { { &nullCall<I>... } };
+    }
+
+    const std::array<NullProc, kMaxNullFunctions> kNullCalls = makeNullCalls(std::make_index_sequence<kMaxNullFunctions>());
+
+    const GLubyte* APIENTRY nullGetString(GLenum name) {
+        NULL_GL_COUNT("glGetString");
+        switch (name) {
+        case GL_VERSION:
+            return reinterpret_cast<const GLubyte*>("4.5 Null");
+        case GL_RENDERER:
+            return reinterpret_cast<const GLubyte*>("Null");
+        default:
+            return reinterpret_cast<const GLubyte*>("");
+        }
+    }
+
+    // S3TC so cooked BC1/BC3 textures take the same path as on a desktop driver
+    const char* const kNullExtensions[] = { "GL_ENGINE_null_driver", "GL_EXT_texture_compression_s3tc" };
+    constexpr GLint kNullExtensionCount = GLint(sizeof(kNullExtensions) / sizeof(kNullExtensions[0]));
+
+    const GLubyte* APIENTRY nullGetStringi(GLenum, GLuint index) {
+        NULL_GL_COUNT("glGetStringi");
+        return reinterpret_cast<const GLubyte*>(index < GLuint(kNullExtensionCount) ? kNullExtensions[index] : "");
+    }
+
+    void APIENTRY nullGetIntegerv(GLenum name, GLint* value) {
+        NULL_GL_COUNT("glGetIntegerv");
+        switch (name) {
+        case GL_MAJOR_VERSION:
+            *value = 4;
+            break;
+        case GL_MINOR_VERSION:
+            *value = 5;
+            break;
+        case GL_MAX_ARRAY_TEXTURE_LAYERS:
+            *value = 2048;
+            break;
+        case GL_NUM_EXTENSIONS:
+            // glad refuses to load without any
+            *value = kNullExtensionCount;
+            break;
+        default:
+            // No program binary formats
+            *value = 0;
+            break;
+        }
+    }
+
+    void APIENTRY nullGetShaderiv(GLuint, GLenum name, GLint* value) {
+        NULL_GL_COUNT("glGetShaderiv");
+        *value = (name == GL_COMPILE_STATUS || name == GL_COMPLETION_STATUS_KHR) ? GL_TRUE : 0;
+    }
+
+    void APIENTRY nullGetProgramiv(GLuint, GLenum name, GLint* value) {
+        NULL_GL_COUNT("glGetProgramiv");
+        *value = (name == GL_LINK_STATUS || name == GL_COMPLETION_STATUS_KHR) ? GL_TRUE : 0;
+    }
+
+    void APIENTRY nullGetInfoLog(GLuint, GLsizei size, GLsizei* length, GLchar* log) {
+        NULL_GL_COUNT("glGetInfoLog");
+        if (length) {
+            *length = 0;
+        }
+        if (log && size > 0) {
+            log[0] = '\0';
+        }
+    }
+
+    void APIENTRY nullGenNames(GLsizei count, GLuint* names) {
+        NULL_GL_COUNT("glGen*");
+        for (GLsizei i = 0; i < count; i++) {
+            names[i] = gNullGL.nextName++;
+        }
+    }
+
+    GLuint APIENTRY nullCreateShader(GLenum) {
+        NULL_GL_COUNT("glCreateShader");
+        return gNullGL.nextName++;
+    }
+
+    GLuint APIENTRY nullCreateProgram() {
+        NULL_GL_COUNT("glCreateProgram");
+        return gNullGL.nextName++;
+    }
+
+    void APIENTRY nullBindBuffer(GLenum target, GLuint buffer) {
+        NULL_GL_COUNT("glBindBuffer");
+        gNullGL.boundBuffers[target] = buffer;
+    }
+
+    void APIENTRY nullDeleteBuffers(GLsizei count, const GLuint* buffers) {
+        NULL_GL_COUNT("glDeleteBuffers");
+        for (GLsizei i = 0; i < count; i++) {
+            gNullGL.mapped.erase(buffers[i]);
+        }
+    }
+
+    void* APIENTRY nullMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield) {
+        NULL_GL_COUNT("glMapBufferRange");
+        // Callers still write through it, so the copy cost stays in the measurement
+        std::vector<unsigned char>& memory = gNullGL.mapped[gNullGL.boundBuffers[target]];
+        if (memory.size() < size_t(offset + length)) {
+            memory.resize(size_t(offset + length));
+        }
+        return memory.data() + offset;
+    }
+
+    GLboolean APIENTRY nullUnmapBuffer(GLenum) {
+        NULL_GL_COUNT("glUnmapBuffer");
+        return GL_TRUE;
+    }
+
+    GLsync APIENTRY nullFenceSync(GLenum, GLbitfield) {
+        NULL_GL_COUNT("glFenceSync");
+        return reinterpret_cast<GLsync>(uintptr_t(1));
+    }
+
+    GLenum APIENTRY nullClientWaitSync(GLsync, GLbitfield, GLuint64) {
+        NULL_GL_COUNT("glClientWaitSync");
+        return GL_ALREADY_SIGNALED;
+    }
+
+    GLenum APIENTRY nullCheckFramebufferStatus(GLenum) {
+        NULL_GL_COUNT("glCheckFramebufferStatus");
+        return GL_FRAMEBUFFER_COMPLETE;
+    }
+
+#undef NULL_GL_COUNT
+
+    struct NullOverride {
+        const char* name;
+        void* proc;
+    };
+
+    const NullOverride kOverrides[] = {
+        { "glGetString", reinterpret_cast<void*>(&nullGetString) },
+        { "glGetStringi", reinterpret_cast<void*>(&nullGetStringi) },
+        { "glGetIntegerv", reinterpret_cast<void*>(&nullGetIntegerv) },
+        { "glGetShaderiv", reinterpret_cast<void*>(&nullGetShaderiv) },
+        { "glGetProgramiv", reinterpret_cast<void*>(&nullGetProgramiv) },
+        { "glGetShaderInfoLog", reinterpret_cast<void*>(&nullGetInfoLog) },
+        { "glGetProgramInfoLog", reinterpret_cast<void*>(&nullGetInfoLog) },
+        { "glGenTextures", reinterpret_cast<void*>(&nullGenNames) },
+        { "glGenBuffers", reinterpret_cast<void*>(&nullGenNames) },
+        { "glGenVertexArrays", reinterpret_cast<void*>(&nullGenNames) },
+        { "glGenFramebuffers", reinterpret_cast<void*>(&nullGenNames) },
+        { "glGenRenderbuffers", reinterpret_cast<void*>(&nullGenNames) },
+        { "glGenQueries", reinterpret_cast<void*>(&nullGenNames) },
+        { "glCreateShader", reinterpret_cast<void*>(&nullCreateShader) },
+        { "glCreateProgram", reinterpret_cast<void*>(&nullCreateProgram) },
+        { "glBindBuffer", reinterpret_cast<void*>(&nullBindBuffer) },
+        { "glDeleteBuffers", reinterpret_cast<void*>(&nullDeleteBuffers) },
+        { "glMapBufferRange", reinterpret_cast<void*>(&nullMapBufferRange) },
+        { "glUnmapBuffer", reinterpret_cast<void*>(&nullUnmapBuffer) },
+        { "glFenceSync", reinterpret_cast<void*>(&nullFenceSync) },
+        { "glClientWaitSync", reinterpret_cast<void*>(&nullClientWaitSync) },
+        { "glCheckFramebufferStatus", reinterpret_cast<void*>(&nullCheckFramebufferStatus) },
+    };
+}
+
+bool isNullGLSupported() {
+#if defined(_WIN32) && !defined(_WIN64)
+    return false;
+#else
+    return true;
+#endif
+}
+
+void* getNullGLProcAddress(const char* name) {
+    for (const NullOverride& entry : kOverrides) {
+        if (std::strcmp(entry.name, name) == 0) {
+            return entry.proc;
+        }
+    }
+    return reinterpret_cast<void*>(kNullCalls[registerFunction(name)]);
+}
+
+uint64_t getNullGLCallCount() {
+    uint64_t total = 0;
+    for (uint64_t count : gNullGL.counts) {
+        total += count;
+    }
+    return total;
+}
+
+std::vector<GLCallCount> getNullGLCallCounts() {
+    std::vector<GLCallCount> calls;
+    for (size_t i = 0; i < gNullGL.names.size(); i++) {
+        if (gNullGL.counts[i] > 0) {
+            calls.push_back({ gNullGL.names[i], gNullGL.counts[i] });
+        }
+    }
+    if (gNullGL.counts[kMaxNullFunctions - 1] > 0 && gNullGL.names.size() < kMaxNullFunctions) {
+        calls.push_back({ "other", gNullGL.counts[kMaxNullFunctions - 1] });
+    }
+    std::sort(calls.begin(), calls.end(), [](const GLCallCount& a, const GLCallCount& b) { return a.count > b.count; });
+    return calls;
+}
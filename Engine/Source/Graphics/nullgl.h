@@ -0,0 +1,32 @@
+#pragma once
+#ifndef NULL_GL_H
+#define NULL_GL_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// A GL driver that does nothing. Every entry point glad asks for resolves to a
+// stub that counts the call and returns; the few whose results the engine
+// depends on (names, compile status, mapped memory, version queries) answer as
+// a driver with no useful extensions beyond S3TC would. Lets the CPU side of a frame be
+// measured on machines without any GL at all.
+
+// Not available on 32-bit Windows, where GL entry points clean up their own
+// stack and a shared stub cannot stand in for them
+bool isNullGLSupported();
+
+// Loader for gladLoadGLLoader and loadGLExtensions
+void* getNullGLProcAddress(const char* name);
+
+struct GLCallCount {
+	std::string name;
+	uint64_t count = 0;
+};
+
+// Calls made through the null driver since startup
+uint64_t getNullGLCallCount();
+// Per entry point, most called first. Entry points never called are left out.
+std::vector<GLCallCount> getNullGLCallCounts();
+
+#endif
@@ -0,0 +1,182 @@
+#include "perfhud.h"
+#include "gputimer.h"
+#include "Core/profiler.h"
+
+#include <imgui/imgui.h>
+#include <imgui/imgui_impl_sdl2.h>
+#include <imgui/imgui_impl_opengl3.h>
+#include <SDL.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cstdio>
+
+namespace {
+    // Sorting the window every frame would cost more than the HUD draws
+    constexpr double kSummaryRefreshSeconds = 0.25;
+    // One millisecond each, the last one holds everything from 32 ms up
+    constexpr int kHistogramBuckets = 33;
+
+    struct PerfHud {
+        bool initialized = false;
+        bool visible = false;
+        Uint64 lastRefresh = 0;
+        float histogram[kHistogramBuckets] = {};
+    };
+
+    PerfHud gPerfHud;
+
+    float getSampleMilliseconds(void* data, int index) {
+        return getFrameSample(*static_cast<const FrameStats*>(data), index).milliseconds;
+    }
+
+    void drawTimeRow(const char* name, const FrameTimeSummary& summary) {
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::TextUnformatted(name);
+        for (float value : { summary.mean, summary.p50, summary.p95, summary.p99, summary.max }) {
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f", value);
+        }
+    }
+}
+
+bool initPerfHud(SDL_Window* window, void* glContext, bool visible) {
+    IMGUI_CHECKVERSION();
+    ImGui::CreateContext();
+    // Nothing about the overlay is worth keeping between runs
+    ImGui::GetIO().IniFilename = nullptr;
+    ImGui::StyleColorsDark();
+
+    if (!ImGui_ImplSDL2_InitForOpenGL(window, glContext)) {
+        spdlog::error("Performance HUD: SDL2 backend failed to start");
+        ImGui::DestroyContext();
+        return false;
+    }
+    if (!ImGui_ImplOpenGL3_Init("#version 450")) {
+        spdlog::error("Performance HUD: OpenGL3 backend failed to start");
+        ImGui_ImplSDL2_Shutdown();
+        ImGui::DestroyContext();
+        return false;
+    }
+
+    gPerfHud.initialized = true;
+    gPerfHud.visible = visible;
+    return true;
+}
+
+void shutdownPerfHud() {
+    if (!gPerfHud.initialized) {
+        return;
+    }
+    ImGui_ImplOpenGL3_Shutdown();
+    ImGui_ImplSDL2_Shutdown();
+    ImGui::DestroyContext();
+    gPerfHud = PerfHud{};
+}
+
+bool handlePerfHudEvent(const SDL_Event& event) {
+    if (!gPerfHud.initialized) {
+        return false;
+    }
+    if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_F3 && event.key.repeat == 0) {
+        gPerfHud.visible = !gPerfHud.visible;
+    }
+    // Hidden, the overlay sees no input and the game keeps all of it
+    if (!gPerfHud.visible) {
+        return false;
+    }
+
+    ImGui_ImplSDL2_ProcessEvent(&event);
+    const ImGuiIO& io = ImGui::GetIO();
+    switch (event.type) {
+    case SDL_MOUSEMOTION:
+    case SDL_MOUSEBUTTONDOWN:
+    case SDL_MOUSEBUTTONUP:
+    case SDL_MOUSEWHEEL:
+        return io.WantCaptureMouse;
+    case SDL_KEYDOWN:
+    case SDL_KEYUP:
+    case SDL_TEXTINPUT:
+        return io.WantCaptureKeyboard;
+    default:
+        return false;
+    }
+}
+
+bool isPerfHudVisible() {
+    return gPerfHud.initialized && gPerfHud.visible;
+}
+
+void drawPerfHud(FrameStats& stats) {
+    if (!isPerfHudVisible()) {
+        return;
+    }
+    PROFILE_ZONE("drawPerfHud");
+    PROFILE_GPU_ZONE("HUD");
+
+    Uint64 now = SDL_GetPerformanceCounter();
+    if (now - gPerfHud.lastRefresh >= Uint64(kSummaryRefreshSeconds * SDL_GetPerformanceFrequency())) {
+        updateFrameStatsSummary(stats);
+        getFrameTimeHistogram(stats, 1.0f, gPerfHud.histogram, kHistogramBuckets);
+        gPerfHud.lastRefresh = now;
+    }
+    const FrameStatsSummary& summary = stats.summary;
+
+    ImGui_ImplOpenGL3_NewFrame();
+    ImGui_ImplSDL2_NewFrame();
+    ImGui::NewFrame();
+
+    ImGui::SetNextWindowPos(ImVec2(10.0f, 10.0f), ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowBgAlpha(0.75f);
+    ImGui::Begin("Performance (F3)", nullptr, ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoFocusOnAppearing);
+
+    float fps = summary.frame.mean > 0.0f ? 1000.0f / summary.frame.mean : 0.0f;
+    ImGui::Text("%.1f fps, CPU %.2f ms, GPU %.2f ms over %zu frames", fps, summary.frame.mean, summary.gpu.mean, summary.frames);
+
+    if (stats.count > 0) {
+        char overlay[64];
+        std::snprintf(overlay, sizeof(overlay), "p99 %.2f ms", summary.frame.p99);
+        float scaleMax = std::max(summary.frame.max, 1000.0f / 30.0f);
+        ImGui::PlotLines("Frame ms", getSampleMilliseconds, &stats, int(stats.count), 0, overlay, 0.0f, scaleMax, ImVec2(360.0f, 60.0f));
+        ImGui::PlotHistogram("Histogram", gPerfHud.histogram, kHistogramBuckets, 0, "1 ms buckets", 0.0f, FLT_MAX, ImVec2(360.0f, 60.0f));
+    }
+
+    if (ImGui::BeginTable("Times", 6, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit)) {
+        for (const char* header : { "ms", "mean", "p50", "p95", "p99", "max" }) {
+            ImGui::TableSetupColumn(header);
+        }
+        ImGui::TableHeadersRow();
+        drawTimeRow("Frame", summary.frame);
+        drawTimeRow("GPU", summary.gpu);
+        for (size_t phase = 0; phase < kFramePhaseCount; phase++) {
+            drawTimeRow(getFramePhaseName(FramePhase(phase)), summary.phases[phase]);
+        }
+        ImGui::EndTable();
+    }
+
+    ImGui::Text("Draw calls %.0f mean, %u max", summary.drawCallsMean, summary.drawCallsMax);
+    ImGui::Text("Triangles %.0f mean, %llu max", summary.trianglesMean, (unsigned long long)summary.trianglesMax);
+
+    // A few frames old, whatever the GPU has finished
+    const std::vector<GpuZoneTiming>& zones = getGpuZoneTimings();
+    if (!zones.empty() && ImGui::CollapsingHeader("GPU zones", ImGuiTreeNodeFlags_DefaultOpen)) {
+        for (const GpuZoneTiming& zone : zones) {
+            ImGui::Text("%*s%s %.3f ms", zone.depth * 2, "", zone.name, zone.milliseconds);
+        }
+        const GpuPipelineStatistics& pipeline = getGpuPipelineStatistics();
+        if (pipeline.verticesSubmitted > 0) {
+            ImGui::Text("Vertices %llu, VS invocations %llu", (unsigned long long)pipeline.verticesSubmitted, (unsigned long long)pipeline.vertexShaderInvocations);
+            ImGui::Text("Primitives %llu, clipped to %llu", (unsigned long long)pipeline.primitivesSubmitted, (unsigned long long)pipeline.clippingOutputPrimitives);
+            ImGui::Text("FS invocations %llu", (unsigned long long)pipeline.fragmentShaderInvocations);
+        }
+        if (getDroppedGpuFrameCount() > 0) {
+            ImGui::Text("%llu frames dropped in flight", (unsigned long long)getDroppedGpuFrameCount());
+        }
+    }
+
+    ImGui::End();
+    ImGui::Render();
+    ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+}
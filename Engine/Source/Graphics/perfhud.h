@@ -0,0 +1,28 @@
+#pragma once
+#ifndef PERF_HUD_H
+#define PERF_HUD_H
+
+#include "Core/framestats.h"
+
+struct SDL_Window;
+union SDL_Event;
+
+// In-game overlay of the rolling frame statistics: percentiles, a frame time
+// graph and histogram, the per-phase split, draw counts and the GPU zones.
+// Dear ImGui through its SDL2 and OpenGL3 backends, so only with a window;
+// headless runs write the samples out with --frame-stats instead.
+
+// glContext is the window's SDL_GLContext. Returns false and leaves every other
+// call here doing nothing when ImGui could not start.
+bool initPerfHud(SDL_Window* window, void* glContext, bool visible);
+void shutdownPerfHud();
+
+// F3 toggles the overlay. Returns true when the event landed on the overlay
+// and should not reach the game.
+bool handlePerfHudEvent(const SDL_Event& event);
+bool isPerfHudVisible();
+
+// After the scene, inside the GPU frame so the overlay is timed as its own zone
+void drawPerfHud(FrameStats& stats);
+
+#endif
@@ -2,6 +2,12 @@
 
 #include "Scene/scene.h"
 #include "Asset/asset.h"
+#include "Core/arena.h"
+#include "Core/jobs.h"
+#include "Core/memorytags.h"
+#include "Core/profiler.h"
+#include "Graphics/gputimer.h"
+#include "Graphics/material.h"
 #include "Graphics/shader.h"
 #include "animation.h"
 #include "animator.h"
@@ -13,72 +19,152 @@
 
 #include <spdlog/spdlog.h>
 
-#include <unordered_set>
-
-void renderScene(Scene& scene, float deltaTime) {
+#include <algorithm>
+
+namespace {
+    struct DrawItem {
+        uint64_t sortKey;
+        ShaderProgram* program;
+        const Material* material; // null for the fallback program
+        const Mesh* mesh;
+        const SceneObject* object;
+        bool skinned;
+    };
+}
+
+RenderStats renderScene(Scene& scene, float deltaTime) {
+    PROFILE_ZONE("renderScene");
+    MemoryTagScope memoryTag(MemoryTag::Render);
     glm::mat4 view = scene.camera->getViewMatrix();  // Get the dynamic view matrix from the camera
     glm::mat4 projection = glm::perspective(glm::radians(70.0f), (float)1280 / (float)720, 0.1f, 500.0f);  // Perspective projection matrix
 
-    scene.program->use();
-    scene.program->setUniform("projection", projection);
-    scene.program->setUniform("view", view);
-
-    // Render objects in the scene
-    for (auto object : scene.objects) {
-        object->animator->UpdateAnimation(deltaTime);
-
-        // Local Space
-        glm::vec3 position = object->position;
-        glm::vec3 rotation = object->rotation;
-        glm::vec3 scale = object->scale;
-
-        // World Space
-        glm::mat4 model = glm::translate(glm::mat4(1.0f), position) *
-            glm::rotate(glm::mat4(1.0f), glm::radians(rotation.x), glm::vec3(1, 0, 0)) *
-            glm::rotate(glm::mat4(1.0f), glm::radians(rotation.y), glm::vec3(0, 1, 0)) *
-            glm::rotate(glm::mat4(1.0f), glm::radians(rotation.z), glm::vec3(0, 0, 1)) *
-            glm::scale(glm::mat4(1.0f), scale);
-
-        scene.program->setUniform("model", model);
-
-        // Bind Textures
-        unsigned int diffuseNr = 1;
-        unsigned int specularNr = 1;
-        unsigned int normalNr = 1;
-        unsigned int heightNr = 1;
-
-        for (unsigned int i = 0; i < object->model->textures.size(); i++) {
-            glActiveTexture(GL_TEXTURE0 + i);
-            std::string number;
-            std::string name = object->model->textures[i].type;
-
-            if (name == "texture_diffuse") {
-                number = std::to_string(diffuseNr++);
+    // Animators only touch their own pose, so they all advance in parallel
+    // before drawing starts
+    parallelFor(gJobs, scene.objects.size(), [&](size_t begin, size_t end) {
+        PROFILE_ZONE("Animate objects");
+        for (size_t i = begin; i < end; i++) {
+            SceneObject& object = *scene.objects[i];
+            if (object.animator && gAssets.models.contains(object.model)) {
+                object.animator->UpdateAnimation(deltaTime);
             }
-            else if (name == "texture_specular") {
-                number = std::to_string(specularNr++);
+        }
+    });
+
+    // One draw per mesh, sorted by program and then material so each is bound
+    // once per run instead of once per object
+    ArenaVector<DrawItem> draws{ ArenaAllocator<DrawItem>(getFrameArena()) };
+    ShaderProgram* fallback = gAssets.shaders.get(scene.fallbackProgram);
+    for (const std::shared_ptr<SceneObject>& object : scene.objects) {
+        const Model* objectModel = gAssets.models.get(object->model);
+        if (!objectModel) {
+            continue;
+        }
+
+        // Only animated models pay for the bone math
+        bool animated = object->animator && objectModel->m_BoneCounter > 0;
+        for (const Mesh& mesh : objectModel->meshes) {
+            Handle<Material> materialHandle = mesh.materialIndex < objectModel->materials.size() ? objectModel->materials[mesh.materialIndex] : Handle<Material>{};
+            const Material* material = gAssets.materials.get(materialHandle);
+
+            // Fall back to the static permutation, then to the placeholder, while
+            // the driver is still compiling
+            bool skinned = animated;
+            ShaderProgram* program = nullptr;
+            if (material) {
+                program = gAssets.shaders.get(skinned ? material->skinnedProgram : material->program);
+                if (skinned && (!program || !program->isLinked())) {
+                    skinned = false;
+                    program = gAssets.shaders.get(material->program);
+                }
             }
-            else if (name == "texture_normal") {
-                number = std::to_string(normalNr++);
+            if (!program || !program->isLinked()) {
+                skinned = false;
+                material = nullptr;
+                program = fallback;
             }
-            else if (name == "texture_height") {
-                number = std::to_string(heightNr++);
+            if (!program || !program->isLinked()) {
+                continue;
             }
 
-            scene.program->setUniformInt((name + number).c_str(), i);
-            glBindTexture(GL_TEXTURE_2D, object->model->textures[i].id);
+            // Material slot indices are dense, so they keep the key in 64 bits
+            uint64_t sortKey = (uint64_t(program->id) << 32) | (material ? uint64_t(materialHandle.index) + 1 : 0);
+            draws.push_back({ sortKey, program, material, &mesh, object.get(), skinned });
+        }
+    }
+
+    {
+        PROFILE_ZONE("Sort draws");
+        std::sort(draws.begin(), draws.end(), [](const DrawItem& a, const DrawItem& b) {
+            return a.sortKey != b.sortKey ? a.sortKey < b.sortKey : a.object < b.object;
+        });
+    }
+
+    // The rest is GL submission
+    PROFILE_ZONE("Submit draws");
+    PROFILE_GPU_ZONE("Scene");
+    bool timeDrawGroups = getGpuTimerDetail() == GpuTimerDetail::DrawGroups;
+    // Pages hold the packed textures of every material, they stay bound for the frame
+    bindTexturePages();
+
+    // Camera uniforms go to each permutation the first time it is used this frame
+    const ShaderProgram* bound = nullptr;
+    const Material* boundMaterial = nullptr;
+    const SceneObject* boundObject = nullptr;
+    ArenaVector<const ShaderProgram*> prepared{ ArenaAllocator<const ShaderProgram*>(getFrameArena()) };
+    RenderStats stats;
+
+    for (const DrawItem& draw : draws) {
+        ShaderProgram* program = draw.program;
+        if (program != bound) {
+            // Runs of one program nest inside the scene pass
+            if (timeDrawGroups) {
+                if (bound) {
+                    endGpuZone();
+                }
+                beginGpuZone(draw.skinned ? "Skinned draws" : draw.material ? "Material draws" : "Fallback draws");
+            }
+            program->use();
+            bound = program;
+            stats.programBinds++;
+            // Object uniforms live in the program, they have to be set again
+            boundObject = nullptr;
+            if (std::find(prepared.begin(), prepared.end(), program) == prepared.end()) {
+                prepared.push_back(program);
+                program->setUniform("projection", projection);
+                program->setUniform("view", view);
+            }
         }
 
-        // Bind Mesh
-        for (Mesh& mesh : object->model->meshes) {
-            glBindVertexArray(mesh.vao);
-            glDrawElements(GL_TRIANGLES, mesh.indices.size(), GL_UNSIGNED_INT, 0);
-            glBindVertexArray(0);
+        // The block and texture units are context state, they survive program switches.
+        // With pages or bindless handles a material switch is just the block.
+        if (draw.material && draw.material != boundMaterial) {
+            bindMaterial(*draw.material);
+            boundMaterial = draw.material;
+            stats.materialBinds++;
         }
 
-        auto transforms = object->animator->GetFinalBoneMatrices();
-        for (int i = 0; i < transforms.size(); ++i) {
-            scene.program->setUniform("finalBonesMatrices[" + std::to_string(i) + "]", transforms[i]);
+        if (draw.object != boundObject) {
+            boundObject = draw.object;
+
+            // World Space
+            glm::mat4 model = getWorldMatrix(*draw.object);
+            program->setUniform("model", model);
+
+            if (draw.skinned) {
+                // One upload for the whole palette instead of a lookup per bone
+                const auto& transforms = draw.object->animator->GetFinalBoneMatrices();
+                program->setUniformArray("finalBonesMatrices", transforms.data(), (int)transforms.size());
+            }
         }
+
+        glBindVertexArray(draw.mesh->vao);
+        glDrawElements(GL_TRIANGLES, draw.mesh->indexCount, GL_UNSIGNED_INT, 0);
+        stats.drawCalls++;
+        stats.triangles += draw.mesh->indexCount / 3;
+    }
+    if (timeDrawGroups && bound) {
+        endGpuZone();
     }
-}
\ No newline at end of file
+    glBindVertexArray(0);
+    return stats;
+}
@@ -6,9 +6,19 @@
 #include <glm/trigonometric.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include <cstdint>
+
 struct Scene;
 struct ShaderProgram;
 
-void renderScene(Scene& scene, float deltaTime);
+struct RenderStats {
+	uint32_t drawCalls = 0;
+	uint64_t triangles = 0;
+	uint32_t programBinds = 0;
+	uint32_t materialBinds = 0;
+};
+
+// Returns what this frame submitted
+RenderStats renderScene(Scene& scene, float deltaTime);
 
 #endif 
\ No newline at end of file
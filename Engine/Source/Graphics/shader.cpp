@@ -1,5 +1,6 @@
 #include "shader.h"
 #include "Asset/asset.h"
+#include "Graphics/glext.h"
 
 #include <iostream>
 #include <fstream>
@@ -35,10 +36,8 @@ ShaderProgram::ShaderProgram() {
 }
 
 ShaderProgram::~ShaderProgram() {
+    // Attached shaders are deleted by their own destructors once the last reference goes
     glDeleteProgram(id);
-    for (std::shared_ptr<Shader> shader : shaders) {
-        glDeleteShader(shader->id);
-    }
 }
 
 void ShaderProgram::attach(const std::shared_ptr<Shader>& shader) {
@@ -47,24 +46,88 @@ void ShaderProgram::attach(const std::shared_ptr<Shader>& shader) {
 }
 
 bool ShaderProgram::link() {
+    submit();
+    return finish();
+}
+
+void ShaderProgram::submit() {
     for (std::shared_ptr<Shader> shader : shaders) {
-        if (!shader->compile()) {
-            std::cerr << "Shader compilation failed: " << shader->getInfoLog() << std::endl;
-            return false;
-        }
+        glCompileShader(shader->id);
     }
-
+    // A failed compile just fails the link, which finish() reports
     glLinkProgram(id);
+    status = ProgramStatus::Linking;
+}
+
+bool ShaderProgram::isComplete() const {
+    if (status != ProgramStatus::Linking || !gGLExt.parallelShaderCompile) {
+        return true;
+    }
+    int complete = GL_TRUE;
+    glGetProgramiv(id, GL_COMPLETION_STATUS_KHR, &complete);
+    return complete == GL_TRUE;
+}
+
+bool ShaderProgram::finish() {
+    if (status != ProgramStatus::Linking) {
+        return status == ProgramStatus::Linked;
+    }
+
     int success;
     glGetProgramiv(id, GL_LINK_STATUS, &success);
     if (!success) {
+        for (std::shared_ptr<Shader> shader : shaders) {
+            glGetShaderiv(shader->id, GL_COMPILE_STATUS, &success);
+            if (!success) {
+                std::cerr << "Shader compilation failed: " << shader->getInfoLog() << std::endl;
+            }
+        }
         std::cerr << "Shader program linking failed: " << getInfoLog() << std::endl;
+        status = ProgramStatus::Failed;
         return false;
     }
 
+    status = ProgramStatus::Linked;
     return true;
 }
 
+void ShaderProgram::setBinaryRetrievable() {
+    if (gGLExt.programBinary) {
+        gGLExt.programParameteri(id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+}
+
+bool ShaderProgram::getBinary(unsigned int& format, std::vector<unsigned char>& binary) const {
+    if (!gGLExt.programBinary) {
+        return false;
+    }
+
+    int length = 0;
+    glGetProgramiv(id, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return false;
+    }
+
+    binary.resize(length);
+    GLenum binaryFormat = 0;
+    gGLExt.getProgramBinary(id, length, &length, &binaryFormat, binary.data());
+    binary.resize(length);
+    format = binaryFormat;
+    return length > 0;
+}
+
+bool ShaderProgram::loadBinary(unsigned int format, const void* binary, size_t size) {
+    if (!gGLExt.programBinary) {
+        return false;
+    }
+
+    gGLExt.loadProgramBinary(id, format, binary, (GLsizei)size);
+    int success;
+    glGetProgramiv(id, GL_LINK_STATUS, &success);
+    status = success ? ProgramStatus::Linked : ProgramStatus::Failed;
+    return success;
+}
+
 std::string ShaderProgram::getInfoLog() const {
     int length;
     glGetProgramiv(id, GL_INFO_LOG_LENGTH, &length);
@@ -77,32 +140,38 @@ void ShaderProgram::use() const {
     glUseProgram(id);
 }
 
-void ShaderProgram::setUniformInt(const std::string& name, int value)
+void ShaderProgram::setUniformInt(const char* name, int value)
 {
-    GLint location = glGetUniformLocation(id, name.c_str());
+    GLint location = glGetUniformLocation(id, name);
     glUniform1i(location, value);
 }
 
-void ShaderProgram::setUniformFloat(const std::string& name, float value)
+void ShaderProgram::setUniformFloat(const char* name, float value)
 {
-    GLint location = glGetUniformLocation(id, name.c_str());
+    GLint location = glGetUniformLocation(id, name);
     glUniform1f(location, value);
 }
 
-void ShaderProgram::setUniform(const std::string& name, bool value)
+void ShaderProgram::setUniform(const char* name, bool value)
 {
-    GLint location = glGetUniformLocation(id, name.c_str());
+    GLint location = glGetUniformLocation(id, name);
     glUniform1i(location, (int)value);
 }
 
-void ShaderProgram::setUniform(const std::string& name, const glm::vec3& value)
+void ShaderProgram::setUniform(const char* name, const glm::vec3& value)
 {
-    GLint location = glGetUniformLocation(id, name.c_str());
+    GLint location = glGetUniformLocation(id, name);
     glUniform3fv(location, 1, glm::value_ptr(value));
 }
 
-void ShaderProgram::setUniform(const std::string& name, const glm::mat4& value)
+void ShaderProgram::setUniform(const char* name, const glm::mat4& value)
 {
-    GLint location = glGetUniformLocation(id, name.c_str());
+    GLint location = glGetUniformLocation(id, name);
     glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value));
 }
+
+void ShaderProgram::setUniformArray(const char* name, const glm::mat4* values, int count)
+{
+    GLint location = glGetUniformLocation(id, name);
+    glUniformMatrix4fv(location, count, GL_FALSE, glm::value_ptr(values[0]));
+}
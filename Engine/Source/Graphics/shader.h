@@ -6,6 +6,7 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <memory>
 #include <vector>
 #include <string>
 #include <iostream>
@@ -27,30 +28,57 @@ struct Shader {
     std::string getInfoLog() const;
 };
 
+enum class ProgramStatus { Unlinked, Linking, Linked, Failed };
+
 struct ShaderProgram {
     unsigned int id;
     std::vector<std::shared_ptr<Shader>> shaders;
+    ProgramStatus status = ProgramStatus::Unlinked;
 
     ShaderProgram();
     ~ShaderProgram();
 
     void attach(const std::shared_ptr<Shader>& shader);
 
+    // Compiles and links in one blocking call
     bool link();
 
+    // Starts compiling every attached shader and links without querying any
+    // status in between, so the driver is free to work in the background
+    void submit();
+    // Whether the driver is done with a submitted program. Never blocks with
+    // KHR_parallel_shader_compile; without it this is always true and finish()
+    // does the waiting.
+    bool isComplete() const;
+    // Checks compile and link status and logs any errors
+    bool finish();
+    bool isLinked() const { return status == ProgramStatus::Linked; }
+
+    // Program binaries (GL 4.1 / ARB_get_program_binary). Call before link() so
+    // the driver keeps the binary around for getBinary().
+    void setBinaryRetrievable();
+    bool getBinary(unsigned int& format, std::vector<unsigned char>& binary) const;
+    // Restores a binary from getBinary(). False when the driver rejects it, e.g.
+    // after a driver update; the program then has to be compiled from source.
+    bool loadBinary(unsigned int format, const void* binary, size_t size);
+
     std::string getInfoLog() const;
 
     void use() const;
 
-    void setUniformInt(const std::string& name, int value);
+    // Names are plain C strings so per-draw calls never build a std::string
+    void setUniformInt(const char* name, int value);
+
+    void setUniformFloat(const char* name, float value);
 
-    void setUniformFloat(const std::string& name, float value);
+    void setUniform(const char* name, bool value);
 
-    void setUniform(const std::string& name, bool value);
+    void setUniform(const char* name, const glm::vec3& value);
 
-    void setUniform(const std::string& name, const glm::vec3& value);
+    void setUniform(const char* name, const glm::mat4& value);
 
-    void setUniform(const std::string& name, const glm::mat4& value);
+    // Whole uniform array in one call, name is the array itself ("bones", not "bones[0]")
+    void setUniformArray(const char* name, const glm::mat4* values, int count);
 };
 
 #endif 
\ No newline at end of file
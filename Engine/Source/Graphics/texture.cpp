@@ -1 +1,568 @@
-#include "texture.h"
\ No newline at end of file
+#include "texture.h"
+#include "glext.h"
+#include "texturepages.h"
+#include "Core/vfs.h"
+
+#include <glad/glad.h>
+#include <stb_image.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <utility>
+
+#if !defined(TEXTURE_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define TEXTURE_USE_SSSE3 1
+#include <tmmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define TEXTURE_SSSE3_TARGET
+#else
+#define TEXTURE_SSSE3_TARGET __attribute__((target("ssse3")))
+#endif
+#endif
+
+namespace {
+    constexpr int kUploadBufferCount = 3;
+    constexpr size_t kMaxUploadBufferSize = 64 * 1024 * 1024;
+
+    // Free buffers can be reserved from any thread. A reserved buffer belongs to
+    // one Image until its upload; in flight, the GL thread polls its fence.
+    enum class StagingState { Free, Reserved, InFlight };
+
+    struct UploadBuffer {
+        unsigned int id = 0;
+        unsigned char* mapped = nullptr;
+        size_t capacity = 0;
+        StagingState state = StagingState::Free;
+        // Bumped on every reservation, so an Image never releases a later one
+        uint32_t generation = 0;
+        GLsync fence = nullptr;
+        // Texture whose mip chain waits for this buffer's transfer
+        unsigned int pendingMips = 0;
+    };
+
+    // Buffer states and reservations are shared with the workers and go under
+    // the mutex. Everything else, fences included, is GL thread only.
+    struct PixelUploadRing {
+        std::mutex mutex;
+        bool enabled = false;
+        UploadBuffer buffers[kUploadBufferCount];
+        // Largest request no free buffer could hold, the GL thread grows one to it
+        size_t wanted = 0;
+    };
+
+    PixelUploadRing gPixelUploads;
+
+    // Caller holds the mutex. Takes the smallest free buffer that fits.
+    int reserveUploadBuffer(size_t size) {
+        PixelUploadRing& ring = gPixelUploads;
+        if (!ring.enabled || size > kMaxUploadBufferSize) {
+            return -1;
+        }
+        int best = -1;
+        for (int i = 0; i < kUploadBufferCount; i++) {
+            const UploadBuffer& buffer = ring.buffers[i];
+            if (buffer.state == StagingState::Free && buffer.capacity >= size && (best < 0 || buffer.capacity < ring.buffers[best].capacity)) {
+                best = i;
+            }
+        }
+        if (best < 0) {
+            ring.wanted = std::max(ring.wanted, size);
+            return -1;
+        }
+        ring.buffers[best].state = StagingState::Reserved;
+        ring.buffers[best].generation++;
+        return best;
+    }
+
+    void releaseUploadBuffer(int index, uint32_t generation) {
+        PixelUploadRing& ring = gPixelUploads;
+        std::lock_guard<std::mutex> lock(ring.mutex);
+        UploadBuffer& buffer = ring.buffers[index];
+        if (ring.enabled && buffer.state == StagingState::Reserved && buffer.generation == generation) {
+            buffer.state = StagingState::Free;
+        }
+    }
+
+    void generateMips(unsigned int textureID) {
+        glBindTexture(GL_TEXTURE_2D, textureID);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 1000);
+        glGenerateMipmap(GL_TEXTURE_2D);
+    }
+
+    // Immutable storage mapped once for good. The buffer has to be reserved, so
+    // no worker can pick it up halfway.
+    void resizeUploadBuffer(UploadBuffer& buffer, size_t capacity) {
+        if (buffer.id) {
+            // Unmaps it too
+            glDeleteBuffers(1, &buffer.id);
+        }
+        buffer.id = 0;
+        buffer.mapped = nullptr;
+        buffer.capacity = 0;
+
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glGenBuffers(1, &buffer.id);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer.id);
+        gGLExt.bufferStorage(GL_PIXEL_UNPACK_BUFFER, GLsizeiptr(capacity), nullptr, flags);
+        buffer.mapped = static_cast<unsigned char*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, GLsizeiptr(capacity), flags));
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        if (!buffer.mapped) {
+            glDeleteBuffers(1, &buffer.id);
+            buffer.id = 0;
+            return;
+        }
+        buffer.capacity = capacity;
+    }
+
+    // Frees the buffers whose fence has signaled, then grows one if a request
+    // did not fit. Zero timeout: a transfer still running is left for later.
+    void pollUploadBuffers() {
+        PixelUploadRing& ring = gPixelUploads;
+        if (!ring.enabled) {
+            return;
+        }
+        for (UploadBuffer& buffer : ring.buffers) {
+            // A buffer without a fence lost it, the GPU may read it any time
+            if (buffer.state != StagingState::InFlight || !buffer.fence) {
+                continue;
+            }
+            GLenum status = glClientWaitSync(buffer.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+            if (status == GL_TIMEOUT_EXPIRED) {
+                continue;
+            }
+            if (buffer.pendingMips) {
+                generateMips(buffer.pendingMips);
+                buffer.pendingMips = 0;
+            }
+            if (status == GL_WAIT_FAILED) {
+                // Never known to be done, so never written again
+                continue;
+            }
+            glDeleteSync(buffer.fence);
+            buffer.fence = nullptr;
+            std::lock_guard<std::mutex> lock(ring.mutex);
+            buffer.state = StagingState::Free;
+        }
+
+        int grow = -1;
+        size_t capacity = 0;
+        {
+            std::lock_guard<std::mutex> lock(ring.mutex);
+            if (ring.wanted == 0) {
+                return;
+            }
+            // A buffer that fits may be free again by now, but the request
+            // missed because it was busy: grow another one
+            for (int i = 0; i < kUploadBufferCount; i++) {
+                const UploadBuffer& buffer = ring.buffers[i];
+                if (buffer.state == StagingState::Free && buffer.capacity < ring.wanted && (grow < 0 || buffer.capacity < ring.buffers[grow].capacity)) {
+                    grow = i;
+                }
+            }
+            if (grow >= 0) {
+                ring.buffers[grow].state = StagingState::Reserved;
+                capacity = ring.wanted;
+            }
+            ring.wanted = 0;
+        }
+        if (grow >= 0) {
+            resizeUploadBuffer(ring.buffers[grow], capacity);
+            std::lock_guard<std::mutex> lock(ring.mutex);
+            ring.buffers[grow].state = StagingState::Free;
+        }
+    }
+
+    GLenum getPixelFormat(int channels) {
+        if (channels == 1)
+            return GL_RED;
+        if (channels == 4)
+            return GL_RGBA;
+        return GL_RGB;
+    }
+
+    // Allocates level 0 of a mipmapped, repeating texture and leaves it bound
+    unsigned int createTexture2D(int width, int height, int channels) {
+        unsigned int textureID;
+        glGenTextures(1, &textureID);
+        glBindTexture(GL_TEXTURE_2D, textureID);
+
+        // Texture Wrapping Parameters
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+        // Texture Filtering Parameters
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        // Rows of RGB and single channel images are not 4 byte aligned
+        glPixelStorei(GL_UNPACK_ALIGNMENT, channels == 4 ? 4 : 1);
+
+        // Sized, so texture array pages can be created with the exact same format.
+        // Allocate first, with no unpack buffer bound there is nothing to read.
+        glTexImage2D(GL_TEXTURE_2D, 0, getTextureInternalFormat(channels), width, height, 0, getPixelFormat(channels), GL_UNSIGNED_BYTE, nullptr);
+        return textureID;
+    }
+
+    // Transfers a reserved buffer into the bound texture. The mip chain would
+    // have to wait for the transfer, so the texture samples its base level only
+    // until pollUploadBuffers sees the fence.
+    void uploadFromBuffer(int index, unsigned int textureID, int width, int height, int channels) {
+        UploadBuffer& buffer = gPixelUploads.buffers[index];
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer.id);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, getPixelFormat(channels), GL_UNSIGNED_BYTE, nullptr);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+
+        buffer.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        buffer.pendingMips = textureID;
+        if (!buffer.fence) {
+            // Nothing to poll: mips now, and the buffer stays in flight for good
+            generateMips(textureID);
+            buffer.pendingMips = 0;
+        }
+        std::lock_guard<std::mutex> lock(gPixelUploads.mutex);
+        buffer.state = StagingState::InFlight;
+    }
+
+#ifdef TEXTURE_USE_SSSE3
+    bool hasSsse3() {
+#ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 1);
+        return (info[2] & (1 << 9)) != 0;
+#else
+        return __builtin_cpu_supports("ssse3");
+#endif
+    }
+
+    // 16 pixels per iteration: three 16 byte loads realigned so each register
+    // starts on a pixel, then one shuffle and alpha or per four pixels
+    TEXTURE_SSSE3_TARGET size_t expandRgbToRgbaSsse3(const unsigned char* rgb, unsigned char* rgba, size_t pixelCount) {
+        const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+        const __m128i alpha = _mm_set1_epi32((int)0xFF000000);
+
+        size_t i = 0;
+        for (; i + 16 <= pixelCount; i += 16) {
+            __m128i a = _mm_loadu_si128((const __m128i*)(rgb + i * 3));
+            __m128i b = _mm_loadu_si128((const __m128i*)(rgb + i * 3 + 16));
+            __m128i c = _mm_loadu_si128((const __m128i*)(rgb + i * 3 + 32));
+
+            __m128i* out = (__m128i*)(rgba + i * 4);
+            _mm_storeu_si128(out + 0, _mm_or_si128(_mm_shuffle_epi8(a, shuffle), alpha));
+            _mm_storeu_si128(out + 1, _mm_or_si128(_mm_shuffle_epi8(_mm_alignr_epi8(b, a, 12), shuffle), alpha));
+            _mm_storeu_si128(out + 2, _mm_or_si128(_mm_shuffle_epi8(_mm_alignr_epi8(c, b, 8), shuffle), alpha));
+            _mm_storeu_si128(out + 3, _mm_or_si128(_mm_shuffle_epi8(_mm_srli_si128(c, 4), shuffle), alpha));
+        }
+        return i;
+    }
+#endif
+}
+
+Image::~Image() {
+    if (staging >= 0) {
+        releaseUploadBuffer(staging, stagingGeneration);
+    }
+    else if (pixels) {
+        stbi_image_free(pixels);
+    }
+}
+
+Image::Image(Image&& other) noexcept {
+    *this = std::move(other);
+}
+
+Image& Image::operator=(Image&& other) noexcept {
+    if (this != &other) {
+        if (staging >= 0) {
+            releaseUploadBuffer(staging, stagingGeneration);
+        }
+        else if (pixels) {
+            stbi_image_free(pixels);
+        }
+        pixels = std::exchange(other.pixels, nullptr);
+        width = std::exchange(other.width, 0);
+        height = std::exchange(other.height, 0);
+        channels = std::exchange(other.channels, 0);
+        staging = std::exchange(other.staging, -1);
+        stagingGeneration = std::exchange(other.stagingGeneration, 0);
+    }
+    return *this;
+}
+
+bool loadImage(const std::string& filePath, Image& image, int desiredChannels) {
+    // Decode straight out of the page cache instead of through stdio buffers
+    MappedFile file;
+    if (mapVirtualFile(gVFS, filePath, file) != FileError::None) {
+        return false;
+    }
+    return loadImageFromMemory(file.data, file.size, desiredChannels, image);
+}
+
+bool loadImageFromMemory(const unsigned char* data, size_t size, int desiredChannels, Image& image) {
+    Image decoded;
+    decoded.pixels = stbi_load_from_memory(data, (int)size, &decoded.width, &decoded.height, &decoded.channels, desiredChannels);
+    if (!decoded.pixels) {
+        return false;
+    }
+    if (desiredChannels != 0) {
+        decoded.channels = desiredChannels;
+    }
+    image = std::move(decoded);
+    return true;
+}
+
+void expandRgbToRgba(const unsigned char* rgb, unsigned char* rgba, size_t pixelCount) {
+    size_t i = 0;
+#ifdef TEXTURE_USE_SSSE3
+    static const bool ssse3 = hasSsse3();
+    if (ssse3) {
+        i = expandRgbToRgbaSsse3(rgb, rgba, pixelCount);
+    }
+#endif
+    for (; i < pixelCount; i++) {
+        rgba[i * 4 + 0] = rgb[i * 3 + 0];
+        rgba[i * 4 + 1] = rgb[i * 3 + 1];
+        rgba[i * 4 + 2] = rgb[i * 3 + 2];
+        rgba[i * 4 + 3] = 255;
+    }
+}
+
+void expandToRgba(Image& image) {
+    if (!image.pixels || image.channels != 3) {
+        return;
+    }
+
+    // stb frees with free() (Compile/stb.cpp keeps the default allocator)
+    size_t pixelCount = size_t(image.width) * image.height;
+    unsigned char* rgba = (unsigned char*)std::malloc(pixelCount * 4);
+    if (!rgba) {
+        return;
+    }
+    expandRgbToRgba(image.pixels, rgba, pixelCount);
+
+    stbi_image_free(image.pixels);
+    image.pixels = rgba;
+    image.channels = 4;
+}
+
+bool stageImage(Image& image) {
+    if (!image.pixels || image.staging >= 0 || (image.channels != 3 && image.channels != 4)) {
+        return false;
+    }
+
+    PixelUploadRing& ring = gPixelUploads;
+    size_t pixelCount = size_t(image.width) * image.height;
+    int index;
+    unsigned char* mapped;
+    {
+        std::lock_guard<std::mutex> lock(ring.mutex);
+        index = reserveUploadBuffer(pixelCount * 4);
+        if (index < 0) {
+            return false;
+        }
+        mapped = ring.buffers[index].mapped;
+        image.stagingGeneration = ring.buffers[index].generation;
+    }
+
+    // Reserved, so the GL thread leaves the buffer alone until the upload
+    if (image.channels == 3) {
+        expandRgbToRgba(image.pixels, mapped, pixelCount);
+    }
+    else {
+        std::memcpy(mapped, image.pixels, pixelCount * 4);
+    }
+    stbi_image_free(image.pixels);
+    image.pixels = mapped;
+    image.channels = 4;
+    image.staging = index;
+    return true;
+}
+
+void initTextureUploads() {
+    PixelUploadRing& ring = gPixelUploads;
+    std::lock_guard<std::mutex> lock(ring.mutex);
+    // Buffers are sized by the first requests that miss
+    ring.enabled = gGLExt.persistentMapping;
+}
+
+void shutdownTextureUploads() {
+    PixelUploadRing& ring = gPixelUploads;
+    if (!ring.enabled) {
+        return;
+    }
+    finishTextureUploads();
+    std::lock_guard<std::mutex> lock(ring.mutex);
+    for (UploadBuffer& buffer : ring.buffers) {
+        if (buffer.fence) {
+            glDeleteSync(buffer.fence);
+        }
+        if (buffer.id) {
+            glDeleteBuffers(1, &buffer.id);
+        }
+        // Generations carry over, an Image that outlived the ring must never match
+        uint32_t generation = buffer.generation;
+        buffer = UploadBuffer{};
+        buffer.generation = generation;
+    }
+    ring.enabled = false;
+    ring.wanted = 0;
+}
+
+void updateTextureUploads() {
+    pollUploadBuffers();
+}
+
+void finishTextureUpload(unsigned int textureID) {
+    if (textureID == 0) {
+        return;
+    }
+    for (UploadBuffer& buffer : gPixelUploads.buffers) {
+        if (buffer.pendingMips == textureID) {
+            generateMips(textureID);
+            buffer.pendingMips = 0;
+        }
+    }
+}
+
+void finishTextureUploads() {
+    for (UploadBuffer& buffer : gPixelUploads.buffers) {
+        if (buffer.pendingMips) {
+            generateMips(buffer.pendingMips);
+            buffer.pendingMips = 0;
+        }
+    }
+}
+
+unsigned int uploadTexture2D(const unsigned char* pixels, int width, int height, int channels) {
+    if (!pixels) {
+        return 0;
+    }
+
+    PixelUploadRing& ring = gPixelUploads;
+    pollUploadBuffers();
+    size_t size = size_t(width) * height * channels;
+    int staged;
+    {
+        std::lock_guard<std::mutex> lock(ring.mutex);
+        staged = reserveUploadBuffer(size);
+    }
+
+    unsigned int textureID = createTexture2D(width, height, channels);
+    if (staged >= 0) {
+        // Not decoded on a worker, so the copy into the ring happens here
+        std::memcpy(ring.buffers[staged].mapped, pixels, size);
+        uploadFromBuffer(staged, textureID, width, height, channels);
+    }
+    else {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, getPixelFormat(channels), GL_UNSIGNED_BYTE, pixels);
+        glGenerateMipmap(GL_TEXTURE_2D);
+    }
+    return textureID;
+}
+
+unsigned int uploadImage(const Image& image) {
+    if (image.staging < 0) {
+        return uploadTexture2D(image.pixels, image.width, image.height, image.channels);
+    }
+
+    PixelUploadRing& ring = gPixelUploads;
+    bool reserved;
+    {
+        std::lock_guard<std::mutex> lock(ring.mutex);
+        const UploadBuffer& buffer = ring.buffers[image.staging];
+        reserved = ring.enabled && buffer.state == StagingState::Reserved && buffer.generation == image.stagingGeneration;
+    }
+    if (!reserved) {
+        // Uploaded before, the buffer may hold someone else's pixels by now
+        return 0;
+    }
+
+    unsigned int textureID = createTexture2D(image.width, image.height, image.channels);
+    uploadFromBuffer(image.staging, textureID, image.width, image.height, image.channels);
+    return textureID;
+}
+
+unsigned int uploadCompressedTexture2D(unsigned int internalFormat, const CompressedLevel* levels, int levelCount, int baseLevel) {
+    if (internalFormat == 0 || baseLevel < 0 || baseLevel >= levelCount) {
+        return 0;
+    }
+
+    unsigned int textureID;
+    glGenTextures(1, &textureID);
+    glBindTexture(GL_TEXTURE_2D, textureID);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, levelCount > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, baseLevel);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levelCount - 1);
+
+    // The mip chain comes from the cooker, nothing is generated here. Levels above
+    // the base are left unspecified, they don't count towards completeness.
+    for (int level = baseLevel; level < levelCount; level++) {
+        glCompressedTexImage2D(GL_TEXTURE_2D, level, internalFormat, levels[level].width, levels[level].height, 0, (GLsizei)levels[level].size, levels[level].data);
+    }
+
+    if (glGetError() != GL_NO_ERROR) {
+        glDeleteTextures(1, &textureID);
+        return 0;
+    }
+    return textureID;
+}
+
+bool uploadCompressedLevel(unsigned int textureID, unsigned int internalFormat, int level, const CompressedLevel& data) {
+    glBindTexture(GL_TEXTURE_2D, textureID);
+    glCompressedTexImage2D(GL_TEXTURE_2D, level, internalFormat, data.width, data.height, 0, (GLsizei)data.size, data.data);
+    if (glGetError() != GL_NO_ERROR) {
+        return false;
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+    return true;
+}
+
+void releaseCompressedLevel(unsigned int textureID, unsigned int internalFormat, int level) {
+    glBindTexture(GL_TEXTURE_2D, textureID);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level + 1);
+    // Respecifying as empty is the only way GL 3.3 has to drop a single level
+    glCompressedTexImage2D(GL_TEXTURE_2D, level, internalFormat, 0, 0, 0, 0, nullptr);
+}
+
+void destroyTexture(Texture& texture) {
+    releaseIndexableTexture(texture);
+    if (texture.id != 0) {
+        // Its mips are no longer wanted, and the name may be reused
+        for (UploadBuffer& buffer : gPixelUploads.buffers) {
+            if (buffer.pendingMips == texture.id) {
+                buffer.pendingMips = 0;
+            }
+        }
+        glDeleteTextures(1, &texture.id);
+        texture.id = 0;
+    }
+}
+
+int getTextureInternalFormat(int channels) {
+    if (channels == 1)
+        return GL_R8;
+    if (channels == 4)
+        return GL_RGBA8;
+    return GL_RGB8;
+}
+
+int getTextureLevelCount(int width, int height) {
+    int levels = 1;
+    while ((width | height) >> levels) {
+        levels++;
+    }
+    return levels;
+}
+
+size_t getTextureMemory(int width, int height, int channels) {
+    // A full mip chain adds a third on top of the base level
+    size_t base = size_t(width) * height * channels;
+    return base + base / 3;
+}
@@ -2,11 +2,103 @@
 #ifndef TEXTURE_H
 #define TEXTURE_H
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
 struct Texture {
 	unsigned int id;
 	std::string type;
+	// Set for 8-bit uploads with a full mip chain. Left 0 for block compressed and
+	// streamed textures, their levels change after upload so they cannot be packed.
+	int width = 0;
+	int height = 0;
+	int channels = 0;
+	// Texture array page and layer once packed, id is 0 from then on. See texturepages.h
+	int page = -1;
+	int layer = -1;
+	uint64_t bindlessHandle = 0;
 };
 
-#endif 
\ No newline at end of file
+// Decoded pixels owned by stb_image, or by an upload buffer once staged.
+// Decoding and staging are CPU only and safe on any thread, uploading needs the
+// GL context.
+struct Image {
+	unsigned char* pixels = nullptr;
+	int width = 0;
+	int height = 0;
+	int channels = 0;
+	// Upload buffer the pixels live in, -1 while stb_image owns them
+	int staging = -1;
+	uint32_t stagingGeneration = 0;
+
+	Image() = default;
+	~Image();
+
+	Image(const Image&) = delete;
+	Image& operator=(const Image&) = delete;
+	Image(Image&& other) noexcept;
+	Image& operator=(Image&& other) noexcept;
+};
+
+bool loadImage(const std::string& filePath, Image& image, int desiredChannels = 0);
+bool loadImageFromMemory(const unsigned char* data, size_t size, int desiredChannels, Image& image);
+
+// Appends an opaque alpha channel, four pixels per SSSE3 shuffle where the CPU has it
+void expandRgbToRgba(const unsigned char* rgb, unsigned char* rgba, size_t pixelCount);
+// Turns a decoded RGB image into RGBA so the driver can take it as-is instead of
+// converting on the GL thread. Other layouts are left alone. CPU only.
+void expandToRgba(Image& image);
+
+// Stages texel uploads through a ring of persistently mapped pixel unpack
+// buffers. Workers write decoded pixels straight into them with stageImage, the
+// GL thread only issues the transfer. Fences are polled, never waited on: with
+// no buffer free, or without GL 4.4 buffer storage, uploads go direct.
+// Shut down only once no staged Image is left alive.
+void initTextureUploads();
+void shutdownTextureUploads();
+
+// Moves the pixels into a free upload buffer, expanding RGB to RGBA on the way.
+// Any thread. Returns false and leaves the image alone when no buffer fits.
+bool stageImage(Image& image);
+
+// Recycles buffers whose transfer has finished and generates the mip chains
+// that were waiting on them. GL thread, once a frame.
+void updateTextureUploads();
+// Generates a texture's deferred mip chain now, ordered after its transfer on
+// the GPU. Texture pages and bindless handles need the full chain.
+void finishTextureUpload(unsigned int textureID);
+void finishTextureUploads();
+
+// Creates a mipmapped, repeating GL texture. Returns 0 on failure. Uploads out
+// of a staging buffer sample only the base level until the transfer finishes.
+unsigned int uploadTexture2D(const unsigned char* pixels, int width, int height, int channels);
+// A staged image is uploaded out of its buffer, once
+unsigned int uploadImage(const Image& image);
+
+// One block compressed mip level, uploaded as-is
+struct CompressedLevel {
+	const unsigned char* data = nullptr;
+	size_t size = 0;
+	int width = 0;
+	int height = 0;
+};
+
+// Creates a repeating GL texture from a precomputed mip chain, uploading levels
+// baseLevel and smaller. Sampling is clamped to the uploaded levels. Returns 0 on failure.
+unsigned int uploadCompressedTexture2D(unsigned int internalFormat, const CompressedLevel* levels, int levelCount, int baseLevel = 0);
+// Streams in the next larger level of such a texture and starts sampling from it
+bool uploadCompressedLevel(unsigned int textureID, unsigned int internalFormat, int level, const CompressedLevel& data);
+// Stops sampling from the base level and frees it
+void releaseCompressedLevel(unsigned int textureID, unsigned int internalFormat, int level);
+void destroyTexture(Texture& texture);
+
+// Sized GL format uploadTexture2D creates for a channel count
+int getTextureInternalFormat(int channels);
+// Levels of a full mip chain down to 1x1
+int getTextureLevelCount(int width, int height);
+
+// GPU bytes of an uploaded texture including its mip chain
+size_t getTextureMemory(int width, int height, int channels);
+
+#endif
@@ -0,0 +1,290 @@
+#include "texturepages.h"
+#include "glext.h"
+#include "texture.h"
+
+#include <glad/glad.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace {
+    constexpr int kInitialPageLayers = 4;
+
+    // Textures of one format and size. Layers are handed out in order, freed ones
+    // are reused first, and a full page doubles by copying into a larger array.
+    struct TexturePage {
+        unsigned int id = 0;
+        int internalFormat = 0;
+        int channels = 0;
+        int width = 0;
+        int height = 0;
+        int levels = 0;
+        int capacity = 0;
+        int nextLayer = 0;
+        std::vector<int> freeLayers;
+    };
+
+    struct TexturePages {
+        TextureBinding binding = TextureBinding::Slots;
+        std::vector<TexturePage> pages;
+        int maxLayers = 0;
+    };
+
+    TexturePages gTexturePages;
+
+    GLenum getPixelFormat(int channels) {
+        if (channels == 1)
+            return GL_RED;
+        if (channels == 4)
+            return GL_RGBA;
+        return GL_RGB;
+    }
+
+    // Storage for every level, nothing uploaded. Contents are copied in on the GPU.
+    unsigned int createPageArray(const TexturePage& page, int capacity) {
+        unsigned int id;
+        glGenTextures(1, &id);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, id);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, page.levels - 1);
+
+        // With an unpack buffer bound the null pointer would be read as an offset
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        GLenum format = getPixelFormat(page.channels);
+        for (int level = 0; level < page.levels; level++) {
+            int width = std::max(1, page.width >> level);
+            int height = std::max(1, page.height >> level);
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, level, page.internalFormat, width, height, capacity, 0, format, GL_UNSIGNED_BYTE, nullptr);
+        }
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+        if (glGetError() != GL_NO_ERROR) {
+            glDeleteTextures(1, &id);
+            return 0;
+        }
+        return id;
+    }
+
+    bool growPage(TexturePage& page) {
+        int capacity = std::min(page.capacity * 2, gTexturePages.maxLayers);
+        if (capacity <= page.capacity) {
+            return false;
+        }
+
+        unsigned int id = createPageArray(page, capacity);
+        if (id == 0) {
+            spdlog::warn("Failed to grow texture page {}x{} to {} layers", page.width, page.height, capacity);
+            return false;
+        }
+        for (int level = 0; level < page.levels; level++) {
+            int width = std::max(1, page.width >> level);
+            int height = std::max(1, page.height >> level);
+            gGLExt.copyImageSubData(page.id, GL_TEXTURE_2D_ARRAY, level, 0, 0, 0, id, GL_TEXTURE_2D_ARRAY, level, 0, 0, 0, width, height, page.nextLayer);
+        }
+        glDeleteTextures(1, &page.id);
+        page.id = id;
+        page.capacity = capacity;
+        return true;
+    }
+
+    bool allocateLayer(const Texture& texture, int& pageIndex, int& layer) {
+        int internalFormat = getTextureInternalFormat(texture.channels);
+        int levels = getTextureLevelCount(texture.width, texture.height);
+
+        std::vector<TexturePage>& pages = gTexturePages.pages;
+        auto it = std::find_if(pages.begin(), pages.end(), [&](const TexturePage& page) {
+            return page.internalFormat == internalFormat && page.width == texture.width && page.height == texture.height;
+        });
+        if (it == pages.end()) {
+            if ((int)pages.size() >= kMaxTexturePages) {
+                return false;
+            }
+
+            TexturePage page;
+            page.internalFormat = internalFormat;
+            page.channels = texture.channels;
+            page.width = texture.width;
+            page.height = texture.height;
+            page.levels = levels;
+            page.capacity = std::min(kInitialPageLayers, gTexturePages.maxLayers);
+            page.id = createPageArray(page, page.capacity);
+            if (page.id == 0) {
+                return false;
+            }
+            pages.push_back(std::move(page));
+            it = pages.end() - 1;
+        }
+
+        TexturePage& page = *it;
+        if (!page.freeLayers.empty()) {
+            layer = page.freeLayers.back();
+            page.freeLayers.pop_back();
+        }
+        else if (page.nextLayer < page.capacity || growPage(page)) {
+            layer = page.nextLayer++;
+        }
+        else {
+            return false;
+        }
+        pageIndex = int(it - pages.begin());
+        return true;
+    }
+
+    bool packTexture(Texture& texture) {
+        int pageIndex;
+        int layer;
+        if (!allocateLayer(texture, pageIndex, layer)) {
+            return false;
+        }
+
+        // The standalone texture is complete, makeTextureIndexable finished its mips
+        const TexturePage& page = gTexturePages.pages[pageIndex];
+        for (int level = 0; level < page.levels; level++) {
+            int width = std::max(1, page.width >> level);
+            int height = std::max(1, page.height >> level);
+            gGLExt.copyImageSubData(texture.id, GL_TEXTURE_2D, level, 0, 0, 0, page.id, GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, width, height, 1);
+        }
+        glDeleteTextures(1, &texture.id);
+        texture.id = 0;
+        texture.page = pageIndex;
+        texture.layer = layer;
+        return true;
+    }
+
+    bool makeTextureResident(Texture& texture) {
+        // Creating a handle freezes the texture's state and levels for good
+        texture.bindlessHandle = gGLExt.getTextureHandle(texture.id);
+        if (texture.bindlessHandle == 0) {
+            return false;
+        }
+        gGLExt.makeTextureHandleResident(texture.bindlessHandle);
+        return true;
+    }
+}
+
+TextureBinding initTextureBinding(TextureBinding preferred) {
+    TextureBinding binding = preferred;
+    if (binding == TextureBinding::Bindless && !gGLExt.bindlessTexture) {
+        spdlog::warn("Bindless textures are not supported, trying texture arrays");
+        binding = TextureBinding::Arrays;
+    }
+    if (binding == TextureBinding::Arrays && !gGLExt.copyImage) {
+        spdlog::warn("Texture arrays need copy image support, binding textures per material");
+        binding = TextureBinding::Slots;
+    }
+
+    gTexturePages.binding = binding;
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &gTexturePages.maxLayers);
+    spdlog::info("Material textures: {}", getTextureBindingName(binding));
+    return binding;
+}
+
+void shutdownTextureBinding() {
+    for (TexturePage& page : gTexturePages.pages) {
+        glDeleteTextures(1, &page.id);
+    }
+    gTexturePages = TexturePages{};
+}
+
+TextureBinding getTextureBinding() {
+    return gTexturePages.binding;
+}
+
+const char* getTextureBindingName(TextureBinding binding) {
+    switch (binding) {
+    case TextureBinding::Arrays:
+        return "arrays";
+    case TextureBinding::Bindless:
+        return "bindless";
+    default:
+        return "slots";
+    }
+}
+
+bool parseTextureBinding(const char* name, TextureBinding& binding) {
+    for (TextureBinding candidate : { TextureBinding::Slots, TextureBinding::Arrays, TextureBinding::Bindless }) {
+        if (std::strcmp(name, getTextureBindingName(candidate)) == 0) {
+            binding = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+void appendTextureBindingDefines(ShaderDefines& defines) {
+    if (gTexturePages.binding == TextureBinding::Arrays) {
+        defines.push_back({ "TEXTURE_ARRAYS", "" });
+    }
+    else if (gTexturePages.binding == TextureBinding::Bindless) {
+        defines.push_back({ "BINDLESS_TEXTURES", "" });
+    }
+}
+
+bool makeTextureIndexable(Texture& texture) {
+    if (texture.layer >= 0 || texture.bindlessHandle != 0) {
+        return true;
+    }
+    if (texture.id == 0 || texture.width <= 0 || texture.height <= 0) {
+        return false;
+    }
+    // Both copy or freeze every level, a chain still waiting on its transfer is
+    // generated now
+    finishTextureUpload(texture.id);
+
+    switch (gTexturePages.binding) {
+    case TextureBinding::Arrays:
+        return packTexture(texture);
+    case TextureBinding::Bindless:
+        return makeTextureResident(texture);
+    default:
+        return false;
+    }
+}
+
+void releaseIndexableTexture(Texture& texture) {
+    if (texture.bindlessHandle != 0) {
+        gGLExt.makeTextureHandleNonResident(texture.bindlessHandle);
+        texture.bindlessHandle = 0;
+    }
+    if (texture.layer >= 0) {
+        if (texture.page < (int)gTexturePages.pages.size()) {
+            gTexturePages.pages[texture.page].freeLayers.push_back(texture.layer);
+        }
+        texture.page = -1;
+        texture.layer = -1;
+    }
+}
+
+void bindTexturePages() {
+    if (gTexturePages.binding != TextureBinding::Arrays) {
+        return;
+    }
+    for (int i = 0; i < (int)gTexturePages.pages.size(); i++) {
+        glActiveTexture(GL_TEXTURE0 + kTexturePageFirstUnit + i);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, gTexturePages.pages[i].id);
+    }
+}
+
+size_t getTexturePageMemory() {
+    size_t bytes = 0;
+    for (const TexturePage& page : gTexturePages.pages) {
+        bytes += getTextureMemory(page.width, page.height, page.channels) * page.capacity;
+    }
+    return bytes;
+}
+
+void logTexturePages() {
+    if (gTexturePages.binding != TextureBinding::Arrays) {
+        return;
+    }
+    for (const TexturePage& page : gTexturePages.pages) {
+        int used = page.nextLayer - (int)page.freeLayers.size();
+        spdlog::info("Texture page {}x{}x{}: {} of {} layers used", page.width, page.height, page.channels, used, page.capacity);
+    }
+    spdlog::info("Texture pages: {} ({:.1f} MB)", gTexturePages.pages.size(), getTexturePageMemory() / (1024.0 * 1024.0));
+}
@@ -0,0 +1,60 @@
+#pragma once
+#ifndef TEXTURE_PAGES_H
+#define TEXTURE_PAGES_H
+
+#include "Asset/shadersource.h"
+
+#include <cstddef>
+#include <cstdint>
+
+struct Texture;
+
+// How material textures reach the shader. Slots binds each texture to its unit
+// per material. Arrays copies textures of the same format and size into layers
+// of GL_TEXTURE_2D_ARRAY pages that are bound once per frame. Bindless makes
+// every texture resident once and hands the shader 64-bit handles. The last two
+// leave only the material's parameter block to bind per material.
+enum class TextureBinding {
+	Slots,
+	Arrays,
+	Bindless
+};
+
+// Pages live on the units after the material slots, see Include/material.glsl
+constexpr unsigned int kTexturePageFirstUnit = 4;
+constexpr int kMaxTexturePages = 8;
+// Material layer value for a slot that is read from its own unit
+constexpr uint32_t kUnpackedLayer = 0xFFFFFFFF;
+
+// Falls back from Bindless to Arrays to Slots when the driver lacks what a mode
+// needs. Call once after loadGLExtensions; returns the mode in use.
+TextureBinding initTextureBinding(TextureBinding preferred);
+// Deletes the pages. Textures still packed into them are left without storage.
+void shutdownTextureBinding();
+
+TextureBinding getTextureBinding();
+const char* getTextureBindingName(TextureBinding binding);
+// "slots", "arrays" or "bindless"
+bool parseTextureBinding(const char* name, TextureBinding& binding);
+
+// TEXTURE_ARRAYS or BINDLESS_TEXTURES for the mode in use, nothing for Slots.
+// Every program that includes Include/material.glsl needs them.
+void appendTextureBindingDefines(ShaderDefines& defines);
+
+// Packs the texture into a page layer or makes a bindless handle resident,
+// depending on the mode. Textures already made indexable return true at once.
+// False when the texture has to stay on a unit: streamed or compressed ones,
+// or no page with room left.
+bool makeTextureIndexable(Texture& texture);
+// Frees the page layer or drops the handle residency. destroyTexture calls it.
+void releaseIndexableTexture(Texture& texture);
+
+// Binds every page to its unit. Once per frame before the first draw; pages
+// are reallocated when they grow, so the names change between frames.
+void bindTexturePages();
+
+// GPU bytes of all pages, including layers not handed out yet
+size_t getTexturePageMemory();
+void logTexturePages();
+
+#endif
@@ -1,26 +1,147 @@
 #include "scene.h"
 #include "Graphics/animator.h"
+#include "Core/memorytags.h"
+#include "Core/profiler.h"
 
+#include <glm/geometric.hpp>
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
+#include <cmath>
+
 void addObjectToScene(Scene& scene, std::shared_ptr<SceneObject> object) {
     scene.objects.push_back(object);
 }
 
 void loadScene(Scene& scene) {
+    // Assets loaded from here are charged to their own tags
+    MemoryTagScope memoryTag(MemoryTag::Scene);
     scene.camera = std::make_shared<Camera>();
-    //scene.program = loadShader(gAssets, "Assets/Shaders/texture.vert", "Assets/Shaders/texture.frag");
-    scene.program = loadShader(gAssets, "Assets/Shaders/skinned.vert", "Assets/Shaders/texture.frag");
+    scene.fallbackProgram = loadShader(gAssets, "Assets/Shaders/solidcolor.vert", "Assets/Shaders/solidcolor.frag");
+    // Both permutations are submitted before anything waits on a compile. They
+    // are the ones materials without defines use, so the model's materials
+    // find them already compiling.
+    ShaderDefines staticDefines;
+    appendTextureBindingDefines(staticDefines);
+    ShaderDefines skinnedDefines = staticDefines;
+    skinnedDefines.push_back({ "SKINNED", "" });
+    skinnedDefines.push_back({ "BONES_PER_VERTEX", "4" });
+    scene.staticProgram = loadShader(gAssets, "Assets/Shaders/texture.vert", "Assets/Shaders/texture.frag", staticDefines);
+    scene.skinnedProgram = loadShader(gAssets, "Assets/Shaders/texture.vert", "Assets/Shaders/texture.frag", skinnedDefines);
+
+    for (Handle<ShaderProgram> handle : { scene.fallbackProgram, scene.staticProgram, scene.skinnedProgram }) {
+        gAssets.shaders.addRef(handle);
+    }
+    if (!waitForShader(gAssets, scene.fallbackProgram)) {
+        spdlog::error("Fallback shader failed, objects are skipped until their own shaders are ready");
+    }
 
     auto player = std::make_shared<SceneObject>();
     player->name = "Player";
     player->position = glm::vec3(0.0f, 0.0f, 0.0f);
     player->rotation = glm::vec3(0.0f, 0.0f, 0.0f);
     player->scale = glm::vec3(0.1f);
-    player->model = loadModel(gAssets, "Assets/Meshes/Maria J J Ong.fbx");
-    player->animator = new Animator(loadAnimation(gAssets, "Assets/Animations/Twist Dance.fbx"), player->model);
 
-    player->animator->PlayAnimation(loadAnimation(gAssets, "Assets/Animations/Dying (1).fbx"), player->model);
+    PendingObject pending;
+    pending.object = player;
+    pending.model = loadModelAsync(gAssets, gLoader, "Assets/Meshes/Maria J J Ong.fbx");
+    pending.animations.push_back(loadAnimationAsync(gAssets, gLoader, "Assets/Animations/Twist Dance.fbx"));
+    pending.animations.push_back(loadAnimationAsync(gAssets, gLoader, "Assets/Animations/Dying (1).fbx"));
+    scene.pending.push_back(pending);
+}
+
+void updateScene(Scene& scene) {
+    PROFILE_ZONE("updateScene");
+    for (auto it = scene.pending.begin(); it != scene.pending.end();) {
+        PendingObject& pending = *it;
+
+        bool failed = pending.model.isFailed();
+        bool ready = pending.model.isReady();
+        for (const AssetFuture<Animation>& animation : pending.animations) {
+            failed |= animation.isFailed();
+            ready &= animation.isReady();
+        }
+
+        if (failed) {
+            spdlog::error("Failed to load assets for {}", pending.object->name);
+            it = scene.pending.erase(it);
+            continue;
+        }
+        if (!ready) {
+            ++it;
+            continue;
+        }
+
+        std::shared_ptr<SceneObject> object = pending.object;
+        object->model = pending.model.getHandle();
+        gAssets.models.addRef(object->model);
+        for (const AssetFuture<Animation>& animation : pending.animations) {
+            object->animations.push_back(animation.getHandle());
+            gAssets.animations.addRef(animation.getHandle());
+        }
+
+        Model* model = pending.model.get();
+        if (!pending.animations.empty()) {
+            object->animator = new Animator(pending.animations[0].get(), model);
+            for (size_t i = 1; i < pending.animations.size(); i++) {
+                object->animator->PlayAnimation(pending.animations[i].get(), model);
+            }
+        }
+
+        addObjectToScene(scene, object);
+        it = scene.pending.erase(it);
+    }
+}
+
+void streamSceneTextures(Scene& scene, float fieldOfView, float viewportHeight) {
+    PROFILE_ZONE("streamSceneTextures");
+    // Screen pixels covered by one world unit at distance 1
+    float pixelsPerUnit = viewportHeight / (2.0f * std::tan(fieldOfView * 0.5f));
+    glm::vec3 eye = scene.camera->getPosition();
+
+    for (const std::shared_ptr<SceneObject>& object : scene.objects) {
+        Model* model = gAssets.models.get(object->model);
+        if (!model || model->worldUnitsPerUv <= 0.0f) {
+            continue;
+        }
+
+        // Nearest point of the bounding sphere, so large objects get the detail
+        // their closest surface needs
+        float scale = std::max(object->scale.x, std::max(object->scale.y, object->scale.z));
+        glm::vec3 center = glm::vec3(getWorldMatrix(*object) * glm::vec4(model->boundsCenter, 1.0f));
+        float distance = std::max(glm::length(center - eye) - model->boundsRadius * scale, 0.1f);
+
+        float screenPixelsPerUv = pixelsPerUnit / distance * model->worldUnitsPerUv * scale;
+        for (Handle<Material> handle : model->materials) {
+            const Material* material = gAssets.materials.get(handle);
+            if (!material) {
+                continue;
+            }
+            for (Handle<Texture> texture : material->textures) {
+                if (texture.isValid()) {
+                    requestTextureMip(gAssets.streaming, texture, screenPixelsPerUv);
+                }
+            }
+        }
+    }
+}
+
+void unloadScene(Scene& scene) {
+    for (std::shared_ptr<SceneObject>& object : scene.objects) {
+        gAssets.models.release(object->model);
+        for (Handle<Animation> animation : object->animations) {
+            gAssets.animations.release(animation);
+        }
+        delete object->animator;
+        object->animator = nullptr;
+    }
+    scene.objects.clear();
+    scene.pending.clear();
 
-    addObjectToScene(scene, player);
+    gAssets.shaders.release(scene.staticProgram);
+    gAssets.shaders.release(scene.skinnedProgram);
+    gAssets.shaders.release(scene.fallbackProgram);
+    scene.staticProgram = {};
+    scene.skinnedProgram = {};
+    scene.fallbackProgram = {};
 }
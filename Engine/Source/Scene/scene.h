@@ -3,6 +3,7 @@
 #define SCENE_H
 
 #include "Asset/asset.h"
+#include "Asset/asyncloader.h"
 #include "Scene/sceneobject.h"
 #include "Graphics/shader.h"
 #include "Graphics/camera.h"
@@ -10,13 +11,32 @@
 #include <vector>
 #include <functional>
 
+// Object waiting for its assets to stream in. The first animation is bound when the
+// animator is created, any further ones are played in order.
+struct PendingObject {
+	std::shared_ptr<SceneObject> object;
+	AssetFuture<Model> model;
+	std::vector<AssetFuture<Animation>> animations;
+};
+
 struct Scene {
 	std::vector<std::shared_ptr<SceneObject>> objects;
+	std::vector<PendingObject> pending;
 	std::shared_ptr<Camera> camera;
-    ShaderProgram* program;
+    // Default material permutations, submitted before any model arrives so
+    // materials find them compiling. The static one has no bone math.
+    Handle<ShaderProgram> staticProgram;
+    Handle<ShaderProgram> skinnedProgram;
+    // Linked before the first frame and drawn with while the others compile
+    Handle<ShaderProgram> fallbackProgram;
 };
 
 void addObjectToScene(Scene& scene, std::shared_ptr<SceneObject> object);
 void loadScene(Scene& scene);
+void updateScene(Scene& scene);
+// Asks texture streaming for the mip levels each object needs at its projected size
+void streamSceneTextures(Scene& scene, float fieldOfView, float viewportHeight);
+// Drops the scene's asset references so the next collect can evict them
+void unloadScene(Scene& scene);
 
 #endif 
@@ -1,8 +1,17 @@
 #include "sceneobject.h"
 
+#include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtx/string_cast.hpp>
 #include <spdlog/spdlog.h>
 
+glm::mat4 getWorldMatrix(const SceneObject& object) {
+    return glm::translate(glm::mat4(1.0f), object.position) *
+        glm::rotate(glm::mat4(1.0f), glm::radians(object.rotation.x), glm::vec3(1, 0, 0)) *
+        glm::rotate(glm::mat4(1.0f), glm::radians(object.rotation.y), glm::vec3(0, 1, 0)) *
+        glm::rotate(glm::mat4(1.0f), glm::radians(object.rotation.z), glm::vec3(0, 0, 1)) *
+        glm::scale(glm::mat4(1.0f), object.scale);
+}
+
 void printObject(SceneObject& object) {
 	spdlog::info("Object Name: {}", object.name);
 	spdlog::info("Object Position: {}", glm::to_string(object.position));
@@ -2,24 +2,33 @@
 #ifndef SCENE_OBJECT_H
 #define SCENE_OBJECT_H
 
+#include "Asset/handle.h"
+
+#include <glm/mat4x4.hpp>
 #include <glm/vec3.hpp>
 
 #include <memory>
 #include <functional>
 #include <string>
+#include <vector>
 
 struct Model;
 struct Animator;
+class Animation;
 
 struct SceneObject {
     std::string name;
     glm::vec3 position;
     glm::vec3 rotation;
     glm::vec3 scale;
-    Model* model;
-    Animator* animator;
+    Handle<Model> model;
+    std::vector<Handle<Animation>> animations;
+    Animator* animator = nullptr;
 };
 
+// Local to world transform from position, rotation (degrees) and scale
+glm::mat4 getWorldMatrix(const SceneObject& object);
+
 void printObject(SceneObject& object);
 
 #endif 
\ No newline at end of file
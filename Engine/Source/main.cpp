@@ -1,6 +1,21 @@
 #include "Asset/asset.h"
+#include "Asset/asyncloader.h"
+#include "Core/arena.h"
+#include "Core/benchmark.h"
+#include "Core/filequeue.h"
+#include "Core/framestats.h"
+#include "Core/jobs.h"
+#include "Core/memorytags.h"
+#include "Core/profiler.h"
+#include "Core/vfs.h"
 #include "Scene/scene.h"
+#include "Graphics/glbackend.h"
+#include "Graphics/glext.h"
+#include "Graphics/gputimer.h"
+#include "Graphics/nullgl.h"
+#include "Graphics/perfhud.h"
 #include "Graphics/renderer.h"
+#include "Graphics/texturepages.h"
 
 #include <glad/glad.h>
 #include <SDL.h>
@@ -10,9 +25,29 @@
 #include <glm/ext/matrix_clip_space.hpp>
 #include <stb_image.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+
+// Written by --pack, mounted under the loose files when present
+#define GAME_PACK_PATH "Packs/game.pak"
+// Written on F9 or SIGUSR1
+#define MEMORY_REPORT_PATH "memory.json"
+// Written after a --frames run unless --benchmark-report names another file
+#define BENCHMARK_REPORT_PATH "benchmark.json"
+// Written on F10 with the frames before it, or by --trace-frames first:last
+#define TRACE_PATH "trace.json"
+#define TRACE_HOTKEY_FRAMES 120
+// Frames the HUD's percentiles and graphs cover
+#define FRAME_STATS_WINDOW 600
+
 struct App {
     SDL_Window* m_window = nullptr;
     SDL_GLContext m_glContext{};
+    HeadlessContext m_headless; // Used instead of the window by --backend egl and null
 };
 
 void initWindow(App& app, const char* title, int width, int height, bool fullscreen) {
@@ -21,7 +56,7 @@ void initWindow(App& app, const char* title, int width, int height, bool fullscr
     }
 
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 4);
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 6);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 5);
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
 
     const Uint32 windowFlags = (SDL_WINDOW_OPENGL | (fullscreen ? SDL_WINDOW_RESIZABLE : 0));
@@ -42,63 +77,394 @@ void initWindow(App& app, const char* title, int width, int height, bool fullscr
         SDL_GL_DeleteContext(app.m_glContext);
         SDL_DestroyWindow(app.m_window);
         SDL_Quit();
+        return;
+    }
+
+    loadGLExtensions(SDL_GL_GetProcAddress);
+}
+
+bool initHeadless(App& app, GLBackend backend, int width, int height) {
+    // Timer and events only, video would need a display
+    if (SDL_Init(SDL_INIT_TIMER | SDL_INIT_EVENTS) != 0) {
+        spdlog::error("SDL Init {}", SDL_GetError());
+    }
+    if (!initHeadlessContext(app.m_headless, backend, width, height)) {
+        SDL_Quit();
+        return false;
+    }
+    return true;
+}
+
+void present(App& app) {
+    PROFILE_ZONE("present");
+    if (app.m_window) {
+        SDL_GL_SwapWindow(app.m_window);
+    }
+    else {
+        presentHeadlessFrame(app.m_headless);
     }
 }
 
 void shutdown(App& app) {
-    SDL_GL_DeleteContext(app.m_glContext);
-    SDL_DestroyWindow(app.m_window);
+    if (app.m_window) {
+        SDL_GL_DeleteContext(app.m_glContext);
+        SDL_DestroyWindow(app.m_window);
+    }
+    else {
+        shutdownHeadlessContext(app.m_headless);
+    }
     SDL_Quit();
 }
 
+void writeTrace(uint64_t firstFrame, uint64_t lastFrame) {
+    if (writeChromeTrace(TRACE_PATH, firstFrame, lastFrame)) {
+        spdlog::info("Frames {} to {} traced to {}", firstFrame, lastFrame, TRACE_PATH);
+    }
+    else {
+        spdlog::error("Failed to write trace {}", TRACE_PATH);
+    }
+}
+
 std::vector<SDL_Event>& getFrameEvents() {
-    static std::vector<SDL_Event> frameEvents;
+    static std::vector<SDL_Event> frameEvents = [] {
+        std::vector<SDL_Event> events;
+        events.reserve(64);
+        return events;
+    }();
     return frameEvents;
 }
 
 int main(int argc, char* argv[]) {
+    PROFILE_THREAD("Main");
+    // Before cooking too, so cooked textures match what the runtime decodes
+    stbi_set_flip_vertically_on_load(true);
+
+    // Cooking compresses on the workers too
+    gJobs.start();
+
+    bool benchmarkTextures = false;
+    // Opt in to packed or bindless material textures, falls back per driver
+    TextureBinding textureBinding = TextureBinding::Slots;
+    // Runs without a display: --backend egl|null, usually with --frames N
+    GLBackend backend = GLBackend::Window;
+    int benchmarkFrames = 0;
+    std::string benchmarkReportPath = BENCHMARK_REPORT_PATH;
+    // Frames counted from 1, the trace is written once the last one has ended
+    unsigned long long traceFirstFrame = 0;
+    unsigned long long traceLastFrame = 0;
+    // Timer queries around render passes, read back a few frames late
+    GpuTimerDetail gpuTimerDetail = GpuTimerDetail::Passes;
+    bool gpuPipelineStatistics = false;
+    // Overlay shown from the start instead of on F3, window backend only
+    bool showPerfHud = false;
+    // Every frame's sample written at exit, .csv or JSON
+    std::string frameStatsPath;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--cook") == 0) {
+            return cookGameAssets() ? 0 : 1;
+        }
+        if (std::strcmp(argv[i], "--pack") == 0) {
+            return packGameAssets(GAME_PACK_PATH) ? 0 : 1;
+        }
+        if (std::strcmp(argv[i], "--benchmark-jobs") == 0) {
+            return benchmarkJobSystem(gJobs) ? 0 : 1;
+        }
+        if (std::strcmp(argv[i], "--benchmark-profiler") == 0) {
+            return benchmarkProfiler() ? 0 : 1;
+        }
+        if (std::strcmp(argv[i], "--benchmark-textures") == 0) {
+            benchmarkTextures = true;
+        }
+        if (std::strcmp(argv[i], "--texture-binding") == 0 && i + 1 < argc) {
+            if (!parseTextureBinding(argv[++i], textureBinding)) {
+                spdlog::warn("Unknown texture binding {}, expected slots, arrays or bindless", argv[i]);
+            }
+        }
+        if (std::strcmp(argv[i], "--backend") == 0 && i + 1 < argc) {
+            if (!parseGLBackend(argv[++i], backend)) {
+                spdlog::warn("Unknown backend {}, expected window, egl or null", argv[i]);
+            }
+        }
+        if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            benchmarkFrames = std::max(0, std::atoi(argv[++i]));
+        }
+        if (std::strcmp(argv[i], "--benchmark-report") == 0 && i + 1 < argc) {
+            benchmarkReportPath = argv[++i];
+        }
+        if (std::strcmp(argv[i], "--gpu-timers") == 0 && i + 1 < argc) {
+            if (!parseGpuTimerDetail(argv[++i], gpuTimerDetail)) {
+                spdlog::warn("Unknown GPU timer detail {}, expected off, passes or draws", argv[i]);
+            }
+        }
+        if (std::strcmp(argv[i], "--gpu-pipeline-stats") == 0) {
+            gpuPipelineStatistics = true;
+        }
+        if (std::strcmp(argv[i], "--hud") == 0) {
+            showPerfHud = true;
+        }
+        if (std::strcmp(argv[i], "--frame-stats") == 0 && i + 1 < argc) {
+            frameStatsPath = argv[++i];
+        }
+        if (std::strcmp(argv[i], "--trace-frames") == 0 && i + 1 < argc) {
+            if (std::sscanf(argv[++i], "%llu:%llu", &traceFirstFrame, &traceLastFrame) != 2 || traceFirstFrame > traceLastFrame) {
+                spdlog::warn("Invalid trace range {}, expected first:last", argv[i]);
+                traceFirstFrame = traceLastFrame = 0;
+            }
+        }
+    }
+
+    using Clock = std::chrono::steady_clock;
+    auto elapsedMilliseconds = [](Clock::time_point from, Clock::time_point to) {
+        return std::chrono::duration<float, std::milli>(to - from).count();
+    };
+
+    // Loose files win over the pack so edited assets show up without repacking
+    std::error_code error;
+    if (std::filesystem::exists(GAME_PACK_PATH, error) && !mountPack(gVFS, "", GAME_PACK_PATH)) {
+        spdlog::error("Failed to mount {}", GAME_PACK_PATH);
+    }
+    mountDirectory(gVFS, "", ".");
+
     App app;
     Scene scene;
 
-	initWindow(app, "Game", 1280, 720, true);
-
-    stbi_set_flip_vertically_on_load(true);
+    Clock::time_point startupBegin = Clock::now();
+    if (backend == GLBackend::Window) {
+        initWindow(app, "Game", 1280, 720, true);
+    }
+    else if (!initHeadless(app, backend, 1280, 720)) {
+        gJobs.stop();
+        return 1;
+    }
+    Clock::time_point windowReady = Clock::now();
 
     glEnable(GL_DEPTH_TEST);
 
+    gFileReads.start(gVFS);
+    startAsyncLoader(gLoader);
+
+    if (benchmarkTextures) {
+        benchmarkTextureLoading(gLoader, "Assets/Textures");
+        stopAsyncLoader(gLoader);
+        gFileReads.stop();
+        shutdownTextureUploads();
+        shutdown(app);
+        return 0;
+    }
+
+    installMemoryReportSignal();
+    initTextureUploads();
+    // Before any material or shader is created, the mode picks their permutation
+    initTextureBinding(textureBinding);
+    initGpuTimers(gpuTimerDetail, gpuPipelineStatistics);
+    if (app.m_window) {
+        initPerfHud(app.m_window, app.m_glContext, showPerfHud);
+    }
+    else if (showPerfHud) {
+        spdlog::warn("The HUD needs a window, use --frame-stats to record a headless run");
+    }
     loadGameAssets();
+    Clock::time_point assetsStarted = Clock::now();
     loadScene(scene);
+    Clock::time_point sceneStarted = Clock::now();
+    if (benchmarkFrames > 0) {
+        // Measure the steady state, not the loads trickling in
+        waitForLoads(gLoader);
+    }
+
+    spdlog::info("Startup: window and context {:.2f} ms, asset setup {:.2f} ms (shaders {:.2f} ms, {} compiled, {} cached), scene {:.2f} ms, total {:.2f} ms",
+        elapsedMilliseconds(startupBegin, windowReady), elapsedMilliseconds(windowReady, assetsStarted),
+        gAssets.stats.shaderMilliseconds, gAssets.stats.shadersCompiled, gAssets.stats.shadersFromCache,
+        elapsedMilliseconds(assetsStarted, sceneStarted), elapsedMilliseconds(startupBegin, sceneStarted));
+
+    // Frame and phase times come from the performance counter, SDL_GetTicks is
+    // only good to a millisecond
+    const double counterMilliseconds = 1000.0 / double(SDL_GetPerformanceFrequency());
+    Uint64 lastFrameStart = SDL_GetPerformanceCounter();
+    FrameStats frameStats;
+    initFrameStats(frameStats, FRAME_STATS_WINDOW);
+    std::vector<FrameSample> frameStatsRun;
+    if (!frameStatsPath.empty()) {
+        // A minute at 60 Hz without --frames, longer runs grow it
+        frameStatsRun.reserve(benchmarkFrames > 0 ? benchmarkFrames : 3600);
+    }
+
+    Uint32 currentTime;
+    // Streaming and shader compiles settle in over the first frames, after
+    // that a frame should not touch the heap
+    const int allocationWarmupFrames = 120;
+    int frameIndex = 0;
+    Uint32 lastAllocationWarning = 0;
 
-    Uint32 lastTime = SDL_GetTicks(), currentTime;
+    BenchmarkReport benchmark;
+    benchmark.backend = getGLBackendName(backend);
+    benchmark.width = 1280;
+    benchmark.height = 720;
+    benchmark.startupMilliseconds = elapsedMilliseconds(startupBegin, Clock::now());
+    benchmark.frameMilliseconds.reserve(benchmarkFrames);
+    uint64_t startupGLCalls = backend == GLBackend::Null ? getNullGLCallCount() : 0;
 
     bool running = true;
+    bool traceRequested = false;
     while (running) {
+        PROFILE_FRAME();
+        // The frames before this one are complete now. The write itself lands
+        // in this frame, ahead of its timing and allocation checks.
+        uint64_t profilerFrame = getProfilerFrame();
+        if (traceRequested) {
+            writeTrace(profilerFrame > TRACE_HOTKEY_FRAMES ? profilerFrame - TRACE_HOTKEY_FRAMES : 1, profilerFrame - 1);
+            traceRequested = false;
+        }
+        if (traceLastFrame > 0 && profilerFrame == traceLastFrame + 1) {
+            writeTrace(traceFirstFrame, traceLastFrame);
+        }
+        PROFILE_ZONE("Frame");
+
+        Uint64 frameStart = SDL_GetPerformanceCounter();
         currentTime = SDL_GetTicks();
-        float deltaTime = (currentTime - lastTime) / 1000.0f; 
+        // Start to start, so it includes the trace write and allocation checks
+        float deltaTime = float(double(frameStart - lastFrameStart) * counterMilliseconds / 1000.0);
+        lastFrameStart = frameStart;
+        if (benchmarkFrames > 0) {
+            // Fixed steps, so every run animates the same frames
+            deltaTime = 1.0f / 60.0f;
+        }
+        beginFrameArena();
+        uint64_t frameAllocations = getHeapAllocationCount();
+
+        FrameSample sample;
+        Uint64 phaseStart = frameStart;
+        auto endPhase = [&](FramePhase phase) {
+            Uint64 now = SDL_GetPerformanceCounter();
+            sample.phaseMilliseconds[size_t(phase)] = float(double(now - phaseStart) * counterMilliseconds);
+            phaseStart = now;
+        };
 
         SDL_Event event;
         while (SDL_PollEvent(&event)) {
-            getFrameEvents().push_back(event);
+            // Input over the overlay is not passed on to the camera
+            if (!handlePerfHudEvent(event)) {
+                getFrameEvents().push_back(event);
+            }
             switch (event.type) {
             case SDL_QUIT:
                 running = false;
                 break;
+            case SDL_KEYDOWN:
+                if (event.key.keysym.sym == SDLK_F9 && event.key.repeat == 0) {
+                    requestMemoryReport();
+                }
+                if (event.key.keysym.sym == SDLK_F10 && event.key.repeat == 0) {
+                    traceRequested = true;
+                }
+                break;
             }
         }
 
+        endPhase(FramePhase::Events);
+
+        // Finish streamed assets under the per-frame upload budget
+        processUploads(gLoader, gLoader.uploadBudget);
+        endPhase(FramePhase::Uploads);
+        updateShaders(gAssets);
+        updateScene(scene);
+        // Same projection renderScene uses
+        streamSceneTextures(scene, glm::radians(70.0f), 720.0f);
+        updateTextureStreaming(gAssets, gLoader);
+        collectAssets(gAssets);
+
         scene.camera->handleEvent(getFrameEvents(), deltaTime);
+        endPhase(FramePhase::Update);
 
+        beginGpuFrame();
         glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
         glViewport(0, 0, 1280, 720);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        renderScene(scene, deltaTime);
+        RenderStats renderStats = renderScene(scene, deltaTime);
+        endPhase(FramePhase::Render);
+
+        drawPerfHud(frameStats);
+        endPhase(FramePhase::Hud);
 
-        lastTime = currentTime;
         getFrameEvents().clear();
-        SDL_GL_SwapWindow(app.m_window);
+        endGpuFrame();
+        present(app);
+        endPhase(FramePhase::Present);
+
+        sample.milliseconds = float(double(phaseStart - frameStart) * counterMilliseconds);
+        sample.gpuMilliseconds = getGpuFrameMilliseconds();
+        sample.drawCalls = renderStats.drawCalls;
+        sample.triangles = renderStats.triangles;
+        addFrameSample(frameStats, sample);
+        if (!frameStatsPath.empty()) {
+            frameStatsRun.push_back(sample);
+        }
+
+        if (benchmarkFrames > 0) {
+            benchmark.frameMilliseconds.push_back(sample.milliseconds);
+            running = running && (int)benchmark.frameMilliseconds.size() < benchmarkFrames;
+        }
+
+        // Only counted in builds with ENGINE_TRACK_ALLOCATIONS, the count stays 0 otherwise
+        frameAllocations = getHeapAllocationCount() - frameAllocations;
+        if (++frameIndex > allocationWarmupFrames && frameAllocations > 0 && currentTime - lastAllocationWarning > 1000) {
+            spdlog::warn("Frame {} made {} heap allocations", frameIndex, frameAllocations);
+            lastAllocationWarning = currentTime;
+        }
+
+        // F9 or SIGUSR1, after the allocation check so the dump is not counted
+        if (takeMemoryReportRequest()) {
+            if (writeMemoryReport(MEMORY_REPORT_PATH)) {
+                spdlog::info("Memory report written to {}", MEMORY_REPORT_PATH);
+            }
+            else {
+                spdlog::error("Failed to write memory report {}", MEMORY_REPORT_PATH);
+            }
+        }
+    }
+
+    // A --frames run can end before the requested range does
+    if (traceLastFrame > 0 && getProfilerFrame() <= traceLastFrame && getProfilerFrame() >= traceFirstFrame) {
+        writeTrace(traceFirstFrame, getProfilerFrame());
+    }
+
+    if (benchmarkFrames > 0) {
+        if (backend == GLBackend::Null) {
+            // Per entry point counts include startup
+            uint64_t glCalls = getNullGLCallCount();
+            benchmark.counters.push_back({ "glCallsStartup", startupGLCalls });
+            benchmark.counters.push_back({ "glCallsFrames", glCalls - startupGLCalls });
+            for (const GLCallCount& call : getNullGLCallCounts()) {
+                benchmark.counters.push_back({ call.name, call.count });
+            }
+        }
+        if (writeBenchmarkReport(benchmarkReportPath, benchmark)) {
+            spdlog::info("Benchmark of {} frames written to {}", benchmark.frameMilliseconds.size(), benchmarkReportPath);
+        }
+        else {
+            spdlog::error("Failed to write benchmark report {}", benchmarkReportPath);
+        }
+    }
+
+    if (!frameStatsPath.empty()) {
+        if (writeFrameStats(frameStatsPath, frameStatsRun)) {
+            spdlog::info("Frame stats of {} frames written to {}", frameStatsRun.size(), frameStatsPath);
+        }
+        else {
+            spdlog::error("Failed to write frame stats {}", frameStatsPath);
+        }
     }
 
+    logAssetStats(gAssets);
+    unloadScene(scene);
+    stopAsyncLoader(gLoader);
+    gFileReads.stop();
+    gJobs.stop();
+    shutdownPerfHud();
+    shutdownGpuTimers();
+    shutdownTextureBinding();
+    shutdownTextureUploads();
     shutdown(app);
 
     return 0;